@@ -18,6 +18,7 @@
  */
 
 #include <sys/stat.h>			/* for stat() */
+#include <dirent.h>
 
 #include "repmgr.h"
 #include "configfile.h"
@@ -28,10 +29,65 @@ char		config_file_path[MAXPGPATH] = "";
 static bool config_file_provided = false;
 bool		config_file_found = false;
 
+/*
+ * Maximum nesting depth of "include", "include_if_exists" and "include_dir"
+ * directives (as in PostgreSQL)
+ */
+#define CONFIG_MAX_INCLUDE_DEPTH 10
+
+#define FNV1A_64_INIT UINT64CONST(14695981039346656037)
+#define FNV1A_64_PRIME UINT64CONST(1099511628211)
+
+/*
+ * Files and directories read while parsing the configuration, each with a
+ * hash of what was read from it (a file's contents, or the names of the
+ * files in a directory); this enables reload_config() to determine cheaply
+ * whether anything has changed.
+ *
+ * Each source is hashed separately, so the hash doesn't depend on where
+ * in the including file an "include" directive appears.
+ */
+typedef struct
+{
+	char		path[MAXPGPATH];
+	bool		is_directory;
+	bool		exists;
+	uint64		hash;
+} t_config_source;
+
+typedef struct
+{
+	t_config_source *sources;
+	int			source_count;
+	int			capacity;
+} t_config_source_list;
+
+#define T_CONFIG_SOURCE_LIST_INITIALIZER { NULL, 0, 0 }
+
+typedef enum
+{
+	PARSE_LINE_OK = 0,
+	PARSE_LINE_UNTERMINATED_QUOTE,
+	PARSE_LINE_TRAILING_CHARACTERS
+} ParseLineStatus;
+
+/* sources of the configuration currently in use */
+static t_config_source_list config_sources = T_CONFIG_SOURCE_LIST_INITIALIZER;
+
+/* sources read by the most recent call to _parse_config() */
+static t_config_source_list parsed_config_sources = T_CONFIG_SOURCE_LIST_INITIALIZER;
+
 static void parse_config(t_configuration_options *options, bool terse);
 static void _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *warning_list);
-
-static void _parse_line(char *buf, char *name, char *value);
+static void _parse_config_file(FILE *fp, const char *file_path, int source_index, int depth, t_configuration_options *options, ItemList *error_list, ItemList *warning_list, bool *node_id_found);
+static void _parse_config_include(const char *include_path, const char *including_file_path, bool missing_ok, int depth, t_configuration_options *options, ItemList *error_list, ItemList *warning_list, bool *node_id_found);
+static void _parse_config_include_file(const char *file_path, const char *including_file_path, bool missing_ok, int depth, t_configuration_options *options, ItemList *error_list, ItemList *warning_list, bool *node_id_found);
+static void _parse_config_include_dir(const char *include_dir, const char *including_file_path, int depth, t_configuration_options *options, ItemList *error_list, ItemList *warning_list, bool *node_id_found);
+static void resolve_include_path(const char *include_path, const char *including_file_path, char *resolved_path);
+static bool get_config_dir_files(const char *dir_path, char ***file_names, int *file_count);
+static void free_config_dir_files(char **file_names, int file_count);
+
+static ParseLineStatus _parse_line(char *buf, char *name, char *value);
 static void parse_event_notifications_list(t_configuration_options *options, const char *arg);
 static void clear_event_notification_list(t_configuration_options *options);
 
@@ -42,6 +98,11 @@ static void tablespace_list_append(t_configuration_options *options, const char
 
 static void exit_with_config_file_errors(ItemList *config_errors, ItemList *config_warnings, bool terse);
 
+static uint64 hash_config_bytes(uint64 hash, const char *data, size_t len);
+static int	append_config_source(t_config_source_list *list, const char *path, bool is_directory);
+static bool config_sources_changed(t_config_source_list *list);
+static void adopt_parsed_config_sources(void);
+
 
 void
 set_progname(const char *argv0)
@@ -251,6 +312,8 @@ parse_config(t_configuration_options *options, bool terse)
 		exit_with_config_file_errors(&config_errors, &config_warnings, terse);
 	}
 
+	adopt_parsed_config_sources();
+
 	if (terse == false && config_warnings.head != NULL)
 	{
 		log_warning(_("the following problems were found in the configuration file:"));
@@ -266,13 +329,13 @@ static void
 _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *warning_list)
 {
 	FILE	   *fp;
-	char	   *s = NULL,
-				buf[MAXLINELENGTH] = "";
-	char		name[MAXLEN] = "";
-	char		value[MAXLEN] = "";
+	int			source_index;
 
 	bool		node_id_found = false;
 
+	/* forget about any files read by a previous parse */
+	parsed_config_sources.source_count = 0;
+
 	/* Initialize configuration options with sensible defaults */
 
 	/*-----------------
@@ -328,6 +391,8 @@ _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *
 	 */
 	options->primary_follow_timeout = DEFAULT_PRIMARY_FOLLOW_TIMEOUT;
 	options->standby_follow_timeout = DEFAULT_STANDBY_FOLLOW_TIMEOUT;
+	options->sibling_nodes_follow_concurrency = DEFAULT_SIBLING_NODES_FOLLOW_CONCURRENCY;
+	options->sibling_nodes_follow_timeout = DEFAULT_SIBLING_NODES_FOLLOW_TIMEOUT;
 
 	/*------------------------
 	 * standby switchover settings
@@ -351,6 +416,12 @@ _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *
 	/* default to 6 reconnection attempts at intervals of 10 seconds */
 	options->reconnect_attempts = DEFAULT_RECONNECTION_ATTEMPTS;
 	options->reconnect_interval = DEFAULT_RECONNECTION_INTERVAL;
+	options->reconnect_backoff = RECONNECT_BACKOFF_FIXED;
+	options->reconnect_timeout_ms = DEFAULT_RECONNECT_TIMEOUT_MS;
+	options->reconnect_refused_attempts = DEFAULT_RECONNECT_REFUSED_ATTEMPTS;
+	options->connection_pool_idle_timeout = DEFAULT_CONNECTION_POOL_IDLE_TIMEOUT;
+	options->primary_heartbeat_interval_ms = DEFAULT_PRIMARY_HEARTBEAT_INTERVAL_MS;
+	options->primary_heartbeat_timeout_ms = DEFAULT_PRIMARY_HEARTBEAT_TIMEOUT_MS;
 	options->monitoring_history = false;	/* new in 4.0, replaces
 											 * --monitoring-history */
 	options->degraded_monitoring_timeout = -1;
@@ -360,8 +431,12 @@ _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *
 	memset(options->repmgrd_pid_file, 0, sizeof(options->repmgrd_pid_file));
 	options->standby_disconnect_on_failover = false;
 	options->sibling_nodes_disconnect_timeout = DEFAULT_SIBLING_NODES_DISCONNECT_TIMEOUT;
+	options->standby_disconnect_timeout = DEFAULT_STANDBY_DISCONNECT_TIMEOUT;
 	options->connection_check_type = CHECK_PING;
 	options->primary_visibility_consensus = false;
+	options->primary_visibility_consensus_quorum = DEFAULT_PRIMARY_VISIBILITY_CONSENSUS_QUORUM;
+	options->primary_visibility_consensus_timeout = DEFAULT_PRIMARY_VISIBILITY_CONSENSUS_TIMEOUT;
+	options->primary_visibility_threshold = DEFAULT_PRIMARY_VISIBILITY_THRESHOLD;
 	memset(options->failover_validation_command, 0, sizeof(options->failover_validation_command));
 	options->election_rerun_interval = DEFAULT_ELECTION_RERUN_INTERVAL;
 
@@ -468,27 +543,173 @@ _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *
 		exit(ERR_BAD_CONFIG);
 	}
 
+	source_index = append_config_source(&parsed_config_sources, config_file_path, false);
+
+	_parse_config_file(fp, config_file_path, source_index, 0, options, error_list, warning_list, &node_id_found);
+
+	fclose(fp);
+
+	/* check required parameters */
+	if (node_id_found == false)
+	{
+		item_list_append(error_list, _("\"node_id\": required parameter was not found"));
+	}
+
+	if (!strlen(options->node_name))
+	{
+		item_list_append(error_list, _("\"node_name\": required parameter was not found"));
+	}
+
+	if (!strlen(options->data_directory))
+	{
+		item_list_append(error_list, _("\"data_directory\": required parameter was not found"));
+	}
+
+	if (!strlen(options->conninfo))
+	{
+		item_list_append(error_list, _("\"conninfo\": required parameter was not found"));
+	}
+	else
+	{
+		/*
+		 * Sanity check the provided conninfo string
+		 *
+		 * NOTE: PQconninfoParse() verifies the string format and checks for
+		 * valid options but does not sanity check values
+		 */
+
+		PQconninfoOption *conninfo_options = NULL;
+		char	   *conninfo_errmsg = NULL;
+
+		conninfo_options = PQconninfoParse(options->conninfo, &conninfo_errmsg);
+		if (conninfo_options == NULL)
+		{
+			PQExpBufferData error_message_buf;
+			initPQExpBuffer(&error_message_buf);
+
+			appendPQExpBuffer(&error_message_buf,
+							  _("\"conninfo\": %s	(provided: \"%s\")"),
+							  conninfo_errmsg,
+							  options->conninfo);
+
+			item_list_append(error_list, error_message_buf.data);
+			termPQExpBuffer(&error_message_buf);
+		}
+
+		PQconninfoFree(conninfo_options);
+	}
+
+	/* set values for parameters which default to other parameters */
+
+	/*
+	 * From 4.1, "repmgrd_standby_startup_timeout" replaces "standby_reconnect_timeout"
+	 * in repmgrd; fall back to "standby_reconnect_timeout" if no value explicitly provided
+	 */
+	if (options->repmgrd_standby_startup_timeout == -1)
+	{
+		options->repmgrd_standby_startup_timeout = options->standby_reconnect_timeout;
+	}
+
+	/* add warning about changed "barman_" parameter meanings */
+	if ((options->barman_host[0] == '\0' && options->barman_server[0] != '\0') ||
+		(options->barman_host[0] != '\0' && options->barman_server[0] == '\0'))
+	{
+		item_list_append(error_list,
+						 _("use \"barman_host\" for the hostname of the Barman server"));
+		item_list_append(error_list,
+						 _("use \"barman_server\" for the name of the [server] section in the Barman configuration file"));
+
+	}
+
+	/* other sanity checks */
+
+	if (options->archive_ready_warning >= options->archive_ready_critical)
+	{
+		item_list_append(error_list,
+						 _("\"archive_ready_critical\" must be greater than  \"archive_ready_warning\""));
+	}
+
+	if (options->replication_lag_warning >= options->replication_lag_critical)
+	{
+		item_list_append(error_list,
+						 _("\"replication_lag_critical\" must be greater than  \"replication_lag_warning\""));
+	}
+
+	if (options->standby_reconnect_timeout < options->node_rejoin_timeout)
+	{
+		item_list_append(error_list,
+						 _("\"standby_reconnect_timeout\" must be equal to or greater than \"node_rejoin_timeout\""));
+	}
+}
+
+
+
+/*
+ * Parse a single configuration file, which the caller has opened, including
+ * any files referenced by "include", "include_if_exists" or "include_dir"
+ * directives.
+ */
+static void
+_parse_config_file(FILE *fp, const char *file_path, int source_index, int depth, t_configuration_options *options, ItemList *error_list, ItemList *warning_list, bool *node_id_found)
+{
+	char		buf[MAXLINELENGTH] = "";
+	char		name[MAXLEN] = "";
+	char		value[MAXLEN] = "";
+	int			line_number = 0;
+	uint64		hash = FNV1A_64_INIT;
+
 	/* Read file */
-	while ((s = fgets(buf, sizeof buf, fp)) != NULL)
+	while (fgets(buf, sizeof buf, fp) != NULL)
 	{
 		bool		known_parameter = true;
 
+		line_number++;
+
+		hash = hash_config_bytes(hash, buf, strlen(buf));
+
 		/* Parse name/value pair from line */
-		_parse_line(buf, name, value);
+		switch (_parse_line(buf, name, value))
+		{
+			case PARSE_LINE_OK:
+				break;
+			case PARSE_LINE_UNTERMINATED_QUOTE:
+				item_list_append_format(error_list,
+										_("unterminated quoted string in line %i of file \"%s\""),
+										line_number, file_path);
+				continue;
+			case PARSE_LINE_TRAILING_CHARACTERS:
+				item_list_append_format(error_list,
+										_("syntax error in line %i of file \"%s\": unexpected characters after quoted value for \"%s\""),
+										line_number, file_path, name);
+				continue;
+		}
 
-		/* Skip blank lines */
+		/* Skip blank lines and comments */
 		if (!strlen(name))
 			continue;
 
-		/* Skip comments */
-		if (name[0] == '#')
+		/* Process include directives */
+		if (strcmp(name, "include") == 0 || strcmp(name, "include_if_exists") == 0)
+		{
+			_parse_config_include(value, file_path,
+								  strcmp(name, "include_if_exists") == 0,
+								  depth + 1,
+								  options, error_list, warning_list, node_id_found);
 			continue;
+		}
+
+		if (strcmp(name, "include_dir") == 0)
+		{
+			_parse_config_include_dir(value, file_path, depth + 1,
+									  options, error_list, warning_list, node_id_found);
+			continue;
+		}
 
 		/* Copy into correct entry in parameters struct */
 		if (strcmp(name, "node_id") == 0)
 		{
 			options->node_id = repmgr_atoi(value, name, error_list, MIN_NODE_ID);
-			node_id_found = true;
+			*node_id_found = true;
 		}
 		else if (strcmp(name, "node_name") == 0)
 		{
@@ -578,6 +799,10 @@ _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *
 			options->primary_follow_timeout = repmgr_atoi(value, name, error_list, 0);
 		else if (strcmp(name, "standby_follow_timeout") == 0)
 			options->standby_follow_timeout = repmgr_atoi(value, name, error_list, 0);
+		else if (strcmp(name, "sibling_nodes_follow_concurrency") == 0)
+			options->sibling_nodes_follow_concurrency = repmgr_atoi(value, name, error_list, 1);
+		else if (strcmp(name, "sibling_nodes_follow_timeout") == 0)
+			options->sibling_nodes_follow_timeout = repmgr_atoi(value, name, error_list, 1);
 
 		/* standby switchover settings */
 		else if (strcmp(name, "shutdown_check_timeout") == 0)
@@ -630,6 +855,32 @@ _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *
 			options->reconnect_attempts = repmgr_atoi(value, name, error_list, 0);
 		else if (strcmp(name, "reconnect_interval") == 0)
 			options->reconnect_interval = repmgr_atoi(value, name, error_list, 0);
+		else if (strcmp(name, "reconnect_backoff") == 0)
+		{
+			if (strcasecmp(value, "fixed") == 0)
+			{
+				options->reconnect_backoff = RECONNECT_BACKOFF_FIXED;
+			}
+			else if (strcasecmp(value, "exponential") == 0)
+			{
+				options->reconnect_backoff = RECONNECT_BACKOFF_EXPONENTIAL;
+			}
+			else
+			{
+				item_list_append(error_list,
+								 _("value for \"reconnect_backoff\" must be \"fixed\" or \"exponential\"\n"));
+			}
+		}
+		else if (strcmp(name, "reconnect_timeout_ms") == 0)
+			options->reconnect_timeout_ms = repmgr_atoi(value, name, error_list, -1);
+		else if (strcmp(name, "reconnect_refused_attempts") == 0)
+			options->reconnect_refused_attempts = repmgr_atoi(value, name, error_list, -1);
+		else if (strcmp(name, "connection_pool_idle_timeout") == 0)
+			options->connection_pool_idle_timeout = repmgr_atoi(value, name, error_list, 0);
+		else if (strcmp(name, "primary_heartbeat_interval_ms") == 0)
+			options->primary_heartbeat_interval_ms = repmgr_atoi(value, name, error_list, 0);
+		else if (strcmp(name, "primary_heartbeat_timeout_ms") == 0)
+			options->primary_heartbeat_timeout_ms = repmgr_atoi(value, name, error_list, -1);
 		else if (strcmp(name, "monitor_interval_secs") == 0)
 			options->monitor_interval_secs = repmgr_atoi(value, name, error_list, 1);
 		else if (strcmp(name, "monitoring_history") == 0)
@@ -648,6 +899,8 @@ _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *
 			options->standby_disconnect_on_failover = parse_bool(value, name, error_list);
 		else if (strcmp(name, "sibling_nodes_disconnect_timeout") == 0)
 			options->sibling_nodes_disconnect_timeout = repmgr_atoi(value, name, error_list, 0);
+		else if (strcmp(name, "standby_disconnect_timeout") == 0)
+			options->standby_disconnect_timeout = repmgr_atoi(value, name, error_list, 1);
 		else if (strcmp(name, "connection_check_type") == 0)
 		{
 			if (strcasecmp(value, "ping") == 0)
@@ -670,6 +923,12 @@ _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *
 		}
 		else if (strcmp(name, "primary_visibility_consensus") == 0)
 			options->primary_visibility_consensus = parse_bool(value, name, error_list);
+		else if (strcmp(name, "primary_visibility_consensus_quorum") == 0)
+			options->primary_visibility_consensus_quorum = repmgr_atoi(value, name, error_list, 1);
+		else if (strcmp(name, "primary_visibility_consensus_timeout") == 0)
+			options->primary_visibility_consensus_timeout = repmgr_atoi(value, name, error_list, 1);
+		else if (strcmp(name, "primary_visibility_threshold") == 0)
+			options->primary_visibility_threshold = repmgr_atoi(value, name, error_list, -1);
 		else if (strcmp(name, "failover_validation_command") == 0)
 			strncpy(options->failover_validation_command, value, sizeof(options->failover_validation_command));
 		else if (strcmp(name, "election_rerun_interval") == 0)
@@ -823,99 +1082,214 @@ _parse_config(t_configuration_options *options, ItemList *error_list, ItemList *
 		}
 	}
 
-	fclose(fp);
+	parsed_config_sources.sources[source_index].hash = hash;
+}
 
-	/* check required parameters */
-	if (node_id_found == false)
-	{
-		item_list_append(error_list, _("\"node_id\": required parameter was not found"));
-	}
 
-	if (!strlen(options->node_name))
-	{
-		item_list_append(error_list, _("\"node_name\": required parameter was not found"));
-	}
+static void
+_parse_config_include(const char *include_path, const char *including_file_path, bool missing_ok, int depth, t_configuration_options *options, ItemList *error_list, ItemList *warning_list, bool *node_id_found)
+{
+	char		resolved_path[MAXPGPATH] = "";
 
-	if (!strlen(options->data_directory))
+	resolve_include_path(include_path, including_file_path, resolved_path);
+
+	_parse_config_include_file(resolved_path, including_file_path, missing_ok, depth,
+							   options, error_list, warning_list, node_id_found);
+}
+
+
+/*
+ * Parse an included file; "file_path" has already been resolved.
+ */
+static void
+_parse_config_include_file(const char *file_path, const char *including_file_path, bool missing_ok, int depth, t_configuration_options *options, ItemList *error_list, ItemList *warning_list, bool *node_id_found)
+{
+	FILE	   *fp;
+	int			source_index;
+
+	if (depth > CONFIG_MAX_INCLUDE_DEPTH)
 	{
-		item_list_append(error_list, _("\"data_directory\": required parameter was not found"));
+		item_list_append_format(error_list,
+								_("could not open configuration file \"%s\": maximum nesting depth exceeded"),
+								file_path);
+		return;
 	}
 
-	if (!strlen(options->conninfo))
+	source_index = append_config_source(&parsed_config_sources, file_path, false);
+
+	fp = fopen(file_path, "r");
+
+	if (fp == NULL)
 	{
-		item_list_append(error_list, _("\"conninfo\": required parameter was not found"));
+		if (missing_ok == true && errno == ENOENT)
+		{
+			log_debug("skipping missing configuration file \"%s\"", file_path);
+			parsed_config_sources.sources[source_index].exists = false;
+			return;
+		}
+
+		item_list_append_format(error_list,
+								_("could not open configuration file \"%s\" included from \"%s\": %s"),
+								file_path, including_file_path, strerror(errno));
+		return;
 	}
-	else
-	{
-		/*
-		 * Sanity check the provided conninfo string
-		 *
-		 * NOTE: PQconninfoParse() verifies the string format and checks for
-		 * valid options but does not sanity check values
-		 */
 
-		PQconninfoOption *conninfo_options = NULL;
-		char	   *conninfo_errmsg = NULL;
+	log_debug("parsing included configuration file \"%s\"", file_path);
 
-		conninfo_options = PQconninfoParse(options->conninfo, &conninfo_errmsg);
-		if (conninfo_options == NULL)
-		{
-			PQExpBufferData error_message_buf;
-			initPQExpBuffer(&error_message_buf);
+	_parse_config_file(fp, file_path, source_index, depth, options, error_list, warning_list, node_id_found);
 
-			appendPQExpBuffer(&error_message_buf,
-							  _("\"conninfo\": %s	(provided: \"%s\")"),
-							  conninfo_errmsg,
-							  options->conninfo);
+	fclose(fp);
+}
 
-			item_list_append(error_list, error_message_buf.data);
-			termPQExpBuffer(&error_message_buf);
-		}
 
-		PQconninfoFree(conninfo_options);
+/*
+ * Parse all files with the suffix ".conf" in the specified directory,
+ * in file name order; files whose names begin with "." are ignored.
+ */
+static void
+_parse_config_include_dir(const char *include_dir, const char *including_file_path, int depth, t_configuration_options *options, ItemList *error_list, ItemList *warning_list, bool *node_id_found)
+{
+	char		resolved_path[MAXPGPATH] = "";
+	char	  **file_names = NULL;
+	int			file_count = 0;
+	int			source_index;
+	uint64		hash = FNV1A_64_INIT;
+	int			i;
+
+	if (depth > CONFIG_MAX_INCLUDE_DEPTH)
+	{
+		item_list_append_format(error_list,
+								_("could not open configuration directory \"%s\": maximum nesting depth exceeded"),
+								include_dir);
+		return;
 	}
 
-	/* set values for parameters which default to other parameters */
+	resolve_include_path(include_dir, including_file_path, resolved_path);
 
-	/*
-	 * From 4.1, "repmgrd_standby_startup_timeout" replaces "standby_reconnect_timeout"
-	 * in repmgrd; fall back to "standby_reconnect_timeout" if no value explicitly provided
-	 */
-	if (options->repmgrd_standby_startup_timeout == -1)
+	source_index = append_config_source(&parsed_config_sources, resolved_path, true);
+
+	if (get_config_dir_files(resolved_path, &file_names, &file_count) == false)
 	{
-		options->repmgrd_standby_startup_timeout = options->standby_reconnect_timeout;
+		item_list_append_format(error_list,
+								_("could not open configuration directory \"%s\" included from \"%s\": %s"),
+								resolved_path, including_file_path, strerror(errno));
+		return;
 	}
 
-	/* add warning about changed "barman_" parameter meanings */
-	if ((options->barman_host[0] == '\0' && options->barman_server[0] != '\0') ||
-		(options->barman_host[0] != '\0' && options->barman_server[0] == '\0'))
+	for (i = 0; i < file_count; i++)
+		hash = hash_config_bytes(hash, file_names[i], strlen(file_names[i]) + 1);
+
+	parsed_config_sources.sources[source_index].hash = hash;
+
+	for (i = 0; i < file_count; i++)
 	{
-		item_list_append(error_list,
-						 _("use \"barman_host\" for the hostname of the Barman server"));
-		item_list_append(error_list,
-						 _("use \"barman_server\" for the name of the [server] section in the Barman configuration file"));
+		char		file_path[MAXPGPATH] = "";
+
+		snprintf(file_path, MAXPGPATH, "%s/%s", resolved_path, file_names[i]);
 
+		/* the path is already resolved, so must not be resolved again */
+		_parse_config_include_file(file_path, including_file_path, false, depth,
+								   options, error_list, warning_list, node_id_found);
 	}
 
-	/* other sanity checks */
+	free_config_dir_files(file_names, file_count);
+}
 
-	if (options->archive_ready_warning >= options->archive_ready_critical)
+
+/*
+ * Relative include paths are interpreted relative to the directory
+ * containing the file with the include directive.
+ */
+static void
+resolve_include_path(const char *include_path, const char *including_file_path, char *resolved_path)
+{
+	if (is_absolute_path(include_path))
 	{
-		item_list_append(error_list,
-						 _("\"archive_ready_critical\" must be greater than  \"archive_ready_warning\""));
+		strncpy(resolved_path, include_path, MAXPGPATH);
 	}
-
-	if (options->replication_lag_warning >= options->replication_lag_critical)
+	else
 	{
-		item_list_append(error_list,
-						 _("\"replication_lag_critical\" must be greater than  \"replication_lag_warning\""));
+		char		including_dir[MAXPGPATH] = "";
+
+		strncpy(including_dir, including_file_path, MAXPGPATH);
+		get_parent_directory(including_dir);
+
+		if (including_dir[0] == '\0')
+			strncpy(resolved_path, include_path, MAXPGPATH);
+		else
+			snprintf(resolved_path, MAXPGPATH, "%s/%s", including_dir, include_path);
 	}
 
-	if (options->standby_reconnect_timeout < options->node_rejoin_timeout)
+	canonicalize_path(resolved_path);
+}
+
+
+static int
+compare_config_file_names(const void *a, const void *b)
+{
+	return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+
+/*
+ * Return the names of configuration files in the specified directory,
+ * sorted by name; returns false (with errno set) if the directory
+ * could not be read.
+ */
+static bool
+get_config_dir_files(const char *dir_path, char ***file_names, int *file_count)
+{
+	DIR		   *dir;
+	struct dirent *dir_ent;
+	int			capacity = 16;
+
+	*file_names = NULL;
+	*file_count = 0;
+
+	dir = opendir(dir_path);
+
+	if (dir == NULL)
+		return false;
+
+	*file_names = pg_malloc(sizeof(char *) * capacity);
+
+	while ((dir_ent = readdir(dir)) != NULL)
 	{
-		item_list_append(error_list,
-						 _("\"standby_reconnect_timeout\" must be equal to or greater than \"node_rejoin_timeout\""));
+		size_t		name_len = strlen(dir_ent->d_name);
+
+		if (dir_ent->d_name[0] == '.')
+			continue;
+
+		if (name_len < 6 || strcmp(dir_ent->d_name + name_len - 5, ".conf") != 0)
+			continue;
+
+		if (*file_count == capacity)
+		{
+			capacity *= 2;
+			*file_names = pg_realloc(*file_names, sizeof(char *) * capacity);
+		}
+
+		(*file_names)[(*file_count)++] = pg_strdup(dir_ent->d_name);
 	}
+
+	closedir(dir);
+
+	qsort(*file_names, *file_count, sizeof(char *), compare_config_file_names);
+
+	return true;
+}
+
+
+static void
+free_config_dir_files(char **file_names, int file_count)
+{
+	int			i;
+
+	for (i = 0; i < file_count; i++)
+		pfree(file_names[i]);
+
+	if (file_names != NULL)
+		pfree(file_names);
 }
 
 
@@ -948,7 +1322,7 @@ parse_recovery_conf(const char *data_dir, t_recovery_conf *conf)
 	{
 
 		/* Parse name/value pair from line */
-		_parse_line(buf, name, value);
+		(void) _parse_line(buf, name, value);
 
 		/* Skip blank lines */
 		if (!strlen(name))
@@ -1015,62 +1389,115 @@ parse_recovery_conf(const char *data_dir, t_recovery_conf *conf)
 }
 
 
-void
+/*
+ * Split a configuration file line into parameter name and value in a
+ * single pass.
+ *
+ * As in postgresql.conf, the "=" between name and value is optional. A
+ * value enclosed in single quotes may contain whitespace and "#", and a
+ * single quote within it is written as two single quotes; an unquoted value
+ * extends to the end of the line or the start of a comment.
+ *
+ * "name" is set to an empty string if the line is blank or a comment.
+ * Returns PARSE_LINE_UNTERMINATED_QUOTE if a quoted value is not terminated,
+ * and PARSE_LINE_TRAILING_CHARACTERS if anything other than whitespace or
+ * a comment follows a quoted value.
+ */
+static ParseLineStatus
 _parse_line(char *buf, char *name, char *value)
 {
-	int			i = 0;
+	char	   *p = buf;
 	int			j = 0;
 
+	name[0] = '\0';
+	value[0] = '\0';
+
+	while (*p == ' ' || *p == '\t')
+		p++;
+
+	/* blank line or comment */
+	if (*p == '\0' || *p == '\n' || *p == '\r' || *p == '#')
+		return PARSE_LINE_OK;
+
 	/*
-	 * Extract parameter name, if present
+	 * Extract parameter name
 	 */
-	for (; i < MAXLEN; ++i)
+	while (*p != '\0' && *p != '=' && *p != ' ' && *p != '\t'
+		   && *p != '\n' && *p != '\r' && *p != '#' && *p != '\'')
 	{
-		if (buf[i] == '=')
-			break;
-
-		switch (buf[i])
-		{
-				/* Ignore whitespace */
-			case ' ':
-			case '\n':
-			case '\r':
-			case '\t':
-				continue;
-			default:
-				name[j++] = buf[i];
-		}
+		if (j < MAXLEN - 1)
+			name[j++] = *p;
+		p++;
 	}
 	name[j] = '\0';
 
 	/*
-	 * Ignore any whitespace following the '=' sign
+	 * Skip the (optional) "=" and any surrounding whitespace
 	 */
-	for (; i < MAXLEN; ++i)
+	while (*p == ' ' || *p == '\t')
+		p++;
+
+	if (*p == '=')
 	{
-		if (buf[i + 1] == ' ')
-			continue;
-		if (buf[i + 1] == '\t')
-			continue;
+		p++;
 
-		break;
+		while (*p == ' ' || *p == '\t')
+			p++;
 	}
 
 	/*
 	 * Extract parameter value
 	 */
 	j = 0;
-	for (++i; i < MAXLEN; ++i)
-		if (buf[i] == '\'')
+
+	if (*p == '\'')
+	{
+		for (p++;; p++)
+		{
+			if (*p == '\0' || *p == '\n' || *p == '\r')
+			{
+				value[j] = '\0';
+				return PARSE_LINE_UNTERMINATED_QUOTE;
+			}
+
+			if (*p == '\'')
+			{
+				/* two single quotes represent one literal single quote */
+				if (p[1] != '\'')
+					break;
+				p++;
+			}
+
+			if (j < MAXLEN - 1)
+				value[j++] = *p;
+		}
+
+		value[j] = '\0';
+
+		/* only whitespace or a comment may follow the closing quote */
+		for (p++; *p == ' ' || *p == '\t'; p++)
+			;
+
+		if (*p != '\0' && *p != '\n' && *p != '\r' && *p != '#')
+			return PARSE_LINE_TRAILING_CHARACTERS;
+
+		return PARSE_LINE_OK;
+	}
+
+	for (; *p != '\0' && *p != '\n' && *p != '\r' && *p != '#'; p++)
+	{
+		/* stray single quotes in unquoted values have always been ignored */
+		if (*p == '\'')
 			continue;
-		else if (buf[i] == '#')
-			break;
-		else if (buf[i] != '\n')
-			value[j++] = buf[i];
-		else
-			break;
+
+		if (j < MAXLEN - 1)
+			value[j++] = *p;
+	}
 	value[j] = '\0';
+
 	trim(value);
+
+	return PARSE_LINE_OK;
 }
 
 
@@ -1142,17 +1569,29 @@ parse_time_unit_parameter(const char *name, const char *value, char *dest, ItemL
  * - log_file
  * - log_level
  * - log_status_interval
+ * - connection_pool_idle_timeout
  * - monitor_interval_secs
  * - monitoring_history
+ * - primary_heartbeat_interval_ms
+ * - primary_heartbeat_timeout_ms
  * - primary_notification_timeout
  * - primary_visibility_consensus
+ * - primary_visibility_consensus_quorum
+ * - primary_visibility_consensus_timeout
+ * - primary_visibility_threshold
  * - promote_command
  * - reconnect_attempts
+ * - reconnect_backoff
  * - reconnect_interval
+ * - reconnect_refused_attempts
+ * - reconnect_timeout_ms
  * - repmgrd_standby_startup_timeout
  * - retry_promote_interval_secs
  * - sibling_nodes_disconnect_timeout
+ * - sibling_nodes_follow_concurrency
+ * - sibling_nodes_follow_timeout
  * - standby_disconnect_on_failover
+ * - standby_disconnect_timeout
  *
  *
  * Not publicly documented:
@@ -1172,19 +1611,33 @@ parse_time_unit_parameter(const char *name, const char *value, char *dest, ItemL
  *	 grep config_file_options\\. repmgrd*.c | perl -n -e '/config_file_options\.([\w_]+)/ && print qq|$1\n|;' | sort | uniq
 
  */
-bool
+int
 reload_config(t_configuration_options *orig_options, t_server_type server_type)
 {
 	PGconn	   *conn;
 	t_configuration_options new_options = T_CONFIGURATION_OPTIONS_INITIALIZER;
 	bool		config_changed = false;
 	bool		log_config_changed = false;
+	bool		connection_changed = false;
+	bool		notifications_changed = false;
 
 	static ItemList config_errors = {NULL, NULL};
 	static ItemList config_warnings = {NULL, NULL};
 
 	PQExpBufferData errors;
 
+	/*
+	 * If the configuration file, and any files it includes, are byte-for-byte
+	 * identical to those last parsed, there's nothing to do; this avoids
+	 * reparsing and comparing every option when SIGHUP is sent routinely
+	 * (e.g. by log rotation or configuration management tools).
+	 */
+	if (config_sources_changed(&config_sources) == false)
+	{
+		log_info(_("configuration file has not changed"));
+		return CONFIG_RELOAD_UNCHANGED;
+	}
+
 	log_info(_("reloading configuration file"));
 
 	_parse_config(&new_options, &config_errors, &config_warnings);
@@ -1222,7 +1675,8 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 
 		log_detail("%s", errors.data);
 		termPQExpBuffer(&errors);
-		return false;
+		clear_event_notification_list(&new_options);
+		return CONFIG_RELOAD_UNCHANGED;
 	}
 
 
@@ -1232,13 +1686,15 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 	if (new_options.node_id != orig_options->node_id)
 	{
 		log_warning(_("\"node_id\" cannot be changed, retaining current configuration"));
-		return false;
+		clear_event_notification_list(&new_options);
+		return CONFIG_RELOAD_UNCHANGED;
 	}
 
 	if (strncmp(new_options.node_name, orig_options->node_name, sizeof(orig_options->node_name)) != 0)
 	{
 		log_warning(_("\"node_name\" cannot be changed, keeping current configuration"));
-		return false;
+		clear_event_notification_list(&new_options);
+		return CONFIG_RELOAD_UNCHANGED;
 	}
 
 	/*
@@ -1378,11 +1834,11 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 			snprintf(orig_options->conninfo, sizeof(orig_options->conninfo),
 					 "%s", new_options.conninfo);
 			log_info(_("\"conninfo\" is now \"%s\""), new_options.conninfo);
+
+			connection_changed = true;
 		}
 
 		PQfinish(conn);
-
-		config_changed = true;
 	}
 
 	/* degraded_monitoring_timeout */
@@ -1401,7 +1857,7 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 				 "%s", new_options.event_notification_command);
 		log_info(_("\"event_notification_command\" is now \"%s\""), new_options.event_notification_command);
 
-		config_changed = true;
+		notifications_changed = true;
 	}
 
 	/* event_notifications */
@@ -1414,7 +1870,11 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 		clear_event_notification_list(orig_options);
 		orig_options->event_notifications = new_options.event_notifications;
 
-		config_changed = true;
+		notifications_changed = true;
+	}
+	else
+	{
+		clear_event_notification_list(&new_options);
 	}
 
 	/* failover */
@@ -1499,6 +1959,61 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 		config_changed = true;
 	}
 
+	/* reconnect_backoff */
+	if (orig_options->reconnect_backoff != new_options.reconnect_backoff)
+	{
+		orig_options->reconnect_backoff = new_options.reconnect_backoff;
+		log_info(_("\"reconnect_backoff\" is now \"%s\""),
+				 print_reconnect_backoff_type(new_options.reconnect_backoff));
+
+		config_changed = true;
+	}
+
+	/* reconnect_timeout_ms */
+	if (orig_options->reconnect_timeout_ms != new_options.reconnect_timeout_ms)
+	{
+		orig_options->reconnect_timeout_ms = new_options.reconnect_timeout_ms;
+		log_info(_("\"reconnect_timeout_ms\" is now \"%i\""), new_options.reconnect_timeout_ms);
+
+		config_changed = true;
+	}
+
+	/* reconnect_refused_attempts */
+	if (orig_options->reconnect_refused_attempts != new_options.reconnect_refused_attempts)
+	{
+		orig_options->reconnect_refused_attempts = new_options.reconnect_refused_attempts;
+		log_info(_("\"reconnect_refused_attempts\" is now \"%i\""), new_options.reconnect_refused_attempts);
+
+		config_changed = true;
+	}
+
+	/* connection_pool_idle_timeout */
+	if (orig_options->connection_pool_idle_timeout != new_options.connection_pool_idle_timeout)
+	{
+		orig_options->connection_pool_idle_timeout = new_options.connection_pool_idle_timeout;
+		log_info(_("\"connection_pool_idle_timeout\" is now \"%i\""), new_options.connection_pool_idle_timeout);
+
+		config_changed = true;
+	}
+
+	/* primary_heartbeat_interval_ms */
+	if (orig_options->primary_heartbeat_interval_ms != new_options.primary_heartbeat_interval_ms)
+	{
+		orig_options->primary_heartbeat_interval_ms = new_options.primary_heartbeat_interval_ms;
+		log_info(_("\"primary_heartbeat_interval_ms\" is now \"%i\""), new_options.primary_heartbeat_interval_ms);
+
+		config_changed = true;
+	}
+
+	/* primary_heartbeat_timeout_ms */
+	if (orig_options->primary_heartbeat_timeout_ms != new_options.primary_heartbeat_timeout_ms)
+	{
+		orig_options->primary_heartbeat_timeout_ms = new_options.primary_heartbeat_timeout_ms;
+		log_info(_("\"primary_heartbeat_timeout_ms\" is now \"%i\""), new_options.primary_heartbeat_timeout_ms);
+
+		config_changed = true;
+	}
+
 	/* repmgrd_standby_startup_timeout */
 	if (orig_options->repmgrd_standby_startup_timeout != new_options.repmgrd_standby_startup_timeout)
 	{
@@ -1526,6 +2041,33 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 		config_changed = true;
 	}
 
+	/* standby_disconnect_timeout */
+	if (orig_options->standby_disconnect_timeout != new_options.standby_disconnect_timeout)
+	{
+		orig_options->standby_disconnect_timeout = new_options.standby_disconnect_timeout;
+		log_info(_("\"standby_disconnect_timeout\" is now \"%i\""),
+				 new_options.standby_disconnect_timeout);
+		config_changed = true;
+	}
+
+	/* sibling_nodes_follow_concurrency */
+	if (orig_options->sibling_nodes_follow_concurrency != new_options.sibling_nodes_follow_concurrency)
+	{
+		orig_options->sibling_nodes_follow_concurrency = new_options.sibling_nodes_follow_concurrency;
+		log_info(_("\"sibling_nodes_follow_concurrency\" is now \"%i\""),
+				 new_options.sibling_nodes_follow_concurrency);
+		config_changed = true;
+	}
+
+	/* sibling_nodes_follow_timeout */
+	if (orig_options->sibling_nodes_follow_timeout != new_options.sibling_nodes_follow_timeout)
+	{
+		orig_options->sibling_nodes_follow_timeout = new_options.sibling_nodes_follow_timeout;
+		log_info(_("\"sibling_nodes_follow_timeout\" is now \"%i\""),
+				 new_options.sibling_nodes_follow_timeout);
+		config_changed = true;
+	}
+
 	/* connection_check_type */
 	if (orig_options->connection_check_type != new_options.connection_check_type)
 	{
@@ -1544,6 +2086,33 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 		config_changed = true;
 	}
 
+	/* primary_visibility_consensus_quorum */
+	if (orig_options->primary_visibility_consensus_quorum != new_options.primary_visibility_consensus_quorum)
+	{
+		orig_options->primary_visibility_consensus_quorum = new_options.primary_visibility_consensus_quorum;
+		log_info(_("\"primary_visibility_consensus_quorum\" is now \"%i\""),
+				 new_options.primary_visibility_consensus_quorum);
+		config_changed = true;
+	}
+
+	/* primary_visibility_consensus_timeout */
+	if (orig_options->primary_visibility_consensus_timeout != new_options.primary_visibility_consensus_timeout)
+	{
+		orig_options->primary_visibility_consensus_timeout = new_options.primary_visibility_consensus_timeout;
+		log_info(_("\"primary_visibility_consensus_timeout\" is now \"%i\""),
+				 new_options.primary_visibility_consensus_timeout);
+		config_changed = true;
+	}
+
+	/* primary_visibility_threshold */
+	if (orig_options->primary_visibility_threshold != new_options.primary_visibility_threshold)
+	{
+		orig_options->primary_visibility_threshold = new_options.primary_visibility_threshold;
+		log_info(_("\"primary_visibility_threshold\" is now \"%i\""),
+				 new_options.primary_visibility_threshold);
+		config_changed = true;
+	}
+
 	/* failover_validation_command */
 	if (strncmp(orig_options->failover_validation_command, new_options.failover_validation_command, sizeof(orig_options->failover_validation_command)) != 0)
 	{
@@ -1607,7 +2176,7 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 		log_notice(_("configuration file reloaded with changed parameters"));
 	}
 
-	if (config_changed == true)
+	if (config_changed == true || connection_changed == true || notifications_changed == true)
 	{
 		log_info(_("configuration has changed"));
 	}
@@ -1615,12 +2184,153 @@ reload_config(t_configuration_options *orig_options, t_server_type server_type)
 	/*
 	 * neither logging nor other configuration has changed
 	 */
-	if (log_config_changed == false && config_changed == false)
+	if (log_config_changed == false && config_changed == false
+		&& connection_changed == false && notifications_changed == false)
 	{
 		log_info(_("configuration has not changed"));
 	}
 
-	return config_changed;
+	/* the new configuration has been applied, so skip it next time if unchanged */
+	adopt_parsed_config_sources();
+
+	return (connection_changed ? CONFIG_RELOAD_CONNECTION : 0)
+		| (log_config_changed ? CONFIG_RELOAD_LOGGING : 0)
+		| (notifications_changed ? CONFIG_RELOAD_NOTIFICATIONS : 0)
+		| (config_changed ? CONFIG_RELOAD_OTHER : 0);
+}
+
+
+static uint64
+hash_config_bytes(uint64 hash, const char *data, size_t len)
+{
+	size_t		i;
+
+	/* 64-bit FNV-1a */
+	for (i = 0; i < len; i++)
+	{
+		hash ^= (uint64) (unsigned char) data[i];
+		hash *= FNV1A_64_PRIME;
+	}
+
+	return hash;
+}
+
+
+/*
+ * Add a file or directory to the list of configuration sources, returning
+ * its index; the caller sets its hash once it has been read.
+ */
+static int
+append_config_source(t_config_source_list *list, const char *path, bool is_directory)
+{
+	if (list->source_count == list->capacity)
+	{
+		list->capacity = list->capacity == 0 ? 8 : list->capacity * 2;
+
+		if (list->sources == NULL)
+			list->sources = pg_malloc(sizeof(t_config_source) * list->capacity);
+		else
+			list->sources = pg_realloc(list->sources, sizeof(t_config_source) * list->capacity);
+	}
+
+	strncpy(list->sources[list->source_count].path, path, MAXPGPATH);
+	list->sources[list->source_count].is_directory = is_directory;
+	list->sources[list->source_count].exists = true;
+	list->sources[list->source_count].hash = FNV1A_64_INIT;
+
+	return list->source_count++;
+}
+
+
+/*
+ * Rehash each of the specified configuration sources and compare it with
+ * the hash recorded when it was parsed; returns true if any source has
+ * changed or could not be read, in which case the configuration must be
+ * reparsed.
+ */
+static bool
+config_sources_changed(t_config_source_list *list)
+{
+	int			i;
+
+	if (list->source_count == 0)
+		return true;
+
+	for (i = 0; i < list->source_count; i++)
+	{
+		t_config_source *source = &list->sources[i];
+		uint64		hash = FNV1A_64_INIT;
+
+		if (source->is_directory == true)
+		{
+			char	  **file_names = NULL;
+			int			file_count = 0;
+			int			j;
+
+			if (get_config_dir_files(source->path, &file_names, &file_count) == false)
+				return true;
+
+			for (j = 0; j < file_count; j++)
+				hash = hash_config_bytes(hash, file_names[j], strlen(file_names[j]) + 1);
+
+			free_config_dir_files(file_names, file_count);
+		}
+		else
+		{
+			FILE	   *fp;
+			char		buf[8192];
+			size_t		nread;
+
+			fp = fopen(source->path, "r");
+
+			if (fp == NULL)
+			{
+				/* a file named by "include_if_exists" may legitimately be missing */
+				if (errno == ENOENT && source->exists == false)
+					continue;
+
+				return true;
+			}
+
+			if (source->exists == false)
+			{
+				fclose(fp);
+				return true;
+			}
+
+			while ((nread = fread(buf, 1, sizeof(buf), fp)) > 0)
+				hash = hash_config_bytes(hash, buf, nread);
+
+			if (ferror(fp))
+			{
+				fclose(fp);
+				return true;
+			}
+
+			fclose(fp);
+		}
+
+		if (hash != source->hash)
+			return true;
+	}
+
+	return false;
+}
+
+
+/*
+ * Called once a newly parsed configuration has been accepted.
+ */
+static void
+adopt_parsed_config_sources(void)
+{
+	t_config_source_list previous = config_sources;
+
+	config_sources = parsed_config_sources;
+
+	/* reuse the previous list's storage for the next parse */
+	parsed_config_sources = previous;
+	parsed_config_sources.source_count = 0;
 }
 
 
@@ -2175,3 +2885,19 @@ print_connection_check_type(ConnectionCheckType type)
 	/* should never reach here */
 	return "UNKNOWN";
 }
+
+
+const char *
+print_reconnect_backoff_type(ReconnectBackoffType type)
+{
+	switch (type)
+	{
+		case RECONNECT_BACKOFF_FIXED:
+			return "fixed";
+		case RECONNECT_BACKOFF_EXPONENTIAL:
+			return "exponential";
+	}
+
+	/* should never reach here */
+	return "UNKNOWN";
+}
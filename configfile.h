@@ -44,6 +44,12 @@ typedef enum
 	CHECK_CONNECTION
 } ConnectionCheckType;
 
+typedef enum
+{
+	RECONNECT_BACKOFF_FIXED,
+	RECONNECT_BACKOFF_EXPONENTIAL
+} ReconnectBackoffType;
+
 typedef struct EventNotificationListCell
 {
 	struct EventNotificationListCell *next;
@@ -109,6 +115,8 @@ typedef struct
 	/* standby follow settings */
 	int			primary_follow_timeout;
 	int			standby_follow_timeout;
+	int			sibling_nodes_follow_concurrency;
+	int			sibling_nodes_follow_timeout;
 
 	/* standby switchover settings */
 	int			shutdown_check_timeout;
@@ -136,6 +144,12 @@ typedef struct
 	int			monitor_interval_secs;
 	int			reconnect_attempts;
 	int			reconnect_interval;
+	ReconnectBackoffType reconnect_backoff;
+	int			reconnect_timeout_ms;
+	int			reconnect_refused_attempts;
+	int			connection_pool_idle_timeout;
+	int			primary_heartbeat_interval_ms;
+	int			primary_heartbeat_timeout_ms;
 	bool		monitoring_history;
 	int			degraded_monitoring_timeout;
 	int			async_query_timeout;
@@ -144,8 +158,12 @@ typedef struct
 	char		repmgrd_pid_file[MAXPGPATH];
 	bool		standby_disconnect_on_failover;
 	int			sibling_nodes_disconnect_timeout;
+	int			standby_disconnect_timeout;
 	ConnectionCheckType connection_check_type;
 	bool		primary_visibility_consensus;
+	int			primary_visibility_consensus_quorum;
+	int			primary_visibility_consensus_timeout;
+	int			primary_visibility_threshold;
 	char		failover_validation_command[MAXPGPATH];
 	int			election_rerun_interval;
 	int			child_nodes_check_interval;
@@ -206,6 +224,8 @@ typedef struct
 		/* standby follow settings */ \
 		DEFAULT_PRIMARY_FOLLOW_TIMEOUT,	\
 		DEFAULT_STANDBY_FOLLOW_TIMEOUT,	\
+		DEFAULT_SIBLING_NODES_FOLLOW_CONCURRENCY, \
+		DEFAULT_SIBLING_NODES_FOLLOW_TIMEOUT, \
 		/* standby switchover settings */ \
 		DEFAULT_SHUTDOWN_CHECK_TIMEOUT, \
 		DEFAULT_STANDBY_RECONNECT_TIMEOUT, \
@@ -222,11 +242,20 @@ typedef struct
 		DEFAULT_MONITORING_INTERVAL, \
 		DEFAULT_RECONNECTION_ATTEMPTS, \
         DEFAULT_RECONNECTION_INTERVAL, \
+		RECONNECT_BACKOFF_FIXED, DEFAULT_RECONNECT_TIMEOUT_MS, \
+		DEFAULT_RECONNECT_REFUSED_ATTEMPTS, \
+		DEFAULT_CONNECTION_POOL_IDLE_TIMEOUT, \
+		DEFAULT_PRIMARY_HEARTBEAT_INTERVAL_MS, DEFAULT_PRIMARY_HEARTBEAT_TIMEOUT_MS, \
         false, -1, \
 		DEFAULT_ASYNC_QUERY_TIMEOUT, \
 		DEFAULT_PRIMARY_NOTIFICATION_TIMEOUT, \
 		-1, "", false, DEFAULT_SIBLING_NODES_DISCONNECT_TIMEOUT, \
-		CHECK_PING, true, "", DEFAULT_ELECTION_RERUN_INTERVAL, \
+		DEFAULT_STANDBY_DISCONNECT_TIMEOUT, \
+		CHECK_PING, true, \
+		DEFAULT_PRIMARY_VISIBILITY_CONSENSUS_QUORUM, \
+		DEFAULT_PRIMARY_VISIBILITY_CONSENSUS_TIMEOUT, \
+		DEFAULT_PRIMARY_VISIBILITY_THRESHOLD, \
+		"", DEFAULT_ELECTION_RERUN_INTERVAL, \
 		DEFAULT_CHILD_NODES_CHECK_INTERVAL, \
 		DEFAULT_CHILD_NODES_DISCONNECT_MIN_COUNT, \
 		DEFAULT_CHILD_NODES_CONNECTED_MIN_COUNT, \
@@ -314,8 +343,17 @@ typedef struct
 void		set_progname(const char *argv0);
 const char *progname(void);
 
+/*
+ * Subsystems affected by changed options, as returned by reload_config()
+ */
+#define CONFIG_RELOAD_UNCHANGED			0
+#define CONFIG_RELOAD_CONNECTION		(1 << 0)
+#define CONFIG_RELOAD_LOGGING			(1 << 1)
+#define CONFIG_RELOAD_NOTIFICATIONS		(1 << 2)
+#define CONFIG_RELOAD_OTHER				(1 << 3)
+
 void		load_config(const char *config_file, bool verbose, bool terse, t_configuration_options *options, char *argv0);
-bool		reload_config(t_configuration_options *orig_options, t_server_type server_type);
+int			reload_config(t_configuration_options *orig_options, t_server_type server_type);
 
 bool		parse_recovery_conf(const char *data_dir, t_recovery_conf *conf);
 
@@ -341,5 +379,6 @@ void free_parsed_argv(char ***argv_array);
 void		exit_with_cli_errors(ItemList *error_list, const char *repmgr_command);
 void		print_item_list(ItemList *item_list);
 const char *print_connection_check_type(ConnectionCheckType type);
+const char *print_reconnect_backoff_type(ReconnectBackoffType type);
 
 #endif							/* _REPMGR_CONFIGFILE_H_ */
@@ -31,6 +31,8 @@
 #include "dirutil.h"
 
 #define NODE_RECORD_PARAM_COUNT 11
+#define TIMELINE_HISTORY_CACHE_SIZE 16
+#define CONNINFO_ARENA_CHUNK_SIZE 1024
 
 
 /*
@@ -40,6 +42,44 @@
  */
 int			bdr_version_num = UNKNOWN_BDR_VERSION_NUM;
 
+/*
+ * Cache of timeline history entries retrieved by get_timeline_history()
+ */
+typedef struct
+{
+	uint64		system_identifier;
+	int			node_id;
+	TimeLineID	tli;
+	TimeLineHistoryEntry history;
+} t_timeline_history_cache_entry;
+
+static t_timeline_history_cache_entry timeline_history_cache[TIMELINE_HISTORY_CACHE_SIZE];
+static int	timeline_history_cache_count = 0;
+static int	timeline_history_cache_next = 0;
+
+/*
+ * libpq connection defaults, retrieved once per process by
+ * load_conninfo_defaults(); each keyword's position in this array is its
+ * "slot". conninfo_keyword_index is an open-addressing hash table mapping
+ * keywords to slots.
+ */
+static PQconninfoOption *conninfo_defaults = NULL;
+static int	conninfo_defaults_count = 0;
+static int *conninfo_keyword_index = NULL;
+static uint32 conninfo_keyword_index_mask = 0;
+
+/*
+ * Chunk of storage for conninfo values; chunks are chained and only freed
+ * as a whole.
+ */
+struct s_conninfo_arena
+{
+	struct s_conninfo_arena *next;
+	size_t		size;
+	size_t		used;
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+};
+
 static void log_db_error(PGconn *conn, const char *query_text, const char *fmt,...)
 __attribute__((format(PG_PRINTF_ATTRIBUTE, 3, 4)));
 
@@ -67,6 +107,15 @@ static bool _is_bdr_db(PGconn *conn, PQExpBufferData *output, bool quiet);
 static void _populate_bdr_node_record(PGresult *res, t_bdr_node_info *node_info, int row);
 static void _populate_bdr_node_records(PGresult *res, BdrNodeInfoList *node_list);
 
+static TimeLineHistoryEntry *_get_timeline_history(PGconn *repl_conn, TimeLineID tli);
+
+static void load_conninfo_defaults(void);
+static uint32 conninfo_keyword_hash(const char *keyword);
+static int	conninfo_keyword_slot(const char *keyword);
+static char *conninfo_arena_strdup(t_conninfo_param_list *param_list, const char *str);
+static int	param_find(t_conninfo_param_list *param_list, const char *param, int *slot);
+static void param_store(t_conninfo_param_list *param_list, const char *param, int slot, int pos, const char *value);
+
 void
 log_db_error(PGconn *conn, const char *query_text, const char *fmt,...)
 {
@@ -261,6 +310,57 @@ establish_db_connection_quiet(const char *conninfo)
 }
 
 
+/*
+ * Start a non-blocking connection attempt, which the caller must drive to
+ * completion with PQconnectPoll(). Returns NULL if the connection string
+ * could not be parsed or the attempt could not be started.
+ */
+PGconn *
+establish_db_connection_async(const char *conninfo)
+{
+	PGconn	   *conn = NULL;
+	char	   *connection_string = NULL;
+	char	   *errmsg = NULL;
+
+	t_conninfo_param_list conninfo_params = T_CONNINFO_PARAM_LIST_INITIALIZER;
+
+	initialize_conninfo_params(&conninfo_params, false);
+
+	if (parse_conninfo_string(conninfo, &conninfo_params, &errmsg, false) == false)
+	{
+		log_error(_("unable to parse provided conninfo string \"%s\""), conninfo);
+		log_detail("%s", errmsg);
+		free_conninfo_params(&conninfo_params);
+		return NULL;
+	}
+
+	/* set some default values if not explicitly provided */
+	param_set_ine(&conninfo_params, "connect_timeout", "2");
+	param_set_ine(&conninfo_params, "fallback_application_name", "repmgr");
+
+	connection_string = param_list_to_string(&conninfo_params);
+
+	log_debug(_("connecting asynchronously to: \"%s\""), connection_string);
+
+	conn = PQconnectStart(connection_string);
+
+	pfree(connection_string);
+	free_conninfo_params(&conninfo_params);
+
+	if (conn == NULL)
+		return NULL;
+
+	if (PQstatus(conn) == CONNECTION_BAD)
+	{
+		log_verbose(LOG_DEBUG, "establish_db_connection_async(): %s", PQerrorMessage(conn));
+		PQfinish(conn);
+		return NULL;
+	}
+
+	return conn;
+}
+
+
 PGconn *
 establish_primary_db_connection(PGconn *conn,
 								const bool exit_on_error)
@@ -306,18 +406,15 @@ establish_db_connection_by_params(t_conninfo_param_list *param_list,
 	else
 	{
 		bool		is_replication_connection = false;
-		int			i;
+		int			slot;
 
 		/*
 		 * set "synchronous_commit" to "local" in case synchronous replication
 		 * is in use (provided this is not a replication connection)
 		 */
 
-		for (i = 0; param_list->keywords[i]; i++)
-		{
-			if (strcmp(param_list->keywords[i], "replication") == 0)
-				is_replication_connection = true;
-		}
+		if (param_find(param_list, "replication", &slot) >= 0)
+			is_replication_connection = true;
 
 		if (is_replication_connection == false && set_config(conn, "synchronous_commit", "local") == false)
 		{
@@ -425,80 +522,186 @@ get_conninfo_value(const char *conninfo, const char *keyword, char *output)
 bool
 get_conninfo_default_value(const char *param, char *output, int maxlen)
 {
-	PQconninfoOption *defs = NULL;
-	PQconninfoOption *def = NULL;
-	bool found = false;
+	int			slot = conninfo_keyword_slot(param);
+
+	if (slot < 0)
+		return false;
+
+	if (conninfo_defaults[slot].val == NULL)
+		output[0] = '\0';
+	else
+		strncpy(output, conninfo_defaults[slot].val, maxlen);
+
+	return true;
+}
+
+
+/*
+ * Retrieve the libpq connection defaults and build the keyword index.
+ *
+ * The defaults only depend on the environment and the libpq version, neither
+ * of which changes during the lifetime of a repmgr process, so this is only
+ * done once; conninfo parameter lists share the keyword and default value
+ * strings.
+ */
+static void
+load_conninfo_defaults(void)
+{
+	int			index_size = 16;
+	int			slot;
 
-	defs = PQconndefaults();
+	if (conninfo_defaults != NULL)
+		return;
+
+	conninfo_defaults = PQconndefaults();
 
-	for (def = defs; def->keyword; def++)
+	if (conninfo_defaults == NULL)
 	{
-		if (strncmp(def->keyword, param, maxlen) == 0)
-		{
-			strncpy(output, def->val, maxlen);
-			found = true;
-		}
+		log_error(_("unable to retrieve libpq connection defaults"));
+		exit(ERR_OUT_OF_MEMORY);
+	}
+
+	for (slot = 0; conninfo_defaults[slot].keyword != NULL; slot++)
+		conninfo_defaults_count++;
+
+	/* keep the index at most a quarter full */
+	while (index_size < conninfo_defaults_count * 4)
+		index_size *= 2;
+
+	conninfo_keyword_index = pg_malloc(sizeof(int) * index_size);
+	conninfo_keyword_index_mask = index_size - 1;
+
+	for (slot = 0; slot < index_size; slot++)
+		conninfo_keyword_index[slot] = -1;
+
+	for (slot = 0; slot < conninfo_defaults_count; slot++)
+	{
+		uint32		i = conninfo_keyword_hash(conninfo_defaults[slot].keyword) & conninfo_keyword_index_mask;
+
+		while (conninfo_keyword_index[i] != -1)
+			i = (i + 1) & conninfo_keyword_index_mask;
+
+		conninfo_keyword_index[i] = slot;
+	}
+}
+
+
+/* FNV-1a */
+static uint32
+conninfo_keyword_hash(const char *keyword)
+{
+	uint32		hash = 2166136261U;
+	const unsigned char *p;
+
+	for (p = (const unsigned char *) keyword; *p != '\0'; p++)
+	{
+		hash ^= *p;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+
+/*
+ * Return the slot of the provided libpq keyword, or -1 if libpq does not
+ * know about it.
+ */
+static int
+conninfo_keyword_slot(const char *keyword)
+{
+	uint32		i;
+
+	load_conninfo_defaults();
+
+	i = conninfo_keyword_hash(keyword) & conninfo_keyword_index_mask;
+
+	while (conninfo_keyword_index[i] != -1)
+	{
+		int			slot = conninfo_keyword_index[i];
+
+		if (strcmp(conninfo_defaults[slot].keyword, keyword) == 0)
+			return slot;
+
+		i = (i + 1) & conninfo_keyword_index_mask;
+	}
+
+	return -1;
+}
+
+
+static char *
+conninfo_arena_strdup(t_conninfo_param_list *param_list, const char *str)
+{
+	size_t		len = strlen(str) + 1;
+	t_conninfo_arena *chunk = param_list->arena;
+	char	   *copy = NULL;
+
+	if (chunk == NULL || chunk->size - chunk->used < len)
+	{
+		size_t		chunk_size = Max(CONNINFO_ARENA_CHUNK_SIZE, len);
+
+		chunk = pg_malloc(offsetof(t_conninfo_arena, data) + chunk_size);
+		chunk->next = param_list->arena;
+		chunk->size = chunk_size;
+		chunk->used = 0;
+
+		param_list->arena = chunk;
 	}
 
-	PQconninfoFree(defs);
+	copy = chunk->data + chunk->used;
+	memcpy(copy, str, len);
+	chunk->used += len;
 
-	return found;
+	return copy;
 }
 
 
 void
 initialize_conninfo_params(t_conninfo_param_list *param_list, bool set_defaults)
 {
-	PQconninfoOption *defs = NULL;
-	PQconninfoOption *def = NULL;
-	int			c;
+	int			slot;
 
-	defs = PQconndefaults();
-	param_list->size = 0;
+	load_conninfo_defaults();
 
-	/* Count maximum number of parameters */
-	for (def = defs; def->keyword; def++)
-		param_list->size++;
+	param_list->size = conninfo_defaults_count;
+	param_list->count = 0;
+	param_list->arena = NULL;
 
 	/* Initialize our internal parameter list */
 	param_list->keywords = pg_malloc0(sizeof(char *) * (param_list->size + 1));
 	param_list->values = pg_malloc0(sizeof(char *) * (param_list->size + 1));
+	param_list->slots = pg_malloc(sizeof(int) * param_list->size);
 
-	for (c = 0; c < param_list->size; c++)
-	{
-		param_list->keywords[c] = NULL;
-		param_list->values[c] = NULL;
-	}
+	for (slot = 0; slot < param_list->size; slot++)
+		param_list->slots[slot] = -1;
 
 	if (set_defaults == true)
 	{
-		/* Pre-set any defaults */
+		/* Pre-set any defaults; the values are shared, not copied */
 
-		for (def = defs; def->keyword; def++)
+		for (slot = 0; slot < conninfo_defaults_count; slot++)
 		{
-			if (def->val != NULL && def->val[0] != '\0')
-			{
-				param_set(param_list, def->keyword, def->val);
-			}
+			char	   *val = conninfo_defaults[slot].val;
+
+			if (val != NULL && val[0] != '\0')
+				param_store(param_list, conninfo_defaults[slot].keyword, slot, -1, val);
 		}
 	}
-
-	PQconninfoFree(defs);
 }
 
 
 void
 free_conninfo_params(t_conninfo_param_list *param_list)
 {
-	int			c;
+	t_conninfo_arena *chunk = param_list->arena;
 
-	for (c = 0; c < param_list->size; c++)
+	while (chunk != NULL)
 	{
-		if (param_list->keywords != NULL && param_list->keywords[c] != NULL)
-			pfree(param_list->keywords[c]);
+		t_conninfo_arena *next = chunk->next;
 
-		if (param_list->values != NULL && param_list->values[c] != NULL)
-			pfree(param_list->values[c]);
+		pfree(chunk);
+		chunk = next;
 	}
 
 	if (param_list->keywords != NULL)
@@ -506,6 +709,16 @@ free_conninfo_params(t_conninfo_param_list *param_list)
 
 	if (param_list->values != NULL)
 		pfree(param_list->values);
+
+	if (param_list->slots != NULL)
+		pfree(param_list->slots);
+
+	param_list->size = 0;
+	param_list->count = 0;
+	param_list->keywords = NULL;
+	param_list->values = NULL;
+	param_list->slots = NULL;
+	param_list->arena = NULL;
 }
 
 
@@ -515,7 +728,7 @@ copy_conninfo_params(t_conninfo_param_list *dest_list, t_conninfo_param_list *so
 {
 	int			c;
 
-	for (c = 0; c < source_list->size && source_list->keywords[c] != NULL; c++)
+	for (c = 0; c < source_list->count; c++)
 	{
 		if (source_list->values[c] != NULL && source_list->values[c][0] != '\0')
 		{
@@ -524,28 +737,57 @@ copy_conninfo_params(t_conninfo_param_list *dest_list, t_conninfo_param_list *so
 	}
 }
 
-void
-param_set(t_conninfo_param_list *param_list, const char *param, const char *value)
+
+/*
+ * Return the position of the provided parameter in the list, or -1 if
+ * not set; "slot" is set to the parameter's libpq keyword slot (-1 if
+ * not a libpq keyword).
+ */
+static int
+param_find(t_conninfo_param_list *param_list, const char *param, int *slot)
 {
 	int			c;
-	int			value_len = strlen(value) + 1;
-	int			param_len;
 
-	/*
-	 * Scan array to see if the parameter is already set - if not, replace it
-	 */
-	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
+	*slot = conninfo_keyword_slot(param);
+
+	/* list not initialized */
+	if (param_list->slots == NULL)
+		return -1;
+
+	if (*slot >= 0)
+		return param_list->slots[*slot];
+
+	/* Not a keyword known to libpq - fall back to scanning the list */
+	for (c = 0; c < param_list->count; c++)
 	{
 		if (strcmp(param_list->keywords[c], param) == 0)
-		{
-			if (param_list->values[c] != NULL)
-				pfree(param_list->values[c]);
+			return c;
+	}
+
+	return -1;
+}
 
-			param_list->values[c] = pg_malloc0(value_len);
-			strncpy(param_list->values[c], value, value_len);
 
-			return;
-		}
+/*
+ * Set the value at position "pos", or append the parameter if "pos" is -1.
+ *
+ * Default values retrieved from libpq are shared; anything else is copied
+ * into the list's arena.
+ */
+static void
+param_store(t_conninfo_param_list *param_list, const char *param, int slot, int pos, const char *value)
+{
+	char	   *stored_value = NULL;
+
+	if (slot >= 0 && value == conninfo_defaults[slot].val)
+		stored_value = conninfo_defaults[slot].val;
+	else
+		stored_value = conninfo_arena_strdup(param_list, value);
+
+	if (pos >= 0)
+	{
+		param_list->values[pos] = stored_value;
+		return;
 	}
 
 	/*
@@ -553,18 +795,31 @@ param_set(t_conninfo_param_list *param_list, const char *param, const char *valu
 	 * in practice this is highly unlikely, and if it ever happens, this means
 	 * something is highly wrong.
 	 */
-	Assert(c < param_list->size);
+	Assert(param_list->count < param_list->size);
+
+	pos = param_list->count++;
+
+	if (slot >= 0)
+	{
+		param_list->keywords[pos] = conninfo_defaults[slot].keyword;
+		param_list->slots[slot] = pos;
+	}
+	else
+	{
+		param_list->keywords[pos] = conninfo_arena_strdup(param_list, param);
+	}
+
+	param_list->values[pos] = stored_value;
+}
 
-	/*
-	 * Parameter not in array - add it and its associated value
-	 */
-	param_len = strlen(param) + 1;
 
-	param_list->keywords[c] = pg_malloc0(param_len);
-	param_list->values[c] = pg_malloc0(value_len);
+void
+param_set(t_conninfo_param_list *param_list, const char *param, const char *value)
+{
+	int			slot;
+	int			pos = param_find(param_list, param, &slot);
 
-	strncpy(param_list->keywords[c], param, param_len);
-	strncpy(param_list->values[c], value, value_len);
+	param_store(param_list, param, slot, pos, value);
 }
 
 
@@ -574,57 +829,28 @@ param_set(t_conninfo_param_list *param_list, const char *param, const char *valu
 void
 param_set_ine(t_conninfo_param_list *param_list, const char *param, const char *value)
 {
-	int			c;
-	int			value_len = strlen(value) + 1;
-	int			param_len;
-
-	/*
-	 * Scan array to see if the parameter is already set - if so, do nothing
-	 */
-	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
-	{
-		if (strcmp(param_list->keywords[c], param) == 0)
-		{
-			/* parameter exists, do nothing */
-			return;
-		}
-	}
-
-	/*
-	 * Sanity-check that the caller is not trying to overflow the array;
-	 * in practice this is highly unlikely, and if it ever happens, this means
-	 * something is highly wrong.
-	 */
-	Assert(c < param_list->size);
-
-	/*
-	 * Parameter not in array - add it and its associated value
-	 */
-	param_len = strlen(param) + 1;
+	int			slot;
+	int			pos = param_find(param_list, param, &slot);
 
-	param_list->keywords[c] = pg_malloc0(param_len);
-	param_list->values[c] = pg_malloc0(value_len);
+	/* parameter exists, do nothing */
+	if (pos >= 0)
+		return;
 
-	strncpy(param_list->keywords[c], param, param_len);
-	strncpy(param_list->values[c], value, value_len);
+	param_store(param_list, param, slot, pos, value);
 }
 
 
 char *
 param_get(t_conninfo_param_list *param_list, const char *param)
 {
-	int			c;
+	int			slot;
+	int			pos = param_find(param_list, param, &slot);
 
-	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
-	{
-		if (strcmp(param_list->keywords[c], param) == 0)
-		{
-			if (param_list->values[c] != NULL && param_list->values[c][0] != '\0')
-				return param_list->values[c];
-			else
-				return NULL;
-		}
-	}
+	if (pos < 0)
+		return NULL;
+
+	if (param_list->values[pos] != NULL && param_list->values[pos][0] != '\0')
+		return param_list->values[pos];
 
 	return NULL;
 }
@@ -796,22 +1022,7 @@ normalize_conninfo_string(const char *conninfo_str)
 bool
 has_passfile(void)
 {
-	PQconninfoOption *defs = PQconndefaults();
-	PQconninfoOption *def = NULL;
-    bool has_passfile = false;
-
-   	for (def = defs; def->keyword; def++)
-    {
-        if (strcmp(def->keyword, "passfile") == 0)
-        {
-            has_passfile = true;
-            break;
-        }
-    }
-
-	PQconninfoFree(defs);
-
-	return has_passfile;
+	return conninfo_keyword_slot("passfile") >= 0;
 }
 
 
@@ -1120,11 +1331,49 @@ alter_system_int(PGconn *conn, const char *name, int value)
 }
 
 
+bool
+alter_system_str(PGconn *conn, const char *name, const char *value)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+	char	   *escaped_value = PQescapeLiteral(conn, value, strlen(value));
+
+	if (escaped_value == NULL)
+	{
+		log_error(_("unable to escape value for \"%s\""), name);
+		log_detail("%s", PQerrorMessage(conn));
+		return false;
+	}
+
+	initPQExpBuffer(&query);
+	appendPQExpBuffer(&query,
+					  "ALTER SYSTEM SET %s = %s",
+					  name, escaped_value);
+
+	PQfreemem(escaped_value);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		log_db_error(conn, query.data, _("alter_system_str() - unable to execute query"));
+
+		success = false;
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
 bool
 pg_reload_conf(PGconn *conn)
 {
 	PGresult   *res = NULL;
-	bool		success = false;
+	bool		success = true;
 
 	res = PQexec(conn, "SELECT pg_catalog.pg_reload_conf()");
 
@@ -1601,24 +1850,105 @@ system_identifier(PGconn *conn)
 }
 
 
+/*
+ * Return the point at which timeline "tli" forked off from its parent
+ * timeline, as reported by the node "node_id".
+ *
+ * As a timeline history file never changes once created, the parsed result is
+ * cached, so repeated checks against the same node (e.g. during a failover
+ * election, or while repmgrd waits for a node to become available) don't
+ * need to repeat the TIMELINE_HISTORY round trip. The cache is keyed by node
+ * as well as by system identifier and timeline, as after a split-brain
+ * situation nodes may have diverging histories for the same timeline.
+ *
+ * A node's history can however be replaced by rewinding or recloning it, so
+ * callers must discard the cache with reset_timeline_history_cache() whenever
+ * the replication topology may have changed (reconnection to a node,
+ * promotion, following a new upstream).
+ *
+ * The caller is responsible for freeing the returned entry with pfree().
+ */
 TimeLineHistoryEntry *
-get_timeline_history(PGconn *repl_conn, TimeLineID tli)
+get_timeline_history(PGconn *repl_conn, uint64 system_identifier, int node_id, TimeLineID tli)
 {
-	PQExpBufferData query;
-	PGresult   *res = NULL;
+	TimeLineHistoryEntry *history;
+	int			i;
 
-	PQExpBufferData result;
-	char		*resptr;
+	for (i = 0; i < timeline_history_cache_count; i++)
+	{
+		t_timeline_history_cache_entry *cache_entry = &timeline_history_cache[i];
 
-	TimeLineHistoryEntry *history;
-	TimeLineID	file_tli = UNKNOWN_TIMELINE_ID;
-	uint32		switchpoint_hi;
-	uint32		switchpoint_lo;
+		if (cache_entry->system_identifier == system_identifier &&
+			cache_entry->node_id == node_id &&
+			cache_entry->tli == tli)
+		{
+			log_verbose(LOG_DEBUG, "get_timeline_history(): using cached history for timeline %i of node %i",
+						tli, node_id);
 
-	initPQExpBuffer(&query);
+			history = (TimeLineHistoryEntry *) palloc(sizeof(TimeLineHistoryEntry));
+			memcpy(history, &cache_entry->history, sizeof(TimeLineHistoryEntry));
 
-	appendPQExpBuffer(&query,
-					  "TIMELINE_HISTORY %i",
+			return history;
+		}
+	}
+
+	history = _get_timeline_history(repl_conn, tli);
+
+	if (history != NULL && system_identifier != UNKNOWN_SYSTEM_IDENTIFIER)
+	{
+		t_timeline_history_cache_entry *cache_entry = NULL;
+
+		/* once the cache is full, overwrite the oldest entry */
+		if (timeline_history_cache_count < TIMELINE_HISTORY_CACHE_SIZE)
+		{
+			cache_entry = &timeline_history_cache[timeline_history_cache_count++];
+		}
+		else
+		{
+			cache_entry = &timeline_history_cache[timeline_history_cache_next];
+			timeline_history_cache_next = (timeline_history_cache_next + 1) % TIMELINE_HISTORY_CACHE_SIZE;
+		}
+
+		cache_entry->system_identifier = system_identifier;
+		cache_entry->node_id = node_id;
+		cache_entry->tli = tli;
+		memcpy(&cache_entry->history, history, sizeof(TimeLineHistoryEntry));
+	}
+
+	return history;
+}
+
+
+void
+reset_timeline_history_cache(void)
+{
+	if (timeline_history_cache_count > 0)
+		log_verbose(LOG_DEBUG, "reset_timeline_history_cache(): discarding %i cached timeline history entries",
+					timeline_history_cache_count);
+
+	timeline_history_cache_count = 0;
+	timeline_history_cache_next = 0;
+}
+
+
+static TimeLineHistoryEntry *
+_get_timeline_history(PGconn *repl_conn, TimeLineID tli)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+
+	PQExpBufferData result;
+	char		*resptr;
+
+	TimeLineHistoryEntry *history;
+	TimeLineID	file_tli = UNKNOWN_TIMELINE_ID;
+	uint32		switchpoint_hi;
+	uint32		switchpoint_lo;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "TIMELINE_HISTORY %i",
 					  (int)tli);
 
 	res = PQexec(repl_conn, query.data);
@@ -1738,6 +2068,86 @@ get_child_nodes(PGconn *conn, int node_id, NodeInfoList *node_list)
 	return success;
 }
 
+
+/*
+ * Lightweight version of get_child_nodes(), returning only the node ID,
+ * type, name and attachment status of each child node, as determined
+ * from a single snapshot of pg_stat_replication.
+ *
+ * The provided list's storage is reused between calls and is only
+ * reallocated if the number of child nodes has grown.
+ */
+bool
+get_child_node_status(PGconn *conn, int node_id, ChildNodeStatusList *node_list)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	int			i;
+
+	node_list->node_count = 0;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "    SELECT n.node_id, n.type, n.node_name, "
+					  "           EXISTS (SELECT 1 FROM pg_catalog.pg_stat_replication sr "
+					  "                    WHERE sr.application_name = n.node_name) AS attached "
+					  "      FROM repmgr.nodes n "
+					  "     WHERE n.upstream_node_id = %i ",
+					  node_id);
+
+	log_verbose(LOG_DEBUG, "get_child_node_status():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data, _("get_child_node_status(): unable to execute query"));
+		termPQExpBuffer(&query);
+		PQclear(res);
+		return false;
+	}
+
+	termPQExpBuffer(&query);
+
+	if (PQntuples(res) > node_list->capacity)
+	{
+		if (node_list->nodes != NULL)
+			pfree(node_list->nodes);
+
+		node_list->capacity = PQntuples(res);
+		node_list->nodes = palloc0(sizeof(t_child_node_status) * node_list->capacity);
+	}
+
+	for (i = 0; i < PQntuples(res); i++)
+	{
+		t_child_node_status *node = &node_list->nodes[i];
+
+		node->node_id = atoi(PQgetvalue(res, i, 0));
+		node->type = parse_node_type(PQgetvalue(res, i, 1));
+		snprintf(node->node_name, sizeof(node->node_name), "%s", PQgetvalue(res, i, 2));
+		node->attached = atobool(PQgetvalue(res, i, 3)) ? NODE_ATTACHED : NODE_DETACHED;
+	}
+
+	node_list->node_count = PQntuples(res);
+
+	PQclear(res);
+
+	return true;
+}
+
+
+void
+clear_child_node_status_list(ChildNodeStatusList *node_list)
+{
+	if (node_list->nodes != NULL)
+		pfree(node_list->nodes);
+
+	node_list->nodes = NULL;
+	node_list->node_count = 0;
+	node_list->capacity = 0;
+}
+
 /* =============================== */
 /* repmgrd shared memory functions */
 /* =============================== */
@@ -1875,10 +2285,31 @@ repmgrd_set_pid(PGconn *conn, pid_t repmgrd_pid, const char *pidfile)
 	{
 		log_error(_("unable to execute \"SELECT repmgr.set_repmgrd_pid()\""));
 		log_detail("%s", PQerrorMessage(conn));
+		PQclear(res);
+		return;
 	}
 
 	PQclear(res);
 
+	/*
+	 * Registering the PID resets the extension's record of whether repmgrd
+	 * can be woken with SIGUSR1; repmgrd installs its handler before
+	 * registering itself, so declare that it can.
+	 */
+	if (repmgrd_pid != UNKNOWN_PID)
+	{
+		res = PQexec(conn, "SELECT repmgr.set_repmgrd_wakeup_signal(TRUE)");
+
+		/* an older extension version won't have this function */
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		{
+			log_verbose(LOG_DEBUG, "unable to execute \"SELECT repmgr.set_repmgrd_wakeup_signal()\":\n  %s",
+						PQerrorMessage(conn));
+		}
+
+		PQclear(res);
+	}
+
 	return;
 }
 
@@ -4331,6 +4762,177 @@ get_tablespace_name_by_location(PGconn *conn, const char *location, char *name)
 	return success;
 }
 
+
+/*
+ * Populate "locations" with the OID and location of each user-defined
+ * tablespace.
+ *
+ * Returns the number of tablespaces found, or -1 on error.
+ */
+int
+get_tablespace_locations(PGconn *conn, KeyValueList *locations)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	int			i, tablespaces = 0;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBufferStr(&query,
+						 "   SELECT oid, pg_catalog.pg_tablespace_location(oid) "
+						 "     FROM pg_catalog.pg_tablespace "
+						 "    WHERE spcname NOT IN ('pg_default', 'pg_global') "
+						 " ORDER BY oid ");
+
+	log_verbose(LOG_DEBUG, "get_tablespace_locations():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data,
+					 _("get_tablespace_locations(): unable to execute tablespace query"));
+		tablespaces = -1;
+	}
+	else
+	{
+		tablespaces = PQntuples(res);
+
+		for (i = 0; i < tablespaces; i++)
+		{
+			key_value_list_set(locations,
+							   PQgetvalue(res, i, 0),
+							   PQgetvalue(res, i, 1));
+		}
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return tablespaces;
+}
+
+
+/* ================ */
+/* backup functions */
+/* ================ */
+
+/*
+ * Start a non-exclusive backup (PostgreSQL 9.6 and later).
+ *
+ * The backup is tied to the session, so the same connection must be
+ * passed to stop_backup().
+ */
+bool
+start_backup(PGconn *conn, const char *label, bool fast_checkpoint, XLogRecPtr *start_lsn)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	if (PQserverVersion(conn) >= 150000)
+	{
+		appendPQExpBuffer(&query,
+						  "SELECT pg_catalog.pg_backup_start('%s', %s)",
+						  label,
+						  fast_checkpoint == true ? "TRUE" : "FALSE");
+	}
+	else
+	{
+		appendPQExpBuffer(&query,
+						  "SELECT pg_catalog.pg_start_backup('%s', %s, FALSE)",
+						  label,
+						  fast_checkpoint == true ? "TRUE" : "FALSE");
+	}
+
+	log_verbose(LOG_DEBUG, "start_backup():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data,
+					 _("start_backup(): unable to start backup"));
+		success = false;
+	}
+	else if (start_lsn != NULL)
+	{
+		*start_lsn = parse_lsn(PQgetvalue(res, 0, 0));
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
+/*
+ * Stop a non-exclusive backup previously started with start_backup(),
+ * returning the contents of the backup label and tablespace map files,
+ * which the caller must write to the backup's data directory.
+ *
+ * We don't wait for WAL to be archived, as the cloned standby will
+ * stream any WAL it needs from its upstream.
+ */
+bool
+stop_backup(PGconn *conn, PQExpBufferData *labelfile, PQExpBufferData *spcmapfile, XLogRecPtr *stop_lsn)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	if (PQserverVersion(conn) >= 150000)
+	{
+		appendPQExpBufferStr(&query,
+							 "SELECT lsn, labelfile, spcmapfile "
+							 "  FROM pg_catalog.pg_backup_stop(FALSE)");
+	}
+	else if (PQserverVersion(conn) >= 100000)
+	{
+		appendPQExpBufferStr(&query,
+							 "SELECT lsn, labelfile, spcmapfile "
+							 "  FROM pg_catalog.pg_stop_backup(FALSE, FALSE)");
+	}
+	else
+	{
+		appendPQExpBufferStr(&query,
+							 "SELECT lsn, labelfile, spcmapfile "
+							 "  FROM pg_catalog.pg_stop_backup(FALSE)");
+	}
+
+	log_verbose(LOG_DEBUG, "stop_backup():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1)
+	{
+		log_db_error(conn, query.data,
+					 _("stop_backup(): unable to stop backup"));
+		success = false;
+	}
+	else
+	{
+		if (stop_lsn != NULL)
+			*stop_lsn = parse_lsn(PQgetvalue(res, 0, 0));
+
+		appendPQExpBufferStr(labelfile, PQgetvalue(res, 0, 1));
+
+		if (PQgetisnull(res, 0, 2) == 0)
+			appendPQExpBufferStr(spcmapfile, PQgetvalue(res, 0, 2));
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
 /* ============================ */
 /* asynchronous query functions */
 /* ============================ */
@@ -4565,24 +5167,22 @@ add_monitoring_record(PGconn *primary_conn,
 
 	initPQExpBuffer(&query);
 
+	/*
+	 * repmgr.add_monitoring_record() also updates this standby's row in
+	 * "repmgr.monitoring_latest", on which the "repmgr.replication_status"
+	 * view is based. The LSN literals are not cast, as the parameter type
+	 * depends on the PostgreSQL version.
+	 */
 	appendPQExpBuffer(&query,
-					  "INSERT INTO repmgr.monitoring_history "
-					  "           (primary_node_id, "
-					  "            standby_node_id, "
-					  "            last_monitor_time, "
-					  "            last_apply_time, "
-					  "            last_wal_primary_location, "
-					  "            last_wal_standby_location, "
-					  "            replication_lag, "
-					  "            apply_lag ) "
-					  "     VALUES(%i, "
-					  "            %i, "
-					  "            '%s'::TIMESTAMP WITH TIME ZONE, "
-					  "            '%s'::TIMESTAMP WITH TIME ZONE, "
-					  "            '%X/%X', "
-					  "            '%X/%X', "
-					  "            %llu, "
-					  "            %llu) ",
+					  "SELECT repmgr.add_monitoring_record( "
+					  "         %i, "
+					  "         %i, "
+					  "         '%s'::TIMESTAMP WITH TIME ZONE, "
+					  "         '%s'::TIMESTAMP WITH TIME ZONE, "
+					  "         '%X/%X', "
+					  "         '%X/%X', "
+					  "         %llu::BIGINT, "
+					  "         %llu::BIGINT) ",
 					  primary_node_id,
 					  local_node_id,
 					  monitor_standby_timestamp,
@@ -4617,6 +5217,10 @@ add_monitoring_record(PGconn *primary_conn,
 }
 
 
+/*
+ * Monitoring records older than "keep_history" days are deleted, but only
+ * once they have been summarised; see repmgr.monitoring_record_can_be_deleted().
+ */
 int
 get_number_of_monitoring_records_to_delete(PGconn *primary_conn, int keep_history, int node_id)
 {
@@ -4627,16 +5231,13 @@ get_number_of_monitoring_records_to_delete(PGconn *primary_conn, int keep_histor
 	initPQExpBuffer(&query);
 
 	appendPQExpBuffer(&query,
-					  "SELECT pg_catalog.count(*) "
-					  "  FROM repmgr.monitoring_history "
-					  " WHERE pg_catalog.age(pg_catalog.now(), last_monitor_time) >= '%d days'::interval",
+					  "SELECT repmgr.get_monitoring_records_to_delete(%i, ",
 					  keep_history);
 
-	if (node_id != UNKNOWN_NODE_ID)
-	{
-		appendPQExpBuffer(&query,
-						  "  AND standby_node_id = %i", node_id);
-	}
+	if (node_id == UNKNOWN_NODE_ID)
+		appendPQExpBufferStr(&query, "NULL)");
+	else
+		appendPQExpBuffer(&query, "%i)", node_id);
 
 	log_verbose(LOG_DEBUG, "get_number_of_monitoring_records_to_delete():\n  %s", query.data);
 
@@ -4668,38 +5269,189 @@ delete_monitoring_records(PGconn *primary_conn, int keep_history, int node_id)
 
 	initPQExpBuffer(&query);
 
-	if (keep_history > 0 || node_id != UNKNOWN_NODE_ID)
-	{
-		appendPQExpBuffer(&query,
-						  "DELETE FROM repmgr.monitoring_history "
-						  " WHERE pg_catalog.age(pg_catalog.now(), last_monitor_time) >= '%d days'::INTERVAL ",
-						  keep_history);
+	appendPQExpBuffer(&query,
+					  "SELECT repmgr.delete_monitoring_records(%i, ",
+					  keep_history);
 
-		if (node_id != UNKNOWN_NODE_ID)
-		{
-			appendPQExpBuffer(&query,
-							  "  AND standby_node_id = %i", node_id);
-		}
+	if (node_id == UNKNOWN_NODE_ID)
+		appendPQExpBufferStr(&query, "NULL)");
+	else
+		appendPQExpBuffer(&query, "%i)", node_id);
+
+	log_verbose(LOG_DEBUG, "delete_monitoring_records():\n  %s", query.data);
+
+	res = PQexec(primary_conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(primary_conn, query.data,
+					 _("delete_monitoring_records(): unable to delete monitoring records"));
+		success = false;
 	}
 	else
 	{
-		appendPQExpBufferStr(&query,
-							 "TRUNCATE TABLE repmgr.monitoring_history");
+		log_verbose(LOG_DEBUG, "%s monitoring record(s) deleted", PQgetvalue(res, 0, 0));
 	}
 
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
+/*
+ * Summarise raw monitoring records into the per-minute and per-hour
+ * rollup tables; see repmgr.update_monitoring_rollups(). This must be
+ * executed before raw records are deleted.
+ */
+bool
+update_monitoring_rollups(PGconn *primary_conn)
+{
+	const char *query = "SELECT repmgr.update_monitoring_rollups()";
+	bool		success = true;
+	PGresult   *res = NULL;
+
+	log_verbose(LOG_DEBUG, "update_monitoring_rollups():\n  %s", query);
+
+	res = PQexec(primary_conn, query);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(primary_conn, query,
+					 _("update_monitoring_rollups(): unable to update monitoring rollups"));
+		success = false;
+	}
+
+	PQclear(res);
+
+	return success;
+}
+
+
+/*
+ * primary heartbeat functions
+ *
+ * When "primary_heartbeat_interval_ms" is set, repmgrd on the primary
+ * regularly updates its row in "repmgr.primary_heartbeat"; repmgrd on
+ * a standby reads the replayed value to determine whether the primary
+ * is still generating WAL which reaches the standby.
+ */
+
+bool
+update_primary_heartbeat(PGconn *primary_conn, int node_id)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	if (begin_transaction(primary_conn) == false)
+		return false;
+
+	/*
+	 * The heartbeat must not wait for synchronous standbys to confirm it, as
+	 * otherwise it would stall (together with repmgrd) precisely when those
+	 * standbys are unavailable.
+	 */
+	res = PQexec(primary_conn, "SET LOCAL synchronous_commit TO local");
+
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		log_db_error(primary_conn, "SET LOCAL synchronous_commit TO local",
+					 _("update_primary_heartbeat(): unable to set \"synchronous_commit\""));
+		PQclear(res);
+		rollback_transaction(primary_conn);
+
+		return false;
+	}
+
+	PQclear(res);
+
+	initPQExpBuffer(&query);
+
+	/* INSERT ... ON CONFLICT is not available before PostgreSQL 9.5 */
+	appendPQExpBuffer(&query,
+					  "WITH heartbeat AS ( "
+					  "     UPDATE repmgr.primary_heartbeat "
+					  "        SET heartbeat_time = pg_catalog.clock_timestamp() "
+					  "      WHERE node_id = %i "
+					  "  RETURNING node_id "
+					  ") "
+					  "INSERT INTO repmgr.primary_heartbeat (node_id, heartbeat_time) "
+					  "     SELECT %i, pg_catalog.clock_timestamp() "
+					  "      WHERE NOT EXISTS (SELECT 1 FROM heartbeat) ",
+					  node_id,
+					  node_id);
+
+	log_verbose(LOG_DEBUG, "update_primary_heartbeat():\n  %s", query.data);
+
 	res = PQexec(primary_conn, query.data);
 
 	if (PQresultStatus(res) != PGRES_COMMAND_OK)
 	{
 		log_db_error(primary_conn, query.data,
-					 _("delete_monitoring_records(): unable to delete monitoring records"));
+					 _("update_primary_heartbeat(): unable to update heartbeat"));
 		success = false;
 	}
 
 	termPQExpBuffer(&query);
 	PQclear(res);
 
-	return success;
+	if (success == false)
+	{
+		rollback_transaction(primary_conn);
+		return false;
+	}
+
+	return commit_transaction(primary_conn);
+}
+
+
+/*
+ * Retrieve the heartbeat most recently written by the specified primary,
+ * as microseconds since the epoch.
+ *
+ * Note the value reflects the primary's clock, so callers should only
+ * compare it with previously retrieved values, not the local time.
+ */
+RecordStatus
+get_primary_heartbeat(PGconn *conn, int node_id, int64 *heartbeat_us)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	RecordStatus record_status = RECORD_FOUND;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "SELECT (EXTRACT(EPOCH FROM heartbeat_time) * 1000000)::BIGINT "
+					  "  FROM repmgr.primary_heartbeat "
+					  " WHERE node_id = %i",
+					  node_id);
+
+	log_verbose(LOG_DEBUG, "get_primary_heartbeat():\n  %s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data,
+					 _("get_primary_heartbeat(): unable to retrieve heartbeat"));
+		record_status = RECORD_ERROR;
+	}
+	else if (PQntuples(res) == 0)
+	{
+		record_status = RECORD_NOT_FOUND;
+	}
+	else
+	{
+		*heartbeat_us = strtoll(PQgetvalue(res, 0, 0), NULL, 10);
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return record_status;
 }
 
 /*
@@ -4837,6 +5589,37 @@ notify_follow_primary(PGconn *conn, int primary_node_id)
 }
 
 
+/*
+ * As notify_follow_primary(), but only send the query; the caller is
+ * responsible for collecting the result.
+ */
+bool
+notify_follow_primary_async(PGconn *conn, int primary_node_id)
+{
+	PQExpBufferData query;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "SELECT repmgr.notify_follow_primary(%i)",
+					  primary_node_id);
+
+	log_verbose(LOG_DEBUG, "notify_follow_primary_async():\n  %s", query.data);
+
+	if (PQsendQuery(conn, query.data) == 0)
+	{
+		log_warning(_("unable to send repmgr.notify_follow_primary() query"));
+		log_detail("%s", PQerrorMessage(conn));
+		success = false;
+	}
+
+	termPQExpBuffer(&query);
+
+	return success;
+}
+
+
 bool
 get_new_primary(PGconn *conn, int *primary_node_id)
 {
@@ -5473,6 +6256,83 @@ get_upstream_last_seen(PGconn *conn, t_server_type node_type)
 }
 
 
+/*
+ * Send a query retrieving the node's upstream node ID and the time elapsed
+ * (in milliseconds) since the node's repmgrd last saw it; the caller collects
+ * the result with get_upstream_last_seen_ms_result() once the connection
+ * is no longer busy.
+ */
+bool
+send_upstream_last_seen_ms_query(PGconn *conn, t_server_type node_type)
+{
+	PQExpBufferData query;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	if (node_type == WITNESS)
+	{
+		appendPQExpBufferStr(&query,
+							 "SELECT repmgr.get_upstream_node_id(), "
+							 "       repmgr.get_upstream_last_seen_ms()");
+	}
+	else
+	{
+		appendPQExpBufferStr(&query,
+							 "SELECT repmgr.get_upstream_node_id(), "
+							 "       CASE WHEN pg_catalog.pg_is_in_recovery() IS FALSE "
+							 "         THEN -1 "
+							 "         ELSE repmgr.get_upstream_last_seen_ms() "
+							 "       END AS upstream_last_seen_ms ");
+	}
+
+	log_verbose(LOG_DEBUG, "send_upstream_last_seen_ms_query():\n  %s", query.data);
+
+	if (PQsendQuery(conn, query.data) == 0)
+	{
+		log_warning(_("unable to send repmgr.get_upstream_last_seen_ms() query"));
+		log_detail("%s", PQerrorMessage(conn));
+		success = false;
+	}
+
+	termPQExpBuffer(&query);
+
+	return success;
+}
+
+
+bool
+get_upstream_last_seen_ms_result(PGconn *conn, int *upstream_node_id, int64 *upstream_last_seen_ms)
+{
+	PGresult   *res = NULL;
+	bool		success = false;
+
+	*upstream_node_id = UNKNOWN_NODE_ID;
+	*upstream_last_seen_ms = -1;
+
+	while ((res = PQgetResult(conn)) != NULL)
+	{
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		{
+			log_warning(_("unable to execute repmgr.get_upstream_last_seen_ms()"));
+			log_detail("%s", PQerrorMessage(conn));
+		}
+		else if (PQntuples(res) == 1)
+		{
+			if (PQgetisnull(res, 0, 0) == false)
+				*upstream_node_id = atoi(PQgetvalue(res, 0, 0));
+
+			*upstream_last_seen_ms = strtoll(PQgetvalue(res, 0, 1), NULL, 10);
+			success = true;
+		}
+
+		PQclear(res);
+	}
+
+	return success;
+}
+
+
 bool
 is_wal_replay_paused(PGconn *conn, bool check_pending_wal)
 {
@@ -5533,6 +6393,51 @@ is_wal_replay_paused(PGconn *conn, bool check_pending_wal)
 }
 
 
+/*
+ * Retrieve the status of the local node's WAL receiver, and the upstream
+ * it is connected to, from "pg_stat_wal_receiver" (PostgreSQL 11 and later).
+ *
+ * Returns false if the query failed; if no WAL receiver is running,
+ * "pid" is set to 0.
+ */
+bool
+get_wal_receiver_info(PGconn *conn, t_wal_receiver_info *info)
+{
+	PGresult   *res = NULL;
+	bool		success = false;
+
+	const char *sqlquery =
+		"SELECT pid, status, "
+		"       COALESCE(sender_host, ''), "
+		"       COALESCE(sender_port, -1) "
+		"  FROM pg_catalog.pg_stat_wal_receiver";
+
+	res = PQexec(conn, sqlquery);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, sqlquery, _("get_wal_receiver_info(): unable to execute query"));
+	}
+	else if (PQntuples(res) == 0)
+	{
+		info->pid = 0;
+		success = true;
+	}
+	else
+	{
+		info->pid = atoi(PQgetvalue(res, 0, 0));
+		snprintf(info->status, sizeof(info->status), "%s", PQgetvalue(res, 0, 1));
+		snprintf(info->sender_host, sizeof(info->sender_host), "%s", PQgetvalue(res, 0, 2));
+		info->sender_port = atoi(PQgetvalue(res, 0, 3));
+		success = true;
+	}
+
+	PQclear(res);
+
+	return success;
+}
+
+
 /* ============= */
 /* BDR functions */
 /* ============= */
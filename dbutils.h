@@ -272,6 +272,32 @@ typedef struct NodeInfoList
 	0 \
 }
 
+/*
+ * Minimal information about a child node and its attachment status, as
+ * returned by get_child_node_status(). The array is reused between calls
+ * and only reallocated if it needs to grow.
+ */
+typedef struct
+{
+	int			node_id;
+	t_server_type type;
+	char		node_name[NAMEDATALEN];
+	NodeAttached attached;
+} t_child_node_status;
+
+typedef struct
+{
+	t_child_node_status *nodes;
+	int			node_count;
+	int			capacity;
+} ChildNodeStatusList;
+
+#define T_CHILD_NODE_STATUS_LIST_INITIALIZER { \
+	NULL, \
+	0, \
+	0 \
+}
+
 typedef struct s_event_info
 {
 	char	   *node_name;
@@ -288,18 +314,37 @@ typedef struct s_event_info
 
 /*
  * Struct to store list of conninfo keywords and values
+ *
+ * "keywords" and "values" are NULL-terminated parallel arrays which can be
+ * passed directly to PQconnectdbParams(); "count" is the number of entries
+ * in use. "slots" maps each libpq keyword (by its position in the
+ * per-process copy of PQconndefaults()) to its entry in those arrays, so
+ * lookups do not need to scan the list.
+ *
+ * Keywords point to the shared libpq defaults and are never copied. Values
+ * either point to the shared default value or to a copy allocated from
+ * "arena"; setting a parameter replaces the pointer, so shared defaults are
+ * never modified. All storage is released by free_conninfo_params().
  */
+typedef struct s_conninfo_arena t_conninfo_arena;
+
 typedef struct
 {
 	int			size;
+	int			count;
 	char	  **keywords;
 	char	  **values;
+	int		   *slots;
+	t_conninfo_arena *arena;
 } t_conninfo_param_list;
 
 #define T_CONNINFO_PARAM_LIST_INITIALIZER { \
+	0, \
 	0, \
 	NULL, \
 	NULL, \
+	NULL, \
+	NULL \
 }
 
 /*
@@ -394,6 +439,21 @@ typedef struct
 	InvalidXLogRecPtr \
 }
 
+typedef struct
+{
+	pid_t		pid;
+	char		status[MAXLEN];
+	char		sender_host[MAXLEN];
+	int			sender_port;
+} t_wal_receiver_info;
+
+#define T_WAL_RECEIVER_INFO_INITIALIZER { \
+	UNKNOWN_PID, \
+	"", \
+	"", \
+	-1 \
+}
+
 
 typedef struct RepmgrdInfo {
 	int node_id;
@@ -430,6 +490,7 @@ bool		atobool(const char *value);
 PGconn	   *establish_db_connection(const char *conninfo,
 						const bool exit_on_error);
 PGconn	   *establish_db_connection_quiet(const char *conninfo);
+PGconn	   *establish_db_connection_async(const char *conninfo);
 PGconn	   *establish_db_connection_by_params(t_conninfo_param_list *param_list,
 								  const bool exit_on_error);
 PGconn	   *establish_primary_db_connection(PGconn *conn,
@@ -468,6 +529,7 @@ int		    guc_set(PGconn *conn, const char *parameter, const char *op, const char
 bool		get_pg_setting(PGconn *conn, const char *setting, char *output);
 bool		get_pg_setting_int(PGconn *conn, const char *setting, int *output);
 bool		alter_system_int(PGconn *conn, const char *name, int value);
+bool		alter_system_str(PGconn *conn, const char *name, const char *value);
 bool		pg_reload_conf(PGconn *conn);
 
 /* server information functions */
@@ -479,7 +541,8 @@ int			get_primary_node_id(PGconn *conn);
 int			get_ready_archive_files(PGconn *conn, const char *data_directory);
 bool		identify_system(PGconn *repl_conn, t_system_identification *identification);
 uint64		system_identifier(PGconn *conn);
-TimeLineHistoryEntry *get_timeline_history(PGconn *repl_conn, TimeLineID tli);
+TimeLineHistoryEntry *get_timeline_history(PGconn *repl_conn, uint64 system_identifier, int node_id, TimeLineID tli);
+void		reset_timeline_history_cache(void);
 
 /* repmgrd shared memory functions */
 bool		repmgrd_set_local_node_id(PGconn *conn, int local_node_id);
@@ -523,6 +586,8 @@ bool		get_all_node_records(PGconn *conn, NodeInfoList *node_list);
 void		get_downstream_node_records(PGconn *conn, int node_id, NodeInfoList *nodes);
 void		get_active_sibling_node_records(PGconn *conn, int node_id, int upstream_node_id, NodeInfoList *node_list);
 bool		get_child_nodes(PGconn *conn, int node_id, NodeInfoList *node_list);
+bool		get_child_node_status(PGconn *conn, int node_id, ChildNodeStatusList *node_list);
+void		clear_child_node_status_list(ChildNodeStatusList *node_list);
 void		get_node_records_by_priority(PGconn *conn, NodeInfoList *node_list);
 bool		get_all_node_records_with_upstream(PGconn *conn, NodeInfoList *node_list);
 bool		get_downstream_nodes_with_missing_slot(PGconn *conn, int this_node_id, NodeInfoList *noede_list);
@@ -566,6 +631,11 @@ int			get_inactive_replication_slots(PGconn *conn, KeyValueList *list);
 
 /* tablespace functions */
 bool		get_tablespace_name_by_location(PGconn *conn, const char *location, char *name);
+int			get_tablespace_locations(PGconn *conn, KeyValueList *locations);
+
+/* backup functions */
+bool		start_backup(PGconn *conn, const char *label, bool fast_checkpoint, XLogRecPtr *start_lsn);
+bool		stop_backup(PGconn *conn, PQExpBufferData *labelfile, PQExpBufferData *spcmapfile, XLogRecPtr *stop_lsn);
 
 /* asynchronous query functions */
 bool		cancel_query(PGconn *conn, int timeout);
@@ -594,6 +664,11 @@ add_monitoring_record(PGconn *primary_conn,
 
 int			get_number_of_monitoring_records_to_delete(PGconn *primary_conn, int keep_history, int node_id);
 bool		delete_monitoring_records(PGconn *primary_conn, int keep_history, int node_id);
+bool		update_monitoring_rollups(PGconn *primary_conn);
+
+/* primary heartbeat functions */
+bool		update_primary_heartbeat(PGconn *primary_conn, int node_id);
+RecordStatus get_primary_heartbeat(PGconn *conn, int node_id, int64 *heartbeat_us);
 
 
 
@@ -603,6 +678,7 @@ int			get_current_term(PGconn *conn);
 void		increment_current_term(PGconn *conn);
 bool		announce_candidature(PGconn *conn, t_node_info *this_node, t_node_info *other_node, int electoral_term);
 void		notify_follow_primary(PGconn *conn, int primary_node_id);
+bool		notify_follow_primary_async(PGconn *conn, int primary_node_id);
 bool		get_new_primary(PGconn *conn, int *primary_node_id);
 void		reset_voting_status(PGconn *conn);
 
@@ -618,8 +694,11 @@ void		get_node_replication_stats(PGconn *conn, t_node_info *node_info);
 NodeAttached is_downstream_node_attached(PGconn *conn, char *node_name);
 void		set_upstream_last_seen(PGconn *conn, int upstream_node_id);
 int			get_upstream_last_seen(PGconn *conn, t_server_type node_type);
+bool		send_upstream_last_seen_ms_query(PGconn *conn, t_server_type node_type);
+bool		get_upstream_last_seen_ms_result(PGconn *conn, int *upstream_node_id, int64 *upstream_last_seen_ms);
 
 bool		is_wal_replay_paused(PGconn *conn, bool check_pending_wal);
+bool		get_wal_receiver_info(PGconn *conn, t_wal_receiver_info *info);
 
 /* BDR functions */
 int			get_bdr_version_num(void);
@@ -26,6 +26,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
 #include <ftw.h>
 
 /* NB: postgres_fe must be included BEFORE check_dir */
@@ -37,7 +38,24 @@
 #include "log.h"
 #include "controldata.h"
 
+/*
+ * copy_file_range() is available from glibc 2.27; sendfile() can write to
+ * a regular file from Linux 2.6.33. copy_file() falls back to a buffered
+ * copy if neither is usable.
+ */
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#define HAVE_SENDFILE 1
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define HAVE_COPY_FILE_RANGE 1
+#endif
+#endif
+
+#define COPY_FILE_BUFSIZE 65536
+
 static int	unlink_dir_callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf);
+static bool copy_file_contents(int src_fd, int dest_fd, off_t size);
+static bool fsync_parent_dir(const char *path);
 
 /* PID can be negative if backend is standalone */
 typedef long pgpid_t;
@@ -382,6 +400,289 @@ create_pg_dir(const char *path, bool force)
 
 
 
+/*
+ * Determine which file should be replaced when replacing "path": if "path" is a
+ * symbolic link (e.g. a configuration file linked into the data directory),
+ * this is the file it points to, as renaming a file onto "path" would
+ * otherwise replace the link itself. "target" must be MAXPGPATH bytes.
+ *
+ * Returns false if the link could not be resolved.
+ */
+bool
+resolve_file_symlink(const char *path, char *target)
+{
+	struct stat statbuf;
+	int			depth = 0;
+
+	strncpy(target, path, MAXPGPATH - 1);
+	target[MAXPGPATH - 1] = '\0';
+
+	while (lstat(target, &statbuf) == 0 && S_ISLNK(statbuf.st_mode))
+	{
+		char		link_target[MAXPGPATH] = "";
+		ssize_t		len;
+
+		/* the same limit as the kernel's, to avoid looping */
+		if (++depth > 40)
+		{
+			log_verbose(LOG_DEBUG, "resolve_file_symlink(): too many levels of symbolic links in \"%s\"",
+						path);
+			return false;
+		}
+
+		len = readlink(target, link_target, sizeof(link_target) - 1);
+
+		if (len < 0)
+		{
+			log_verbose(LOG_DEBUG, "resolve_file_symlink(): unable to read symbolic link \"%s\": %s",
+						target, strerror(errno));
+			return false;
+		}
+
+		link_target[len] = '\0';
+
+		/* a relative link is relative to the directory containing it */
+		if (is_absolute_path(link_target))
+		{
+			strncpy(target, link_target, MAXPGPATH - 1);
+		}
+		else
+		{
+			char		link_dir[MAXPGPATH] = "";
+
+			strncpy(link_dir, target, MAXPGPATH - 1);
+			get_parent_directory(link_dir);
+
+			if (link_dir[0] == '\0')
+				strncpy(target, link_target, MAXPGPATH - 1);
+			else
+				join_path_components(target, link_dir, link_target);
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * Copy a regular file. The copy is written to a temporary file alongside
+ * "dest_file", which is fsync'd and renamed into place, so "dest_file" is
+ * only ever replaced by a complete copy.
+ *
+ * If "dest_file" is a symbolic link, the file it points to is replaced,
+ * and if that file exists, its mode is retained; otherwise the file will
+ * be created with mode 0600.
+ */
+bool
+copy_file(const char *src_file, const char *dest_file)
+{
+	int			src_fd = -1;
+	int			dest_fd = -1;
+	struct stat statbuf;
+	char		target_file[MAXPGPATH] = "";
+	char		tmp_file[MAXPGPATH] = "";
+	mode_t		mode = S_IRUSR | S_IWUSR;
+	bool		success = true;
+
+	if (resolve_file_symlink(dest_file, target_file) == false)
+		return false;
+
+	if (stat(target_file, &statbuf) == 0)
+		mode = statbuf.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
+
+	src_fd = open(src_file, O_RDONLY | PG_BINARY, 0);
+
+	if (src_fd < 0)
+	{
+		log_verbose(LOG_DEBUG, "copy_file(): unable to open \"%s\": %s",
+					src_file, strerror(errno));
+		return false;
+	}
+
+	if (fstat(src_fd, &statbuf) < 0)
+	{
+		log_verbose(LOG_DEBUG, "copy_file(): unable to stat \"%s\": %s",
+					src_file, strerror(errno));
+		close(src_fd);
+		return false;
+	}
+
+	maxpath_snprintf(tmp_file, "%s.tmp", target_file);
+
+	dest_fd = open(tmp_file, O_WRONLY | O_CREAT | O_TRUNC | PG_BINARY, S_IRUSR | S_IWUSR);
+
+	if (dest_fd < 0)
+	{
+		log_verbose(LOG_DEBUG, "copy_file(): unable to create \"%s\": %s",
+					tmp_file, strerror(errno));
+		close(src_fd);
+		return false;
+	}
+
+	/* the mode passed to open() is subject to the umask */
+	if (fchmod(dest_fd, mode) < 0)
+	{
+		log_verbose(LOG_DEBUG, "copy_file(): unable to set permissions on \"%s\": %s",
+					tmp_file, strerror(errno));
+		success = false;
+	}
+
+	if (success == true)
+		success = copy_file_contents(src_fd, dest_fd, statbuf.st_size);
+
+	if (success == true && fsync(dest_fd) < 0)
+	{
+		log_verbose(LOG_DEBUG, "copy_file(): unable to fsync \"%s\": %s",
+					tmp_file, strerror(errno));
+		success = false;
+	}
+
+	if (close(dest_fd) < 0)
+		success = false;
+
+	close(src_fd);
+
+	if (success == true && rename(tmp_file, target_file) < 0)
+	{
+		log_verbose(LOG_DEBUG, "copy_file(): unable to rename \"%s\" to \"%s\": %s",
+					tmp_file, target_file, strerror(errno));
+		success = false;
+	}
+
+	if (success == false)
+	{
+		unlink(tmp_file);
+		return false;
+	}
+
+	return fsync_parent_dir(target_file);
+}
+
+
+/*
+ * Copy the contents of "src_fd" to "dest_fd", preferring in-kernel copies.
+ * Each method continues from the current file offsets, so if one fails
+ * part-way through (e.g. copy_file_range() across filesystems on older
+ * kernels), the next can pick up where it left off.
+ */
+static bool
+copy_file_contents(int src_fd, int dest_fd, off_t size)
+{
+	char	   *buf = NULL;
+	ssize_t		bytes_read = 0;
+
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+	off_t		remaining = size;
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+	while (remaining > 0)
+	{
+		ssize_t		copied = copy_file_range(src_fd, NULL, dest_fd, NULL, remaining, 0);
+
+		if (copied < 0 && errno == EINTR)
+			continue;
+
+		if (copied <= 0)
+			break;
+
+		remaining -= copied;
+	}
+#endif
+
+#ifdef HAVE_SENDFILE
+	while (remaining > 0)
+	{
+		ssize_t		copied = sendfile(dest_fd, src_fd, NULL, remaining);
+
+		if (copied < 0 && errno == EINTR)
+			continue;
+
+		if (copied <= 0)
+			break;
+
+		remaining -= copied;
+	}
+#endif
+
+	/*
+	 * Copy anything not yet copied; this also picks up any data appended
+	 * to the file since we checked its size.
+	 */
+	buf = pg_malloc(COPY_FILE_BUFSIZE);
+
+	while ((bytes_read = read(src_fd, buf, COPY_FILE_BUFSIZE)) != 0)
+	{
+		char	   *p = buf;
+
+		if (bytes_read < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			pfree(buf);
+			return false;
+		}
+
+		while (bytes_read > 0)
+		{
+			ssize_t		bytes_written = write(dest_fd, p, bytes_read);
+
+			if (bytes_written < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				pfree(buf);
+				return false;
+			}
+
+			p += bytes_written;
+			bytes_read -= bytes_written;
+		}
+	}
+
+	pfree(buf);
+
+	return true;
+}
+
+
+/*
+ * fsync the directory containing "path", to ensure a preceding rename()
+ * is durable.
+ */
+static bool
+fsync_parent_dir(const char *path)
+{
+	char		parent_dir[MAXPGPATH] = "";
+	int			fd;
+	bool		success = true;
+
+	strncpy(parent_dir, path, MAXPGPATH - 1);
+	get_parent_directory(parent_dir);
+
+	if (parent_dir[0] == '\0')
+		strncpy(parent_dir, ".", MAXPGPATH);
+
+	fd = open(parent_dir, O_RDONLY | PG_BINARY, 0);
+
+	if (fd < 0)
+		return false;
+
+	if (fsync(fd) < 0)
+	{
+		log_verbose(LOG_DEBUG, "copy_file(): unable to fsync directory \"%s\": %s",
+					parent_dir, strerror(errno));
+		success = false;
+	}
+
+	close(fd);
+
+	return success;
+}
+
+
 int
 rmdir_recursive(const char *path)
 {
@@ -43,5 +43,7 @@ extern bool is_pg_dir(const char *path);
 extern PgDirState is_pg_running(const char *path);
 extern bool create_pg_dir(const char *path, bool force);
 extern int rmdir_recursive(const char *path);
+extern bool resolve_file_symlink(const char *path, char *target);
+extern bool copy_file(const char *src_file, const char *dest_file);
 
 #endif
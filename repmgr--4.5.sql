@@ -42,6 +42,18 @@ CREATE TABLE repmgr.monitoring_history (
   last_wal_standby_location      PG_LSN,
   replication_lag                BIGINT NOT NULL,
   apply_lag                      BIGINT NOT NULL
+)
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE TABLE repmgr.monitoring_latest (
+  primary_node_id                INTEGER NOT NULL,
+  standby_node_id                INTEGER NOT NULL PRIMARY KEY,
+  last_monitor_time              TIMESTAMP WITH TIME ZONE NOT NULL,
+  last_apply_time                TIMESTAMP WITH TIME ZONE,
+  last_wal_primary_location      PG_LSN NOT NULL,
+  last_wal_standby_location      PG_LSN,
+  replication_lag                BIGINT NOT NULL,
+  apply_lag                      BIGINT NOT NULL
 )
     $repmgr_func$;
   ELSE
@@ -55,6 +67,18 @@ CREATE TABLE repmgr.monitoring_history (
   last_wal_standby_location      TEXT,
   replication_lag                BIGINT NOT NULL,
   apply_lag                      BIGINT NOT NULL
+)
+    $repmgr_func$;
+    EXECUTE $repmgr_func$
+CREATE TABLE repmgr.monitoring_latest (
+  primary_node_id                INTEGER NOT NULL,
+  standby_node_id                INTEGER NOT NULL PRIMARY KEY,
+  last_monitor_time              TIMESTAMP WITH TIME ZONE NOT NULL,
+  last_apply_time                TIMESTAMP WITH TIME ZONE,
+  last_wal_primary_location      TEXT NOT NULL,
+  last_wal_standby_location      TEXT,
+  replication_lag                BIGINT NOT NULL,
+  apply_lag                      BIGINT NOT NULL
 )
     $repmgr_func$;
   END IF;
@@ -65,6 +89,41 @@ END$repmgr$;
 CREATE INDEX idx_monitoring_history_time
           ON repmgr.monitoring_history (last_monitor_time, standby_node_id);
 
+CREATE TABLE repmgr.monitoring_history_minute (
+  standby_node_id                INTEGER NOT NULL,
+  bucket_start                   TIMESTAMP WITH TIME ZONE NOT NULL,
+  sample_count                   INTEGER NOT NULL,
+  replication_lag_min            BIGINT NOT NULL,
+  replication_lag_avg            BIGINT NOT NULL,
+  replication_lag_max            BIGINT NOT NULL,
+  replication_lag_p99            BIGINT,
+  apply_lag_min                  BIGINT NOT NULL,
+  apply_lag_avg                  BIGINT NOT NULL,
+  apply_lag_max                  BIGINT NOT NULL,
+  apply_lag_p99                  BIGINT,
+  PRIMARY KEY (standby_node_id, bucket_start)
+);
+
+CREATE TABLE repmgr.monitoring_history_hour (
+  standby_node_id                INTEGER NOT NULL,
+  bucket_start                   TIMESTAMP WITH TIME ZONE NOT NULL,
+  sample_count                   INTEGER NOT NULL,
+  replication_lag_min            BIGINT NOT NULL,
+  replication_lag_avg            BIGINT NOT NULL,
+  replication_lag_max            BIGINT NOT NULL,
+  replication_lag_p99            BIGINT,
+  apply_lag_min                  BIGINT NOT NULL,
+  apply_lag_avg                  BIGINT NOT NULL,
+  apply_lag_max                  BIGINT NOT NULL,
+  apply_lag_p99                  BIGINT,
+  PRIMARY KEY (standby_node_id, bucket_start)
+);
+
+CREATE TABLE repmgr.primary_heartbeat (
+  node_id                        INTEGER NOT NULL PRIMARY KEY,
+  heartbeat_time                 TIMESTAMP WITH TIME ZONE NOT NULL
+);
+
 CREATE VIEW repmgr.show_nodes AS
    SELECT n.node_id,
           n.node_name,
@@ -126,6 +185,11 @@ CREATE FUNCTION get_upstream_last_seen()
   AS 'MODULE_PATHNAME', 'get_upstream_last_seen'
   LANGUAGE C STRICT;
 
+CREATE FUNCTION get_upstream_last_seen_ms()
+  RETURNS BIGINT
+  AS 'MODULE_PATHNAME', 'get_upstream_last_seen_ms'
+  LANGUAGE C STRICT;
+
 CREATE FUNCTION get_upstream_node_id()
   RETURNS INT
   AS 'MODULE_PATHNAME', 'get_upstream_node_id'
@@ -178,6 +242,11 @@ CREATE FUNCTION set_repmgrd_pid(INT, TEXT)
   AS 'MODULE_PATHNAME', 'set_repmgrd_pid'
   LANGUAGE C STRICT;
 
+CREATE FUNCTION set_repmgrd_wakeup_signal(BOOL)
+  RETURNS VOID
+  AS 'MODULE_PATHNAME', 'set_repmgrd_wakeup_signal'
+  LANGUAGE C STRICT;
+
 CREATE FUNCTION repmgrd_is_running()
   RETURNS BOOL
   AS 'MODULE_PATHNAME', 'repmgrd_is_running'
@@ -198,6 +267,189 @@ CREATE FUNCTION get_wal_receiver_pid()
   AS 'MODULE_PATHNAME', 'get_wal_receiver_pid'
   LANGUAGE C STRICT;
 
+/* monitoring history functions */
+
+/*
+ * Used by repmgrd and "repmgr cluster cleanup". The type of the LSN
+ * parameters, and whether lag percentiles can be calculated (ordered-set
+ * aggregates are available from PostgreSQL 9.4), depend on the server
+ * version.
+ */
+
+DO $repmgr$
+DECLARE
+  DECLARE server_version_num INT;
+  DECLARE lsn_type TEXT;
+  DECLARE replication_lag_p99 TEXT;
+  DECLARE apply_lag_p99 TEXT;
+BEGIN
+  SELECT setting
+    FROM pg_catalog.pg_settings
+   WHERE name = 'server_version_num'
+    INTO server_version_num;
+  IF server_version_num >= 90400 THEN
+    lsn_type := 'PG_LSN';
+    replication_lag_p99 := 'pg_catalog.percentile_disc(0.99) WITHIN GROUP (ORDER BY h.replication_lag)';
+    apply_lag_p99 := 'pg_catalog.percentile_disc(0.99) WITHIN GROUP (ORDER BY h.apply_lag)';
+  ELSE
+    lsn_type := 'TEXT';
+    replication_lag_p99 := 'NULL::BIGINT';
+    apply_lag_p99 := 'NULL::BIGINT';
+  END IF;
+
+  /*
+   * Append a record to "repmgr.monitoring_history" and update the standby's
+   * row in "repmgr.monitoring_latest"; writable CTEs are used as
+   * INSERT ... ON CONFLICT is not available before PostgreSQL 9.5.
+   */
+  EXECUTE pg_catalog.format($repmgr_func$
+CREATE FUNCTION repmgr.add_monitoring_record(INT, INT, TIMESTAMP WITH TIME ZONE, TIMESTAMP WITH TIME ZONE, %1$s, %1$s, BIGINT, BIGINT)
+  RETURNS VOID
+AS $fn$
+WITH history AS (
+  INSERT INTO repmgr.monitoring_history
+              (primary_node_id, standby_node_id, last_monitor_time,
+               last_apply_time, last_wal_primary_location,
+               last_wal_standby_location, replication_lag, apply_lag)
+       VALUES ($1, $2, $3, $4, $5, $6, $7, $8)
+    RETURNING *
+),
+latest AS (
+     UPDATE repmgr.monitoring_latest l
+        SET primary_node_id = h.primary_node_id,
+            last_monitor_time = h.last_monitor_time,
+            last_apply_time = h.last_apply_time,
+            last_wal_primary_location = h.last_wal_primary_location,
+            last_wal_standby_location = h.last_wal_standby_location,
+            replication_lag = h.replication_lag,
+            apply_lag = h.apply_lag
+       FROM history h
+      WHERE l.standby_node_id = h.standby_node_id
+  RETURNING l.standby_node_id
+)
+INSERT INTO repmgr.monitoring_latest
+            (primary_node_id, standby_node_id, last_monitor_time,
+             last_apply_time, last_wal_primary_location,
+             last_wal_standby_location, replication_lag, apply_lag)
+     SELECT h.primary_node_id, h.standby_node_id, h.last_monitor_time,
+            h.last_apply_time, h.last_wal_primary_location,
+            h.last_wal_standby_location, h.replication_lag, h.apply_lag
+       FROM history h
+      WHERE NOT EXISTS (SELECT 1 FROM latest)
+$fn$
+  LANGUAGE SQL
+    $repmgr_func$, lsn_type);
+
+  /*
+   * Summarise monitoring records into the per-minute and per-hour rollup
+   * tables. Only buckets which are complete (i.e. which end before the
+   * current time) and which are more recent than the last bucket already
+   * summarised for each standby are added, so this can be executed
+   * repeatedly; it must be executed before records are deleted.
+   */
+  EXECUTE pg_catalog.format($repmgr_func$
+CREATE FUNCTION repmgr.update_monitoring_rollups()
+  RETURNS VOID
+AS $fn$
+INSERT INTO repmgr.monitoring_history_minute
+            (standby_node_id, bucket_start, sample_count,
+             replication_lag_min, replication_lag_avg,
+             replication_lag_max, replication_lag_p99,
+             apply_lag_min, apply_lag_avg,
+             apply_lag_max, apply_lag_p99)
+     SELECT h.standby_node_id,
+            pg_catalog.date_trunc('minute', h.last_monitor_time),
+            pg_catalog.count(*),
+            pg_catalog.min(h.replication_lag),
+            pg_catalog.avg(h.replication_lag)::BIGINT,
+            pg_catalog.max(h.replication_lag),
+            %1$s,
+            pg_catalog.min(h.apply_lag),
+            pg_catalog.avg(h.apply_lag)::BIGINT,
+            pg_catalog.max(h.apply_lag),
+            %2$s
+       FROM repmgr.monitoring_history h
+  LEFT JOIN (SELECT standby_node_id, pg_catalog.max(bucket_start) AS last_bucket_start
+               FROM repmgr.monitoring_history_minute
+           GROUP BY standby_node_id) r
+         ON r.standby_node_id = h.standby_node_id
+      WHERE h.last_monitor_time < pg_catalog.date_trunc('minute', pg_catalog.now())
+        AND (r.last_bucket_start IS NULL
+             OR h.last_monitor_time >= r.last_bucket_start + '1 minute'::INTERVAL)
+   GROUP BY 1, 2;
+
+INSERT INTO repmgr.monitoring_history_hour
+            (standby_node_id, bucket_start, sample_count,
+             replication_lag_min, replication_lag_avg,
+             replication_lag_max, replication_lag_p99,
+             apply_lag_min, apply_lag_avg,
+             apply_lag_max, apply_lag_p99)
+     SELECT h.standby_node_id,
+            pg_catalog.date_trunc('hour', h.last_monitor_time),
+            pg_catalog.count(*),
+            pg_catalog.min(h.replication_lag),
+            pg_catalog.avg(h.replication_lag)::BIGINT,
+            pg_catalog.max(h.replication_lag),
+            %1$s,
+            pg_catalog.min(h.apply_lag),
+            pg_catalog.avg(h.apply_lag)::BIGINT,
+            pg_catalog.max(h.apply_lag),
+            %2$s
+       FROM repmgr.monitoring_history h
+  LEFT JOIN (SELECT standby_node_id, pg_catalog.max(bucket_start) AS last_bucket_start
+               FROM repmgr.monitoring_history_hour
+           GROUP BY standby_node_id) r
+         ON r.standby_node_id = h.standby_node_id
+      WHERE h.last_monitor_time < pg_catalog.date_trunc('hour', pg_catalog.now())
+        AND (r.last_bucket_start IS NULL
+             OR h.last_monitor_time >= r.last_bucket_start + '1 hour'::INTERVAL)
+   GROUP BY 1, 2
+$fn$
+  LANGUAGE SQL
+    $repmgr_func$, replication_lag_p99, apply_lag_p99);
+END$repmgr$;
+
+/*
+ * Determine whether a monitoring record for standby $1 recorded at $2 can
+ * be deleted: it must be at least $3 days old and, if $4 is not NULL, be
+ * for that standby. It must also have been summarised:
+ * update_monitoring_rollups() only adds complete buckets, so records from
+ * after the end of the standby's most recent hourly bucket are retained
+ * until the hour has been summarised, otherwise that hour would later be
+ * summarised from a partial set of samples.
+ */
+CREATE FUNCTION monitoring_record_can_be_deleted(INT, TIMESTAMP WITH TIME ZONE, INT, INT)
+  RETURNS BOOL
+AS $fn$
+SELECT pg_catalog.age(pg_catalog.now(), $2) >= $3 * '1 day'::INTERVAL
+   AND $2 < (SELECT pg_catalog.max(r.bucket_start) + '1 hour'::INTERVAL
+               FROM repmgr.monitoring_history_hour r
+              WHERE r.standby_node_id = $1)
+   AND ($4 IS NULL OR $1 = $4)
+$fn$
+  LANGUAGE SQL STABLE;
+
+CREATE FUNCTION get_monitoring_records_to_delete(INT, INT)
+  RETURNS BIGINT
+AS $fn$
+SELECT pg_catalog.count(*)
+  FROM repmgr.monitoring_history h
+ WHERE repmgr.monitoring_record_can_be_deleted(h.standby_node_id, h.last_monitor_time, $1, $2)
+$fn$
+  LANGUAGE SQL STABLE;
+
+CREATE FUNCTION delete_monitoring_records(INT, INT)
+  RETURNS BIGINT
+AS $fn$
+WITH deleted AS (
+  DELETE FROM repmgr.monitoring_history h
+        WHERE repmgr.monitoring_record_can_be_deleted(h.standby_node_id, h.last_monitor_time, $1, $2)
+    RETURNING 1
+)
+SELECT pg_catalog.count(*) FROM deleted
+$fn$
+  LANGUAGE SQL;
+
 
 
 
@@ -215,10 +467,6 @@ CREATE VIEW repmgr.replication_status AS
          END AS replication_time_lag,
          CASE WHEN n.type='standby' THEN pg_catalog.pg_size_pretty(m.apply_lag) ELSE NULL END AS apply_lag,
          AGE(NOW(), CASE WHEN pg_catalog.pg_is_in_recovery() THEN repmgr.standby_get_last_updated() ELSE m.last_monitor_time END) AS communication_time_lag
-    FROM repmgr.monitoring_history m
-    JOIN repmgr.nodes n ON m.standby_node_id = n.node_id
-   WHERE (m.standby_node_id, m.last_monitor_time) IN (
-	          SELECT m1.standby_node_id, MAX(m1.last_monitor_time)
-			    FROM repmgr.monitoring_history m1 GROUP BY 1
-         );
+    FROM repmgr.monitoring_latest m
+    JOIN repmgr.nodes n ON m.standby_node_id = n.node_id;
 
@@ -1324,6 +1324,18 @@ do_cluster_cleanup(void)
 
 	PQfinish(conn);
 
+	/*
+	 * Summarise monitoring records before any are deleted, so long-range
+	 * lag trends remain available after the raw records have been purged.
+	 */
+	if (update_monitoring_rollups(primary_conn) == false)
+	{
+		log_error(_("unable to update monitoring history rollups"));
+		log_hint(_("no monitoring records have been deleted"));
+		PQfinish(primary_conn);
+		exit(ERR_DB_QUERY);
+	}
+
 	log_debug(_("number of days of monitoring history to retain: %i"), runtime_options.keep_history);
 
 	entries_to_delete = get_number_of_monitoring_records_to_delete(primary_conn,
@@ -1470,6 +1482,8 @@ do_cluster_help(void)
 	printf(_("CLUSTER CLEANUP\n"));
 	puts("");
 	printf(_("  \"cluster cleanup\" purges records from the \"repmgr.monitoring_history\" table.\n"));
+	printf(_("  Records are first summarised into the \"repmgr.monitoring_history_minute\" and\n"));
+	printf(_("  \"repmgr.monitoring_history_hour\" tables.\n"));
 	puts("");
 	printf(_("    -k, --keep-history=VALUE  retain indicated number of days of history (default: 0)\n"));
 	puts("");
@@ -32,14 +32,15 @@
 #include "repmgr-action-node.h"
 #include "repmgr-action-standby.h"
 
-static bool copy_file(const char *src_file, const char *dest_file);
 static void format_archive_dir(PQExpBufferData *archive_dir);
 static t_server_action parse_server_action(const char *action);
 
 static void _do_node_service_list_actions(t_server_action action);
 static void _do_node_status_is_shutdown_cleanly(void);
+static NodeStatus _get_node_shutdown_status(XLogRecPtr *checkPoint);
 static void _do_node_archive_config(void);
 static void _do_node_restore_config(void);
+static bool run_pg_rewind_with_progress(const char *command, PQExpBufferData *outputbuf);
 
 static void do_node_check_replication_connection(void);
 static CheckStatus do_node_check_archive_ready(PGconn *conn, OutputMode mode, CheckStatusList *list_output);
@@ -589,15 +590,20 @@ do_node_status(void)
  *
  * --status=(RUNNING|SHUTDOWN|UNCLEAN_SHUTDOWN|UNKNOWN)
  * --last-checkpoint=...
+ *
+ * If -w/--wait is provided, rather than returning the current state
+ * immediately, the data directory is polled at short intervals until
+ * the node is either cleanly shut down or has stopped uncleanly, or the
+ * timeout (--wait=SECS, default "shutdown_check_timeout") expires. This
+ * enables "standby switchover" to detect the shutdown of the primary with
+ * a single remote invocation, rather than an SSH round-trip per check.
  */
 
 static void
 _do_node_status_is_shutdown_cleanly(void)
 {
-	PGPing		ping_status;
 	PQExpBufferData output;
 
-	DBState		db_state;
 	XLogRecPtr	checkPoint = InvalidXLogRecPtr;
 
 	NodeStatus	node_status = NODE_STATUS_UNKNOWN;
@@ -616,6 +622,63 @@ _do_node_status_is_shutdown_cleanly(void)
 		return;
 	}
 
+	node_status = _get_node_shutdown_status(&checkPoint);
+
+	if (runtime_options.wait_provided == true)
+	{
+		int			timeout = runtime_options.wait;
+		instr_time	start_time;
+
+		if (timeout < 0)
+			timeout = config_file_options.shutdown_check_timeout;
+
+		INSTR_TIME_SET_CURRENT(start_time);
+
+		while (node_status != NODE_STATUS_DOWN && node_status != NODE_STATUS_UNCLEAN_SHUTDOWN)
+		{
+			instr_time	elapsed;
+
+			INSTR_TIME_SET_CURRENT(elapsed);
+			INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+			if (INSTR_TIME_GET_DOUBLE(elapsed) >= timeout)
+				break;
+
+			pg_usleep(SHUTDOWN_CHECK_POLL_INTERVAL_MS * 1000L);
+
+			node_status = _get_node_shutdown_status(&checkPoint);
+		}
+	}
+
+	appendPQExpBuffer(&output,
+					  "%s", print_node_status(node_status));
+
+	if (node_status == NODE_STATUS_DOWN)
+	{
+		appendPQExpBuffer(&output,
+						  " --last-checkpoint-lsn=%X/%X",
+						  format_lsn(checkPoint));
+	}
+
+	printf("%s\n", output.data);
+	termPQExpBuffer(&output);
+	return;
+}
+
+
+/*
+ * Determine the node's running state from a combination of PQping()
+ * and the contents of pg_control; "checkPoint" is set to the latest
+ * checkpoint location.
+ */
+static NodeStatus
+_get_node_shutdown_status(XLogRecPtr *checkPoint)
+{
+	PGPing		ping_status;
+	DBState		db_state;
+
+	NodeStatus	node_status = NODE_STATUS_UNKNOWN;
+
 	ping_status = PQping(config_file_options.conninfo);
 
 	switch (ping_status)
@@ -651,10 +714,10 @@ _do_node_status_is_shutdown_cleanly(void)
 		}
 	}
 
-	checkPoint = get_latest_checkpoint_location(config_file_options.data_directory);
+	*checkPoint = get_latest_checkpoint_location(config_file_options.data_directory);
 
 	/* unable to read pg_control, don't know what's happening */
-	if (checkPoint == InvalidXLogRecPtr)
+	if (*checkPoint == InvalidXLogRecPtr)
 	{
 		node_status = NODE_STATUS_UNKNOWN;
 	}
@@ -671,19 +734,7 @@ _do_node_status_is_shutdown_cleanly(void)
 	log_verbose(LOG_DEBUG, "node status determined as: %s",
 				print_node_status(node_status));
 
-	appendPQExpBuffer(&output,
-					  "%s", print_node_status(node_status));
-
-	if (node_status == NODE_STATUS_DOWN)
-	{
-		appendPQExpBuffer(&output,
-						  " --last-checkpoint-lsn=%X/%X",
-						  format_lsn(checkPoint));
-	}
-
-	printf("%s\n", output.data);
-	termPQExpBuffer(&output);
-	return;
+	return node_status;
 }
 
 /*
@@ -2147,6 +2198,7 @@ do_node_rejoin(void)
 	PQExpBufferData follow_output;
 	struct stat statbuf;
 	t_node_info primary_node_record = T_NODE_INFO_INITIALIZER;
+	bool		rewind_required = false;
 
 	bool		success = true;
 	int			follow_error_code = SUCCESS;
@@ -2279,7 +2331,8 @@ do_node_rejoin(void)
 										   min_recovery_location,
 										   primary_conn,
 										   &primary_node_record,
-										   true);
+										   true,
+										   &rewind_required);
 
 		if (can_follow == false)
 		{
@@ -2288,13 +2341,20 @@ do_node_rejoin(void)
 		}
 	}
 
+	if (runtime_options.force_rewind_used == true && rewind_required == false)
+	{
+		log_notice(_("pg_rewind execution not required for this node to attach to rejoin target node %i"),
+				   primary_node_record.node_id);
+		log_detail(_("--force-rewind provided, but this node's timeline has not diverged from the rejoin target's"));
+	}
 
 	/*
-	 * --force-rewind specified - check prerequisites, and attempt to execute
-  	 * (if --dry-run provided, just output the command which would be executed)
+	 * --force-rewind specified and required - check prerequisites, and attempt
+	 * to execute (if --dry-run provided, just output the command which would be
+	 * executed)
 	 */
 
-	if (runtime_options.force_rewind_used == true)
+	if (rewind_required == true)
 	{
 		PQExpBufferData msg;
 		PQExpBufferData	filebuf;
@@ -2361,6 +2421,8 @@ do_node_rejoin(void)
 						  " --source-server='%s'",
 						  primary_node_record.conninfo);
 
+		appendPQExpBufferStr(&command, " --progress");
+
 		if (runtime_options.dry_run == true)
 		{
 			log_info(_("pg_rewind would now be executed"));
@@ -2375,8 +2437,8 @@ do_node_rejoin(void)
 
 			initPQExpBuffer(&command_output);
 
-			ret = local_command(command.data,
-								&command_output);
+			ret = run_pg_rewind_with_progress(command.data,
+											  &command_output);
 
 			termPQExpBuffer(&command);
 
@@ -2623,7 +2685,7 @@ do_node_rejoin(void)
 	 *  - if a slot for the new upstream exists, delete that
 	 *  - warn about any other inactive replication slots
 	 */
-	if (runtime_options.force_rewind_used == false && config_file_options.use_replication_slots)
+	if (rewind_required == false && config_file_options.use_replication_slots)
 	{
 		PGconn	   *local_conn = NULL;
 		local_conn = establish_db_connection(config_file_options.conninfo, false);
@@ -2700,7 +2762,7 @@ do_node_control(void)
 
 	if (runtime_options.disable_wal_receiver == true)
 	{
-		wal_receiver_pid = disable_wal_receiver(conn);
+		wal_receiver_pid = disable_wal_receiver(conn, config_file_options.standby_disconnect_timeout);
 
 		PQfinish(conn);
 
@@ -2712,7 +2774,7 @@ do_node_control(void)
 
 	if (runtime_options.enable_wal_receiver == true)
 	{
-		wal_receiver_pid = enable_wal_receiver(conn, true);
+		wal_receiver_pid = enable_wal_receiver(conn, true, config_file_options.standby_disconnect_timeout);
 
 		PQfinish(conn);
 
@@ -2929,8 +2991,16 @@ _do_node_archive_config(void)
 			{
 				log_verbose(LOG_DEBUG, "copying \"%s\" to \"%s\"",
 							cell->key, dest_file.data);
-				copy_file(cell->value, dest_file.data);
-				copied_count++;
+
+				if (copy_file(cell->value, dest_file.data) == false)
+				{
+					log_warning(_("unable to copy \"%s\" to \"%s\""),
+								cell->value, dest_file.data);
+				}
+				else
+				{
+					copied_count++;
+				}
 			}
 		}
 
@@ -3015,6 +3085,7 @@ _do_node_restore_config(void)
 		struct stat statbuf;
 		PQExpBufferData		src_file_path;
 		PQExpBufferData		dest_file_path;
+		char		target_file[MAXPGPATH] = "";
 
 		initPQExpBuffer(&src_file_path);
 
@@ -3040,16 +3111,39 @@ _do_node_restore_config(void)
 		log_verbose(LOG_DEBUG, "copying \"%s\" to \"%s\"",
 					src_file_path.data, dest_file_path.data);
 
-		if (copy_file(src_file_path.data, dest_file_path.data) == false)
+		/*
+		 * The archived file is removed after copying, so if the archive
+		 * directory is on the same filesystem, just move it; if the file in
+		 * the data directory is a symbolic link, the file it points to is
+		 * replaced, retaining that file's mode.
+		 */
+		if (resolve_file_symlink(dest_file_path.data, target_file) == false)
 		{
 			copy_ok = false;
-			log_warning(_("unable to copy \"%s\" to \"%s\""),
-						arcdir_ent->d_name, runtime_options.data_dir);
+			log_warning(_("unable to resolve symbolic link \"%s\""),
+						dest_file_path.data);
 		}
 		else
 		{
-			unlink(src_file_path.data);
-			copied_count++;
+			/* retain the mode of the file being replaced */
+			if (stat(target_file, &statbuf) == 0)
+				(void) chmod(src_file_path.data, statbuf.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO));
+
+			if (rename(src_file_path.data, target_file) == 0)
+			{
+				copied_count++;
+			}
+			else if (copy_file(src_file_path.data, dest_file_path.data) == false)
+			{
+				copy_ok = false;
+				log_warning(_("unable to copy \"%s\" to \"%s\""),
+							arcdir_ent->d_name, runtime_options.data_dir);
+			}
+			else
+			{
+				unlink(src_file_path.data);
+				copied_count++;
+			}
 		}
 
 		termPQExpBuffer(&dest_file_path);
@@ -3091,61 +3185,167 @@ _do_node_restore_config(void)
 }
 
 
-static void
-format_archive_dir(PQExpBufferData *archive_dir)
+/*
+ * Execute pg_rewind (which must have been provided with --progress) and
+ * parse the progress reports it writes to stderr, logging them as the
+ * rewind proceeds, e.g.:
+ *
+ *     12345/67890 kB (18%) copied
+ *
+ * Other output from pg_rewind (which describes the phase currently
+ * being executed) is logged at INFO level with --verbose and collected in
+ * "outputbuf".
+ */
+static bool
+run_pg_rewind_with_progress(const char *command, PQExpBufferData *outputbuf)
 {
-	appendPQExpBuffer(archive_dir,
-					  "%s/repmgr-config-archive-%s",
-					  runtime_options.config_archive_dir,
-					  config_file_options.node_name);
+	PQExpBufferData command_buf;
+	PQExpBufferData line;
+	FILE	   *fp = NULL;
+	char		buf[MAXLEN];
+	ssize_t		bytes_read = 0;
+	int			retval = 0;
+	int			i = 0;
 
-	log_verbose(LOG_DEBUG, "using archive directory \"%s\"", archive_dir->data);
-}
+	long long	done_kb = 0;
+	long long	total_kb = 0;
+	int			percent = 0;
+	int			last_logged_percent = -1;
 
+	instr_time	start_time;
+	instr_time	elapsed;
 
-static bool
-copy_file(const char *src_file, const char *dest_file)
-{
-	FILE	   *ptr_old,
-			   *ptr_new;
-	int			a = 0;
+	initPQExpBuffer(&command_buf);
+	appendPQExpBuffer(&command_buf, "%s 2>&1", command);
 
-	ptr_old = fopen(src_file, "r");
+	log_verbose(LOG_DEBUG, "executing:\n  %s", command_buf.data);
 
-	if (ptr_old == NULL)
-		return false;
+	fp = popen(command_buf.data, "r");
 
-	ptr_new = fopen(dest_file, "w");
+	termPQExpBuffer(&command_buf);
 
-	if (ptr_new == NULL)
+	if (fp == NULL)
 	{
-		fclose(ptr_old);
+		log_error(_("unable to execute local command:\n%s"), command);
 		return false;
 	}
 
-	chmod(dest_file, S_IRUSR | S_IWUSR);
+	INSTR_TIME_SET_CURRENT(start_time);
 
-	while (1)
+	initPQExpBuffer(&line);
+
+	/*
+	 * pg_rewind terminates progress lines with "\r" if stderr is a terminal,
+	 * otherwise with "\n", so handle both.
+	 */
+	for (;;)
 	{
-		a = fgetc(ptr_old);
+		bool		eof = false;
+
+		bytes_read = read(fileno(fp), buf, sizeof(buf));
 
-		if (!feof(ptr_old))
+		if (bytes_read < 0)
 		{
-			fputc(a, ptr_new);
+			if (errno == EINTR)
+				continue;
+			break;
 		}
-		else
+
+		if (bytes_read == 0)
 		{
-			break;
+			/* handle the final line, if unterminated */
+			eof = true;
+			buf[0] = '\n';
+			bytes_read = 1;
+		}
+
+		for (i = 0; i < bytes_read; i++)
+		{
+			if (buf[i] != '\r' && buf[i] != '\n')
+			{
+				appendPQExpBufferChar(&line, buf[i]);
+				continue;
+			}
+
+			if (line.len == 0)
+				continue;
+
+			if (sscanf(line.data, " %lld/%lld kB (%d%%) copied",
+					   &done_kb, &total_kb, &percent) == 3)
+			{
+				/* log at most once per 10% */
+				if (percent / 10 > last_logged_percent / 10 || last_logged_percent < 0)
+				{
+					INSTR_TIME_SET_CURRENT(elapsed);
+					INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+					log_info(_("pg_rewind progress: %.1f of %.1f MB (%i%%) copied after %.1f seconds"),
+							 (double) done_kb / 1024,
+							 (double) total_kb / 1024,
+							 percent,
+							 INSTR_TIME_GET_DOUBLE(elapsed));
+
+					last_logged_percent = percent;
+				}
+			}
+			else
+			{
+				log_verbose(LOG_INFO, "pg_rewind: %s", line.data);
+				appendPQExpBuffer(outputbuf, "%s\n", line.data);
+			}
+
+			resetPQExpBuffer(&line);
 		}
+
+		if (eof == true)
+			break;
 	}
 
-	fclose(ptr_new);
-	fclose(ptr_old);
+	termPQExpBuffer(&line);
+
+	retval = pclose(fp);
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+	if (retval == -1)
+	{
+		log_error(_("unable to obtain pg_rewind's exit status"));
+		log_detail("%s", strerror(errno));
+		return false;
+	}
+
+	if (WIFSIGNALED(retval))
+	{
+		log_error(_("pg_rewind was terminated by signal %i"), WTERMSIG(retval));
+		return false;
+	}
+
+	log_verbose(LOG_DEBUG, "result of command was %i (%i)", WEXITSTATUS(retval), retval);
+
+	if (!WIFEXITED(retval) || WEXITSTATUS(retval) != 0)
+		return false;
+
+	log_info(_("pg_rewind copied %.1f MB in %.1f seconds"),
+			 (double) done_kb / 1024,
+			 INSTR_TIME_GET_DOUBLE(elapsed));
 
 	return true;
 }
 
 
+static void
+format_archive_dir(PQExpBufferData *archive_dir)
+{
+	appendPQExpBuffer(archive_dir,
+					  "%s/repmgr-config-archive-%s",
+					  runtime_options.config_archive_dir,
+					  config_file_options.node_name);
+
+	log_verbose(LOG_DEBUG, "using archive directory \"%s\"", archive_dir->data);
+}
+
+
 void
 do_node_help(void)
 {
@@ -54,9 +54,15 @@ typedef struct
 	int			unreachable_sibling_node_count;
 	int			min_required_wal_senders;
 	int			min_required_free_slots;
+	int			followed_sibling_node_count;
+	int			failed_follow_sibling_node_count;
+	int			timed_out_follow_sibling_node_count;
 } SiblingNodeStats;
 
 #define T_SIBLING_NODES_STATS_INITIALIZER { \
+	0, \
+	0, \
+	0, \
 	0, \
 	0, \
 	0, \
@@ -64,6 +70,83 @@ typedef struct
 	0 \
 }
 
+
+/*
+ * Most recent progress report emitted by "pg_basebackup --progress".
+ * "total_kb" is -1 if pg_basebackup was not able to provide an estimate.
+ */
+typedef struct
+{
+	int64		done_kb;
+	int64		total_kb;
+	int			percent;
+	int			tablespaces_done;
+	int			tablespaces_total;
+} t_basebackup_progress;
+
+#define T_BASEBACKUP_PROGRESS_INITIALIZER { 0, -1, 0, 0, 0 }
+
+/* interval at which concurrent "standby follow" commands are checked */
+#define SIBLING_FOLLOW_POLL_INTERVAL_MS 100
+#define WAL_RECEIVER_RESTART_POLL_INTERVAL_MS 100
+#define PROMOTE_CHECK_MIN_INTERVAL_MS 10
+#define PROMOTE_CHECK_MAX_INTERVAL_MS 1000
+
+/* minimum interval between "--progress=text" log lines (seconds) */
+#define BASEBACKUP_PROGRESS_LOG_INTERVAL 10
+
+
+/*
+ * A single rsync invocation executed by run_parallel_file_backup(); one is
+ * created for the data directory and one for each tablespace.
+ */
+typedef struct
+{
+	char		remote_path[MAXPGPATH];
+	char		local_path[MAXPGPATH];
+	pid_t		pid;
+	int			exit_code;
+	instr_time	start_time;
+} t_file_copy_job;
+
+/*
+ * Wall-clock timings collected during "standby switchover" for the
+ * --timing report; "remote_checks" records the latency of each command
+ * executed on the demotion candidate.
+ */
+#define SWITCHOVER_TIMING_MAX_ITEMS 32
+
+typedef struct
+{
+	const char *name;
+	double		elapsed_secs;
+} t_switchover_timing_item;
+
+typedef struct
+{
+	instr_time	start_time;
+	instr_time	phase_start_time;
+	const char *current_phase;
+	int			phase_count;
+	t_switchover_timing_item phases[SWITCHOVER_TIMING_MAX_ITEMS];
+	int			remote_check_count;
+	t_switchover_timing_item remote_checks[SWITCHOVER_TIMING_MAX_ITEMS];
+} t_switchover_timing;
+
+/*
+ * A "standby follow" (or "witness register") executed via SSH on a sibling
+ * node by sibling_nodes_follow(); up to "sibling_nodes_follow_concurrency"
+ * of these are run at the same time.
+ */
+typedef struct
+{
+	t_node_info *node_info;
+	pid_t		pid;
+	instr_time	start_time;
+	bool		success;
+	bool		timed_out;
+} t_sibling_follow_job;
+
 static PGconn *primary_conn = NULL;
 static PGconn *source_conn = NULL;
 
@@ -85,6 +168,9 @@ static t_configfile_list config_files = T_CONFIGFILE_LIST_INITIALIZER;
 
 static standy_clone_mode mode = pg_basebackup;
 
+/* used by "standby switchover --timing" */
+static t_switchover_timing switchover_timing;
+
 /* used by barman mode */
 static char local_repmgr_tmp_directory[MAXPGPATH] = "";
 static char datadir_list_filename[MAXLEN] = "";
@@ -102,7 +188,14 @@ static void check_recovery_type(PGconn *conn);
 
 static void initialise_direct_clone(t_node_info *node_record);
 static int	run_basebackup(t_node_info *node_record);
+static int	run_basebackup_with_progress(const char *script);
+static bool parse_basebackup_progress(const char *line, t_basebackup_progress *progress);
+static void report_basebackup_progress(t_basebackup_progress *progress, double elapsed, double bytes_per_sec);
 static int	run_file_backup(t_node_info *node_record);
+static int	run_parallel_file_backup(t_node_info *node_record);
+static bool start_file_copy_job(t_file_copy_job *job);
+static bool write_backup_file(const char *filename, const char *contents);
+static void move_replication_slot_to_upstream(t_node_info *node_record);
 
 static void copy_configuration_files(bool delete_after_copy);
 
@@ -114,11 +207,22 @@ static char *make_barman_ssh_command(char *buf);
 
 static bool create_recovery_file(t_node_info *node_record, t_conninfo_param_list *primary_conninfo, char *dest, bool as_file);
 static void write_primary_conninfo(PQExpBufferData *dest, t_conninfo_param_list *param_list);
+static void build_primary_conninfo(PQExpBufferData *conninfo_buf, t_conninfo_param_list *param_list);
+static bool wait_for_promotion(PGconn *conn, int timeout, RecoveryType *recovery_type);
+static bool switch_upstream_via_reload(t_node_info *node_record, t_conninfo_param_list *primary_conninfo, bool *settings_applied);
+static bool wal_receiver_matches_upstream(t_wal_receiver_info *wal_receiver_info, t_conninfo_param_list *primary_conninfo);
 static bool check_sibling_nodes(NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats);
 static bool check_free_wal_senders(int available_wal_senders, SiblingNodeStats *sibling_nodes_stats, bool *dry_run_success);
 static bool check_free_slots(t_node_info *local_node_record, SiblingNodeStats *sibling_nodes_stats, bool *dry_run_success);
 
 static void sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats);
+static bool start_sibling_follow_job(t_sibling_follow_job *job, t_node_info *local_node_record);
+static int	calculate_elapsed_seconds(instr_time start_time);
+
+static void switchover_timing_phase(const char *phase);
+static void switchover_timing_remote_check(const char *check, instr_time start_time);
+static bool switchover_remote_command(const char *check, const char *host, const char *command, PQExpBufferData *outputbuf);
+static void report_switchover_timing(bool success);
 
 static NodeStatus parse_node_status_is_shutdown_cleanly(const char *node_status_output, XLogRecPtr *checkPoint);
 static CheckStatus parse_node_check_archiver(const char *node_check_output, int *files, int *threshold);
@@ -142,6 +246,8 @@ static bool parse_data_directory_config(const char *node_check_output);
  *  --replication-user (only required if no upstream record)
  *  --without-barman
  *  --recovery-conf-only
+ *  --progress
+ *  --parallel-tablespaces
  */
 
 void
@@ -419,6 +525,37 @@ do_standby_clone(void)
 		}
 	}
 
+	/*
+	 * In rsync mode, files are copied from the source node via SSH within a
+	 * non-exclusive backup, which is only available from PostgreSQL 9.6.
+	 */
+	if (mode == rsync)
+	{
+		if (source_server_version_num < 90600)
+		{
+			log_error(_("--parallel-tablespaces requires PostgreSQL 9.6 or later"));
+			PQfinish(source_conn);
+			exit(ERR_BAD_CONFIG);
+		}
+
+		log_verbose(LOG_INFO, _("checking SSH connection to host \"%s\""),
+					runtime_options.host);
+
+		if (test_ssh_connection(runtime_options.host, runtime_options.remote_user) != 0)
+		{
+			log_error(_("remote host \"%s\" is not reachable via SSH - unable to clone with --parallel-tablespaces"),
+					  runtime_options.host);
+			PQfinish(source_conn);
+			exit(ERR_BAD_CONFIG);
+		}
+
+		if (config_file_options.use_replication_slots == false)
+		{
+			log_warning(_("replication slots are not in use"));
+			log_detail(_("the standby will need to retrieve WAL generated during the clone from its upstream"));
+		}
+	}
+
 	/*
 	 * If copying of external configuration files requested, and any are
 	 * detected, perform sanity checks
@@ -577,7 +714,7 @@ do_standby_clone(void)
 			log_warning(_("unable to determine a valid upstream node id"));
 		}
 
-		if (mode == pg_basebackup && runtime_options.fast_checkpoint == false)
+		if (mode != barman && runtime_options.fast_checkpoint == false)
 		{
 			log_hint(_("consider using the -c/--fast-checkpoint option"));
 		}
@@ -598,6 +735,9 @@ do_standby_clone(void)
 		case pg_basebackup:
 			log_notice(_("starting backup (using pg_basebackup)..."));
 			break;
+		case rsync:
+			log_notice(_("starting backup (using rsync, copying tablespaces in parallel)..."));
+			break;
 		case barman:
 			log_notice(_("retrieving backup from Barman..."));
 			break;
@@ -606,7 +746,7 @@ do_standby_clone(void)
 			log_error(_("unknown clone mode"));
 	}
 
-	if (mode == pg_basebackup)
+	if (mode != barman)
 	{
 		if (runtime_options.fast_checkpoint == false)
 		{
@@ -619,6 +759,9 @@ do_standby_clone(void)
 		case pg_basebackup:
 			r = run_basebackup(&local_node_record);
 			break;
+		case rsync:
+			r = run_parallel_file_backup(&local_node_record);
+			break;
 		case barman:
 			r = run_file_backup(&local_node_record);
 			break;
@@ -682,6 +825,10 @@ do_standby_clone(void)
 			log_notice(_("standby clone (using pg_basebackup) complete"));
 			break;
 
+		case rsync:
+			log_notice(_("standby clone (using rsync) complete"));
+			break;
+
 		case barman:
 			log_notice(_("standby clone (from Barman) complete"));
 			break;
@@ -763,6 +910,9 @@ do_standby_clone(void)
 		case pg_basebackup:
 			appendPQExpBufferStr(&event_details, "pg_basebackup");
 			break;
+		case rsync:
+			appendPQExpBufferStr(&event_details, "rsync");
+			break;
 		case barman:
 			appendPQExpBufferStr(&event_details, "barman");
 			break;
@@ -2267,8 +2417,10 @@ do_standby_promote(void)
 static void
 _do_standby_promote_internal(PGconn *conn)
 {
-	int			i;
 	bool		promote_success = false;
+	instr_time	promote_start_time;
+	instr_time	promote_elapsed;
+	int			remaining_timeout;
 	PQExpBufferData details;
 
 	RecoveryType recovery_type = RECTYPE_UNKNOWN;
@@ -2297,14 +2449,19 @@ _do_standby_promote_internal(PGconn *conn)
 	 * Promote standby to primary.
 	 *
 	 * `pg_ctl promote` returns immediately and (prior to 10.0) has no -w
-	 * option so we can't be sure when or if the promotion completes. For now
-	 * we'll poll the server until the default timeout (60 seconds)
+	 * option so we can't be sure when or if the promotion completes; we'll
+	 * wait for it to complete in wait_for_promotion().
 	 *
-	 * For PostgreSQL 12+, use the pg_promote() function - note this is
-	 * experimental
+	 * For PostgreSQL 12+, use the pg_promote() function, which will itself
+	 * wait for promotion to complete - note this is experimental
 	 */
 	log_notice(_("promoting standby to primary"));
 
+	log_notice(_("waiting up to %i seconds (parameter \"promote_check_timeout\") for promotion to complete"),
+			   config_file_options.promote_check_timeout);
+
+	INSTR_TIME_SET_CURRENT(promote_start_time);
+
 	if (PQserverVersion(conn) >= 120000)
 	{
 		log_detail(_("promoting server \"%s\" (ID: %i) using pg_promote()"),
@@ -2312,11 +2469,13 @@ _do_standby_promote_internal(PGconn *conn)
 				   local_node_record.node_id);
 
 		/*
-		 * We'll check for promotion success ourselves, but will abort
-		 * if some unrecoverable error prevented the function from being
-		 * executed.
+		 * pg_promote() returns false if promotion did not complete within
+		 * the timeout, which wait_for_promotion() will confirm; if it
+		 * returns false before the timeout has expired, the function could
+		 * not be executed or was unable to trigger promotion.
 		 */
-		if (!promote_standby(conn, false, 0))
+		if (!promote_standby(conn, true, config_file_options.promote_check_timeout)
+			&& calculate_elapsed_seconds(promote_start_time) < config_file_options.promote_check_timeout)
 		{
 			log_error(_("unable to promote server from standby to primary"));
 			exit(ERR_PROMOTION_FAIL);
@@ -2342,20 +2501,10 @@ _do_standby_promote_internal(PGconn *conn)
 		}
 	}
 
-	log_notice(_("waiting up to %i seconds (parameter \"promote_check_timeout\") for promotion to complete"),
-			   config_file_options.promote_check_timeout);
-
-	for (i = 0; i < config_file_options.promote_check_timeout; i += config_file_options.promote_check_interval)
-	{
-		recovery_type = get_recovery_type(conn);
+	remaining_timeout = config_file_options.promote_check_timeout
+		- calculate_elapsed_seconds(promote_start_time);
 
-		if (recovery_type == RECTYPE_PRIMARY)
-		{
-			promote_success = true;
-			break;
-		}
-		sleep(config_file_options.promote_check_interval);
-	}
+	promote_success = wait_for_promotion(conn, remaining_timeout, &recovery_type);
 
 	if (promote_success == false)
 	{
@@ -2375,7 +2524,11 @@ _do_standby_promote_internal(PGconn *conn)
 		}
 	}
 
-	log_verbose(LOG_INFO, _("standby promoted to primary after %i second(s)"), i);
+	INSTR_TIME_SET_CURRENT(promote_elapsed);
+	INSTR_TIME_SUBTRACT(promote_elapsed, promote_start_time);
+
+	log_verbose(LOG_INFO, _("standby promoted to primary after %.2f second(s)"),
+				INSTR_TIME_GET_DOUBLE(promote_elapsed));
 
 	/* update node information to reflect new status */
 	if (update_node_record_set_primary(conn, config_file_options.node_id) == false)
@@ -2421,6 +2574,77 @@ _do_standby_promote_internal(PGconn *conn)
 }
 
 
+/*
+ * Wait up to "timeout" seconds for the local node to complete promotion.
+ *
+ * Rather than polling at a fixed interval, check at an initially short
+ * interval which is doubled after each unsuccessful check, up to a maximum of
+ * one second (or "promote_check_interval", if lower). Between checks the
+ * local pg_control file is read, which is cheap and tells us when the
+ * startup process has exited recovery; only then do we confirm via the
+ * database connection. If pg_control can't be read, the database is checked
+ * each time.
+ *
+ * Returns true if the node was promoted; "recovery_type" is set to the
+ * last recovery type reported by the node.
+ */
+static bool
+wait_for_promotion(PGconn *conn, int timeout, RecoveryType *recovery_type)
+{
+	instr_time	start_time;
+	long		interval_ms = PROMOTE_CHECK_MIN_INTERVAL_MS;
+	long		max_interval_ms = PROMOTE_CHECK_MAX_INTERVAL_MS;
+
+	if (config_file_options.promote_check_interval > 0 &&
+		config_file_options.promote_check_interval * 1000L < max_interval_ms)
+		max_interval_ms = config_file_options.promote_check_interval * 1000L;
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	for (;;)
+	{
+		instr_time	elapsed;
+		DBState		db_state = get_db_state(config_file_options.data_directory);
+
+		if (db_state != DB_IN_ARCHIVE_RECOVERY)
+		{
+			*recovery_type = get_recovery_type(conn);
+
+			if (*recovery_type == RECTYPE_PRIMARY)
+				return true;
+
+			if (*recovery_type == RECTYPE_UNKNOWN && PQstatus(conn) != CONNECTION_OK)
+				return false;
+		}
+		else
+		{
+			*recovery_type = RECTYPE_STANDBY;
+		}
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+		if (INSTR_TIME_GET_DOUBLE(elapsed) >= timeout)
+			break;
+
+		log_verbose(LOG_DEBUG, "wait_for_promotion(): database state is \"%s\", sleeping %li ms",
+					describe_db_state(db_state),
+					interval_ms);
+
+		pg_usleep(interval_ms * 1000L);
+
+		interval_ms *= 2;
+		if (interval_ms > max_interval_ms)
+			interval_ms = max_interval_ms;
+	}
+
+	/* final check, in case promotion completed during the last sleep */
+	*recovery_type = get_recovery_type(conn);
+
+	return *recovery_type == RECTYPE_PRIMARY;
+}
+
+
 /*
  * Follow a new primary.
  *
@@ -2772,7 +2996,8 @@ do_standby_follow(void)
 										   local_xlogpos,
 										   follow_target_conn,
 										   &follow_target_node_record,
-										   false);
+										   false,
+										   NULL);
 
 		if (can_follow == false)
 		{
@@ -2946,6 +3171,8 @@ do_standby_follow_internal(PGconn *primary_conn, PGconn *follow_target_conn, t_n
 	char	   *errmsg = NULL;
 
 	bool		remove_old_replication_slot = false;
+	bool		upstream_switched = false;
+	bool		settings_applied = false;
 
 	/*
 	 * Fetch our node record so we can write application_name, if set, and to
@@ -3058,16 +3285,30 @@ do_standby_follow_internal(PGconn *primary_conn, PGconn *follow_target_conn, t_n
 	log_notice(_("setting node %i's upstream to node %i"),
 			   config_file_options.node_id, follow_target_node_record->node_id);
 
-	if (!create_recovery_file(&local_node_record, &recovery_conninfo, config_file_options.data_directory, true))
+	/*
+	 * On PostgreSQL 13 and later, try to switch upstream with a configuration
+	 * reload; if that's not possible, write the recovery configuration and
+	 * restart the server as usual.
+	 */
+	upstream_switched = switch_upstream_via_reload(&local_node_record,
+												   &recovery_conninfo,
+												   &settings_applied);
+
+	if (upstream_switched == false && settings_applied == false)
 	{
-		*error_code = general_error_code;
-		return false;
+		if (!create_recovery_file(&local_node_record, &recovery_conninfo, config_file_options.data_directory, true))
+		{
+			*error_code = general_error_code;
+			return false;
+		}
 	}
 
 	/*
-	 * start/restart the service
+	 * start/restart the service, unless the upstream was switched via
+	 * a configuration reload
 	 */
 
+	if (upstream_switched == false)
 	{
 		char		server_command[MAXLEN] = "";
 		bool		server_up = is_server_available(config_file_options.conninfo);
@@ -3261,6 +3502,11 @@ do_standby_switchover(void)
 	bool		shutdown_success = false;
 	bool		dry_run_success = true;
 
+	/* used when waiting for the primary to shut down */
+	instr_time	shutdown_start_time;
+	double		last_remote_check_secs = -1.0;
+	int			next_log_secs = 0;
+
 	/* this flag will use to generate the final message generated */
 	bool		switchover_success = true;
 
@@ -3331,6 +3577,8 @@ do_standby_switchover(void)
 				   local_node_record.node_id);
 	}
 
+	switchover_timing_phase("prerequisite checks");
+
 	/* Check that this is a standby */
 	recovery_type = get_recovery_type(local_conn);
 	if (recovery_type != RECTYPE_STANDBY)
@@ -3527,7 +3775,13 @@ do_standby_switchover(void)
 	 */
 	get_conninfo_value(remote_conninfo, "host", remote_host);
 
-	r = test_ssh_connection(remote_host, runtime_options.remote_user);
+	{
+		instr_time	check_start_time;
+
+		INSTR_TIME_SET_CURRENT(check_start_time);
+		r = test_ssh_connection(remote_host, runtime_options.remote_user);
+		switchover_timing_remote_check("SSH connection", check_start_time);
+	}
 
 	if (r != 0)
 	{
@@ -3566,11 +3820,10 @@ do_standby_switchover(void)
 
 	appendPQExpBufferStr(&remote_command_str, "--version 2>/dev/null && echo \"1\" || echo \"0\"");
 	initPQExpBuffer(&command_output);
-	command_success = remote_command(remote_host,
-									 runtime_options.remote_user,
-									 remote_command_str.data,
-									 config_file_options.ssh_options,
-									 &command_output);
+	command_success = switchover_remote_command("repmgr binary",
+												remote_host,
+												remote_command_str.data,
+												&command_output);
 
 	termPQExpBuffer(&remote_command_str);
 
@@ -3630,11 +3883,10 @@ do_standby_switchover(void)
 	appendPQExpBufferStr(&remote_command_str, "node check --data-directory-config --optformat -LINFO 2>/dev/null");
 
 	initPQExpBuffer(&command_output);
-	command_success = remote_command(remote_host,
-									 runtime_options.remote_user,
-									 remote_command_str.data,
-									 config_file_options.ssh_options,
-									 &command_output);
+	command_success = switchover_remote_command("data directory configuration",
+												remote_host,
+												remote_command_str.data,
+												&command_output);
 
 	termPQExpBuffer(&remote_command_str);
 
@@ -3731,11 +3983,10 @@ do_standby_switchover(void)
 
 		initPQExpBuffer(&command_output);
 
-		command_success = remote_command(remote_host,
-										 runtime_options.remote_user,
-										 remote_command_str.data,
-										 config_file_options.ssh_options,
-										 &command_output);
+		command_success = switchover_remote_command("replication connection",
+													remote_host,
+													remote_command_str.data,
+													&command_output);
 
 		termPQExpBuffer(&remote_command_str);
 
@@ -3784,11 +4035,10 @@ do_standby_switchover(void)
 
 			initPQExpBuffer(&command_output);
 
-			command_success = remote_command(remote_host,
-											 runtime_options.remote_user,
-											 remote_command_str.data,
-											 config_file_options.ssh_options,
-											 &command_output);
+			command_success = switchover_remote_command("archive status",
+														remote_host,
+														remote_command_str.data,
+														&command_output);
 
 			termPQExpBuffer(&remote_command_str);
 
@@ -3983,6 +4233,8 @@ do_standby_switchover(void)
 	 * Attempt to pause all repmgrd instances, unless user explicitly
 	 * specifies not to.
 	 */
+	switchover_timing_phase("repmgrd pause");
+
 	if (runtime_options.repmgrd_no_pause == false)
 	{
 		NodeInfoListCell *cell = NULL;
@@ -4205,6 +4457,8 @@ do_standby_switchover(void)
 	 * detected after a certain time.
 	 */
 
+	switchover_timing_phase("primary shutdown");
+
 	initPQExpBuffer(&remote_command_str);
 	initPQExpBuffer(&command_output);
 
@@ -4227,11 +4481,10 @@ do_standby_switchover(void)
 
 	/* XXX handle failure */
 
-	(void) remote_command(remote_host,
-						  runtime_options.remote_user,
-						  remote_command_str.data,
-						  config_file_options.ssh_options,
-						  &command_output);
+	(void) switchover_remote_command(runtime_options.dry_run == true ? "shutdown command" : "shutdown",
+									 remote_host,
+									 remote_command_str.data,
+									 &command_output);
 
 	termPQExpBuffer(&remote_command_str);
 
@@ -4258,6 +4511,8 @@ do_standby_switchover(void)
 
 		key_value_list_free(&remote_config_files);
 
+		report_switchover_timing(dry_run_success);
+
 		if (dry_run_success == false)
 		{
 			log_error(_("prerequisites for executing STANDBY SWITCHOVER are *not* met"));
@@ -4273,47 +4528,80 @@ do_standby_switchover(void)
 	termPQExpBuffer(&command_output);
 	shutdown_success = false;
 
-	/* loop for timeout waiting for current primary to stop */
+	/*
+	 * Wait for the current primary to stop. The primary is pinged at short
+	 * intervals; once it no longer responds, its repmgr is asked to wait
+	 * locally until the data directory shows the shutdown has completed, so
+	 * we find out as soon as it's down with a single SSH invocation, rather
+	 * than one per check.
+	 */
+
+	INSTR_TIME_SET_CURRENT(shutdown_start_time);
 
-	for (i = 0; i < config_file_options.shutdown_check_timeout; i++)
+	for (;;)
 	{
 		/* Check whether primary is available */
 		PGPing		ping_res;
+		instr_time	elapsed;
+		int			elapsed_secs;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, shutdown_start_time);
+
+		if (INSTR_TIME_GET_DOUBLE(elapsed) >= config_file_options.shutdown_check_timeout)
+			break;
+
+		elapsed_secs = (int) INSTR_TIME_GET_DOUBLE(elapsed);
 
-		log_info(_("checking for primary shutdown; %i of %i attempts (\"shutdown_check_timeout\")"),
-				 i + 1, config_file_options.shutdown_check_timeout);
+		if (elapsed_secs >= next_log_secs)
+		{
+			log_info(_("checking for primary shutdown; %i of %i seconds (\"shutdown_check_timeout\")"),
+					 elapsed_secs, config_file_options.shutdown_check_timeout);
+			next_log_secs = elapsed_secs + 1;
+		}
 
 		ping_res = PQping(remote_conninfo);
 
 		log_debug("ping status is: %s", print_pqping_status(ping_res));
 
-		/* database server could not be contacted */
-		if (ping_res == PQPING_NO_RESPONSE || ping_res == PQPING_NO_ATTEMPT)
+		/*
+		 * database server could not be contacted; if a remote check was
+		 * already made, don't repeat it more than once a second (this will
+		 * only happen if the remote repmgr doesn't support --wait)
+		 */
+		if ((ping_res == PQPING_NO_RESPONSE || ping_res == PQPING_NO_ATTEMPT)
+			&& (last_remote_check_secs < 0
+				|| INSTR_TIME_GET_DOUBLE(elapsed) - last_remote_check_secs >= 1.0))
 		{
 			bool		command_success;
 
 			/*
 			 * remote server can't be contacted at protocol level - that
 			 * doesn't necessarily mean it's shut down, so we'll ask its
-			 * repmgr to check at data directory level, and if shut down also
-			 * return the last checkpoint LSN.
+			 * repmgr to check at data directory level, wait for the shutdown
+			 * to complete for however long we have left, and if shut down
+			 * also return the last checkpoint LSN.
 			 */
 
 			initPQExpBuffer(&remote_command_str);
 			make_remote_repmgr_path(&remote_command_str, &remote_node_record);
-			appendPQExpBufferStr(&remote_command_str,
-								 "node status --is-shutdown-cleanly");
+			appendPQExpBuffer(&remote_command_str,
+							  "node status --is-shutdown-cleanly --wait=%i",
+							  config_file_options.shutdown_check_timeout - elapsed_secs);
 
 			initPQExpBuffer(&command_output);
 
-			command_success = remote_command(remote_host,
-											 runtime_options.remote_user,
-											 remote_command_str.data,
-											 config_file_options.ssh_options,
-											 &command_output);
+			command_success = switchover_remote_command("shutdown status",
+														remote_host,
+														remote_command_str.data,
+														&command_output);
 
 			termPQExpBuffer(&remote_command_str);
 
+			INSTR_TIME_SET_CURRENT(elapsed);
+			INSTR_TIME_SUBTRACT(elapsed, shutdown_start_time);
+			last_remote_check_secs = INSTR_TIME_GET_DOUBLE(elapsed);
+
 			if (command_success == true)
 			{
 				NodeStatus	status = parse_node_status_is_shutdown_cleanly(command_output.data, &remote_last_checkpoint_lsn);
@@ -4350,10 +4638,11 @@ do_standby_switchover(void)
 			}
 
 			termPQExpBuffer(&command_output);
+
+			continue;
 		}
 
-		log_debug("sleeping 1 second until next check");
-		sleep(1);
+		pg_usleep(SHUTDOWN_CHECK_POLL_INTERVAL_MS * 1000L);
 	}
 
 	if (shutdown_success == false)
@@ -4381,6 +4670,8 @@ do_standby_switchover(void)
 		log_verbose(LOG_INFO, _("successfully reconnected to local node"));
 	}
 
+	switchover_timing_phase("WAL flush");
+
 	init_replication_info(&replication_info);
 	/*
 	 * Compare standby's last WAL receive location with the primary's last
@@ -4437,6 +4728,8 @@ do_standby_switchover(void)
 			  format_lsn(remote_last_checkpoint_lsn));
 
 	/* promote standby (local node) */
+	switchover_timing_phase("promotion");
+
 	_do_standby_promote_internal(local_conn);
 
 
@@ -4457,6 +4750,8 @@ do_standby_switchover(void)
 	 * remote server. Additionally execute "pg_rewind", if required and
 	 * requested.
 	 */
+	switchover_timing_phase("demotion candidate rejoin");
+
 	initPQExpBuffer(&node_rejoin_options);
 	if (replication_info.last_wal_receive_lsn < remote_last_checkpoint_lsn)
 	{
@@ -4530,11 +4825,10 @@ do_standby_switchover(void)
 	log_debug("executing:\n  %s", remote_command_str.data);
 	initPQExpBuffer(&command_output);
 
-	command_success = remote_command(remote_host,
-									 runtime_options.remote_user,
-									 remote_command_str.data,
-									 config_file_options.ssh_options,
-									 &command_output);
+	command_success = switchover_remote_command("node rejoin",
+												remote_host,
+												remote_command_str.data,
+												&command_output);
 
 	termPQExpBuffer(&remote_command_str);
 
@@ -4552,7 +4846,24 @@ do_standby_switchover(void)
 										   command_output.data,
 										   &event_info);
 	}
-	else
+
+	termPQExpBuffer(&command_output);
+
+	/*
+	 * If --siblings-follow specified, attempt to make them follow the new
+	 * primary
+	 */
+	if (runtime_options.siblings_follow == true && sibling_nodes.node_count > 0)
+	{
+		switchover_timing_phase("sibling nodes follow");
+		sibling_nodes_follow(&local_node_record, &sibling_nodes, &sibling_nodes_stats);
+	}
+
+	/*
+	 * The success event is written after the sibling nodes have been
+	 * instructed to follow, so the outcome can be included in the details.
+	 */
+	if (command_success == true)
 	{
 		PQExpBufferData event_details;
 
@@ -4563,6 +4874,22 @@ do_standby_switchover(void)
 						  config_file_options.node_id,
 						  remote_node_record.node_id);
 
+		if (runtime_options.siblings_follow == true && sibling_nodes.node_count > 0)
+		{
+			appendPQExpBuffer(&event_details,
+							  "; %i of %i sibling nodes now following node %i",
+							  sibling_nodes_stats.followed_sibling_node_count,
+							  sibling_nodes.node_count,
+							  config_file_options.node_id);
+
+			if (sibling_nodes_stats.timed_out_follow_sibling_node_count > 0)
+			{
+				appendPQExpBuffer(&event_details,
+								  " (%i timed out)",
+								  sibling_nodes_stats.timed_out_follow_sibling_node_count);
+			}
+		}
+
 		create_event_notification_extended(local_conn,
 										   &config_file_options,
 										   config_file_options.node_id,
@@ -4573,17 +4900,6 @@ do_standby_switchover(void)
 		termPQExpBuffer(&event_details);
 	}
 
-	termPQExpBuffer(&command_output);
-
-	/*
-	 * If --siblings-follow specified, attempt to make them follow the new
-	 * primary
-	 */
-	if (runtime_options.siblings_follow == true && sibling_nodes.node_count > 0)
-	{
-		sibling_nodes_follow(&local_node_record, &sibling_nodes, &sibling_nodes_stats);
-	}
-
 	clear_node_info_list(&sibling_nodes);
 
 	PQfinish(local_conn);
@@ -4592,6 +4908,7 @@ do_standby_switchover(void)
 	 * Clean up remote node (primary demoted to standby). It's possible that the node is
 	 * still starting up, so poll for a while until we get a connection.
 	 */
+	switchover_timing_phase("demoted primary reconnection");
 
 	for (i = 0; i < config_file_options.standby_reconnect_timeout; i++)
 	{
@@ -4648,6 +4965,8 @@ do_standby_switchover(void)
 	 */
 	if (runtime_options.repmgrd_no_pause == false)
 	{
+		switchover_timing_phase("repmgrd unpause");
+
 		if (repmgrd_running_count > 0)
 		{
 			ItemList repmgrd_unpause_errors = {NULL, NULL};
@@ -4724,6 +5043,8 @@ do_standby_switchover(void)
 		clear_node_info_list(&all_nodes);
 	}
 
+	report_switchover_timing(switchover_success);
+
 	if (switchover_success == true)
 	{
 		log_notice(_("STANDBY SWITCHOVER has completed successfully"));
@@ -5215,6 +5536,10 @@ check_upstream_config(PGconn *conn, int server_version_num, t_node_info *upstrea
 	if (strlen(backup_options.wal_method) && strcmp(backup_options.wal_method, "stream") != 0)
 		wal_method_stream = false;
 
+	/* in rsync mode, no WAL is copied during the backup */
+	if (mode == rsync)
+		wal_method_stream = false;
+
 	/* Check that WAL level is set correctly */
 	if (server_version_num < 90400)
 	{
@@ -5855,6 +6180,11 @@ run_basebackup(t_node_info *node_record)
 		appendPQExpBufferStr(&params, " -c fast");
 	}
 
+	if (runtime_options.progress)
+	{
+		appendPQExpBufferStr(&params, " -P");
+	}
+
 	if (config_file_options.tablespace_mapping.head != NULL)
 	{
 		for (cell = config_file_options.tablespace_mapping.head; cell; cell = cell->next)
@@ -5925,11 +6255,27 @@ run_basebackup(t_node_info *node_record)
 	 * As of 9.4, pg_basebackup only ever returns 0 or 1
 	 */
 
-	r = system(script);
+	if (runtime_options.progress == true)
+		r = run_basebackup_with_progress(script);
+	else
+		r = system(script);
 
 	if (r != 0)
 		return ERR_BAD_BASEBACKUP;
 
+	move_replication_slot_to_upstream(node_record);
+
+	return SUCCESS;
+}
+
+
+/*
+ * Called once the base backup has been taken; any replication slot created
+ * by initialise_direct_clone() will be on the source node.
+ */
+static void
+move_replication_slot_to_upstream(t_node_info *node_record)
+{
 	/* check connections are still available */
 	(void)connection_ping_reconnect(primary_conn);
 
@@ -6069,65 +6415,737 @@ run_basebackup(t_node_info *node_record)
 			PQfinish(superuser_conn);
 
 	}
-
-
-	return SUCCESS;
 }
 
 
+/*
+ * Execute pg_basebackup (which must have been provided with -P/--progress)
+ * and parse the progress reports it writes to stderr, converting them into
+ * throughput and ETA figures which are emitted either as log lines or, with
+ * "--progress=json", as one JSON object per line on stdout.
+ *
+ * Any output from pg_basebackup which is not a progress report is passed
+ * through to stderr unchanged.
+ *
+ * Returns the exit code of pg_basebackup, or -1 if it could not be
+ * executed or did not exit normally (e.g. was terminated by a signal).
+ */
 static int
-run_file_backup(t_node_info *node_record)
+run_basebackup_with_progress(const char *script)
 {
-	int			r = SUCCESS,
-				i;
-
-	char		command[MAXLEN] = "";
-	char		filename[MAXLEN] = "";
-	char		buf[MAXLEN] = "";
-	char		basebackups_directory[MAXLEN] = "";
-	char		backup_id[MAXLEN] = "";
-	char	   *p = NULL,
-			   *q = NULL;
-	TablespaceDataList tablespace_list = {NULL, NULL};
-	TablespaceDataListCell *cell_t = NULL;
+	PQExpBufferData command;
+	PQExpBufferData line;
+	FILE	   *fp = NULL;
+	char		buf[MAXLEN];
+	ssize_t		bytes_read = 0;
+	int			retval = 0;
+	int			exit_code = -1;
+	int			i = 0;
 
-	PQExpBufferData tablespace_map;
-	bool		tablespace_map_rewrite = false;
+	t_basebackup_progress progress = T_BASEBACKUP_PROGRESS_INITIALIZER;
+	int64		last_sample_kb = 0;
+	int64		tablespace_start_kb = 0;
+	int64	   *tablespace_kb = NULL;
+	int			tablespaces_recorded = 0;
+	double		bytes_per_sec = 0;
+	double		elapsed = 0;
 
-	if (mode == barman)
-	{
-		/*
-		 * Locate Barman's base backups directory
-		 */
+	instr_time	start_time;
+	instr_time	last_sample_time;
+	instr_time	last_log_time;
+	instr_time	current_time;
 
-		get_barman_property(basebackups_directory, "basebackups_directory", local_repmgr_tmp_directory);
+	initPQExpBuffer(&command);
+	appendPQExpBuffer(&command, "%s 2>&1", script);
 
-		/*
-		 * Read the list of backup files into a local file. In the process:
-		 *
-		 * - determine the backup ID; - check, and remove, the prefix; -
-		 * detect tablespaces; - filter files in one list per tablespace;
-		 */
+	fp = popen(command.data, "r");
 
-		{
-			FILE	   *fi;		/* input stream */
-			FILE	   *fd;		/* output for data.txt */
-			char		prefix[MAXLEN] = "";
-			char		output[MAXLEN] = "";
-			int			n = 0;
+	termPQExpBuffer(&command);
 
-			maxlen_snprintf(command, "%s list-files --target=data %s latest",
-							make_barman_ssh_command(barman_command_buf),
-							config_file_options.barman_server);
+	if (fp == NULL)
+	{
+		log_error(_("unable to execute pg_basebackup"));
+		return -1;
+	}
 
-			log_verbose(LOG_DEBUG, "executing:\n  %s", command);
+	INSTR_TIME_SET_CURRENT(start_time);
+	last_sample_time = start_time;
+	last_log_time = start_time;
 
-			fi = popen(command, "r");
-			if (fi == NULL)
-			{
-				log_error("cannot launch command: %s", command);
-				exit(ERR_BARMAN);
-			}
+	initPQExpBuffer(&line);
+
+	/*
+	 * pg_basebackup terminates progress lines with "\r" if stderr is a
+	 * terminal, and (from PostgreSQL 12) with "\n" otherwise, so handle both.
+	 * The final, partial line (if any) is handled after EOF.
+	 */
+	while ((bytes_read = read(fileno(fp), buf, sizeof(buf))) != 0)
+	{
+		if (bytes_read < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		for (i = 0; i < bytes_read; i++)
+		{
+			if (buf[i] != '\r' && buf[i] != '\n')
+			{
+				appendPQExpBufferChar(&line, buf[i]);
+				continue;
+			}
+
+			if (line.len == 0)
+				continue;
+
+			if (parse_basebackup_progress(line.data, &progress) == false)
+			{
+				fprintf(stderr, "%s\n", line.data);
+				fflush(stderr);
+				resetPQExpBuffer(&line);
+				continue;
+			}
+
+			resetPQExpBuffer(&line);
+
+			INSTR_TIME_SET_CURRENT(current_time);
+
+			/*
+			 * Record the amount of data streamed for each tablespace as it
+			 * completes.
+			 */
+			if (tablespace_kb == NULL && progress.tablespaces_total > 0)
+			{
+				tablespace_kb = pg_malloc0(sizeof(int64) * progress.tablespaces_total);
+			}
+
+			while (tablespace_kb != NULL && tablespaces_recorded < progress.tablespaces_done)
+			{
+				tablespace_kb[tablespaces_recorded++] = progress.done_kb - tablespace_start_kb;
+				tablespace_start_kb = progress.done_kb;
+			}
+
+			/* throughput over the interval since the previous report */
+			{
+				instr_time	sample_interval = current_time;
+
+				INSTR_TIME_SUBTRACT(sample_interval, last_sample_time);
+
+				if (INSTR_TIME_GET_DOUBLE(sample_interval) > 0)
+				{
+					bytes_per_sec = (double) (progress.done_kb - last_sample_kb) * 1024
+						/ INSTR_TIME_GET_DOUBLE(sample_interval);
+				}
+			}
+
+			last_sample_kb = progress.done_kb;
+			last_sample_time = current_time;
+
+			elapsed = INSTR_TIME_GET_DOUBLE(current_time) - INSTR_TIME_GET_DOUBLE(start_time);
+
+			if (runtime_options.progress_format == PROGRESS_FORMAT_TEXT)
+			{
+				instr_time	log_interval = current_time;
+
+				INSTR_TIME_SUBTRACT(log_interval, last_log_time);
+
+				if (INSTR_TIME_GET_DOUBLE(log_interval) < BASEBACKUP_PROGRESS_LOG_INTERVAL)
+					continue;
+
+				last_log_time = current_time;
+			}
+
+			report_basebackup_progress(&progress, elapsed, bytes_per_sec);
+		}
+	}
+
+	if (line.len > 0 && parse_basebackup_progress(line.data, &progress) == false)
+	{
+		fprintf(stderr, "%s\n", line.data);
+	}
+
+	termPQExpBuffer(&line);
+
+	retval = pclose(fp);
+
+	if (retval == -1)
+	{
+		log_error(_("unable to obtain pg_basebackup's exit status"));
+		log_detail("%s", strerror(errno));
+	}
+	else if (WIFEXITED(retval))
+	{
+		exit_code = WEXITSTATUS(retval);
+	}
+	else if (WIFSIGNALED(retval))
+	{
+		log_error(_("pg_basebackup was terminated by signal %i"), WTERMSIG(retval));
+	}
+	else
+	{
+		log_error(_("pg_basebackup exited with unrecognized status %i"), retval);
+	}
+
+	INSTR_TIME_SET_CURRENT(current_time);
+	elapsed = INSTR_TIME_GET_DOUBLE(current_time) - INSTR_TIME_GET_DOUBLE(start_time);
+
+	/* attribute anything not yet recorded to the final tablespace */
+	if (tablespace_kb != NULL && tablespaces_recorded < progress.tablespaces_total)
+	{
+		tablespace_kb[tablespaces_recorded++] = progress.done_kb - tablespace_start_kb;
+	}
+
+	if (runtime_options.progress_format == PROGRESS_FORMAT_JSON)
+	{
+		printf("{\"event\": \"complete\", \"exit_code\": %i, \"elapsed_seconds\": %.1f, \"bytes_done\": " INT64_FORMAT ", \"avg_bytes_per_sec\": %.0f, \"tablespaces\": [",
+			   exit_code,
+			   elapsed,
+			   progress.done_kb * 1024,
+			   elapsed > 0 ? (double) progress.done_kb * 1024 / elapsed : 0);
+
+		for (i = 0; i < tablespaces_recorded; i++)
+		{
+			printf("%s{\"tablespace\": %i, \"bytes\": " INT64_FORMAT "}",
+				   i > 0 ? ", " : "",
+				   i + 1,
+				   tablespace_kb[i] * 1024);
+		}
+
+		printf("]}\n");
+		fflush(stdout);
+	}
+	else
+	{
+		log_info(_("pg_basebackup streamed %.1f MB in %.1f seconds (%.1f MB/s)"),
+				 (double) progress.done_kb / 1024,
+				 elapsed,
+				 elapsed > 0 ? (double) progress.done_kb / 1024 / elapsed : 0);
+
+		for (i = 0; i < tablespaces_recorded; i++)
+		{
+			log_verbose(LOG_INFO, _("  tablespace %i of %i: %.1f MB"),
+						i + 1,
+						tablespaces_recorded,
+						(double) tablespace_kb[i] / 1024);
+		}
+	}
+
+	if (tablespace_kb != NULL)
+		pfree(tablespace_kb);
+
+	return exit_code;
+}
+
+
+/*
+ * Parse a progress report line as emitted by "pg_basebackup -P", e.g.:
+ *
+ *     12345/67890 kB (18%), 1/3 tablespaces
+ *
+ * (possibly followed by a filename if pg_basebackup's --verbose option
+ * was provided), or, if no size estimate is available:
+ *
+ *     12345 kB, 1/3 tablespaces
+ */
+static bool
+parse_basebackup_progress(const char *line, t_basebackup_progress *progress)
+{
+	long long	done_kb = 0;
+	long long	total_kb = 0;
+	int			percent = 0;
+	int			tablespaces_done = 0;
+	int			tablespaces_total = 0;
+
+	if (sscanf(line, " %lld/%lld kB (%d%%), %d/%d tablespace",
+			   &done_kb, &total_kb, &percent,
+			   &tablespaces_done, &tablespaces_total) == 5)
+	{
+		progress->done_kb = (int64) done_kb;
+		progress->total_kb = (int64) total_kb;
+		progress->percent = percent;
+		progress->tablespaces_done = tablespaces_done;
+		progress->tablespaces_total = tablespaces_total;
+
+		return true;
+	}
+
+	if (sscanf(line, " %lld kB, %d/%d tablespace",
+			   &done_kb, &tablespaces_done, &tablespaces_total) == 3)
+	{
+		progress->done_kb = (int64) done_kb;
+		progress->total_kb = -1;
+		progress->percent = -1;
+		progress->tablespaces_done = tablespaces_done;
+		progress->tablespaces_total = tablespaces_total;
+
+		return true;
+	}
+
+	return false;
+}
+
+
+static void
+report_basebackup_progress(t_basebackup_progress *progress, double elapsed, double bytes_per_sec)
+{
+	double		avg_bytes_per_sec = 0;
+	int			eta = -1;
+
+	if (elapsed > 0)
+		avg_bytes_per_sec = (double) progress->done_kb * 1024 / elapsed;
+
+	if (progress->total_kb >= progress->done_kb && avg_bytes_per_sec > 0)
+		eta = (int) ((double) (progress->total_kb - progress->done_kb) * 1024 / avg_bytes_per_sec);
+
+	if (runtime_options.progress_format == PROGRESS_FORMAT_JSON)
+	{
+		printf("{\"event\": \"progress\", \"elapsed_seconds\": %.1f, \"bytes_done\": " INT64_FORMAT ", \"bytes_total\": " INT64_FORMAT ", \"percent\": %i, \"bytes_per_sec\": %.0f, \"avg_bytes_per_sec\": %.0f, \"eta_seconds\": %i, \"tablespace\": %i, \"tablespaces_total\": %i}\n",
+			   elapsed,
+			   progress->done_kb * 1024,
+			   progress->total_kb < 0 ? -1 : progress->total_kb * 1024,
+			   progress->percent,
+			   bytes_per_sec,
+			   avg_bytes_per_sec,
+			   eta,
+			   Min(progress->tablespaces_done + 1, progress->tablespaces_total),
+			   progress->tablespaces_total);
+		fflush(stdout);
+		return;
+	}
+
+	if (progress->total_kb < 0)
+	{
+		log_info(_("backup progress: %.1f MB, tablespace %i of %i, %.1f MB/s"),
+				 (double) progress->done_kb / 1024,
+				 Min(progress->tablespaces_done + 1, progress->tablespaces_total),
+				 progress->tablespaces_total,
+				 bytes_per_sec / (1024 * 1024));
+		return;
+	}
+
+	log_info(_("backup progress: %.1f of %.1f MB (%i%%), tablespace %i of %i, %.1f MB/s, ETA %i seconds"),
+			 (double) progress->done_kb / 1024,
+			 (double) progress->total_kb / 1024,
+			 progress->percent,
+			 Min(progress->tablespaces_done + 1, progress->tablespaces_total),
+			 progress->tablespaces_total,
+			 bytes_per_sec / (1024 * 1024),
+			 eta);
+}
+
+
+/*
+ * Clone the data directory and each tablespace concurrently using rsync
+ * over SSH, within a non-exclusive backup on the source node. Each
+ * tablespace is copied directly to its (possibly remapped) location, so
+ * throughput is not limited to a single pg_basebackup stream.
+ *
+ * WAL is not copied; the standby will retrieve the WAL generated during
+ * the backup from its upstream, which the replication slot (if in use)
+ * will have retained.
+ */
+static int
+run_parallel_file_backup(t_node_info *node_record)
+{
+	int			r = SUCCESS;
+	PGconn	   *superuser_conn = NULL;
+	PGconn	   *privileged_conn = NULL;
+
+	KeyValueList tablespaces = {NULL, NULL};
+	KeyValueListCell *kv_cell = NULL;
+	TablespaceListCell *cell = NULL;
+	int			tablespace_count = 0;
+
+	t_file_copy_job *jobs = NULL;
+	int			job_count = 0;
+	int			next_job = 0;
+	int			running_jobs = 0;
+	int			max_jobs = runtime_options.parallel_tablespaces_jobs;
+	int			i;
+
+	XLogRecPtr	start_lsn = InvalidXLogRecPtr;
+	XLogRecPtr	stop_lsn = InvalidXLogRecPtr;
+	PQExpBufferData labelfile;
+	PQExpBufferData spcmapfile;
+	PQExpBufferData tablespace_map;
+	char		filename[MAXPGPATH] = "";
+	instr_time	start_time;
+	instr_time	current_time;
+
+	get_superuser_connection(&source_conn, &superuser_conn, &privileged_conn);
+
+	tablespace_count = get_tablespace_locations(privileged_conn, &tablespaces);
+
+	if (tablespace_count < 0)
+	{
+		log_error(_("unable to retrieve tablespace locations from the source node"));
+
+		if (superuser_conn != NULL)
+			PQfinish(superuser_conn);
+
+		return ERR_BAD_BASEBACKUP;
+	}
+
+	/* one job for the data directory, plus one for each tablespace */
+	jobs = pg_malloc0(sizeof(t_file_copy_job) * (tablespace_count + 1));
+
+	strncpy(jobs[job_count].remote_path, upstream_data_directory, MAXPGPATH);
+	strncpy(jobs[job_count].local_path, local_data_directory, MAXPGPATH);
+	job_count++;
+
+	for (kv_cell = tablespaces.head; kv_cell; kv_cell = kv_cell->next)
+	{
+		t_file_copy_job *job = &jobs[job_count++];
+
+		strncpy(job->remote_path, kv_cell->value, MAXPGPATH);
+		strncpy(job->local_path, kv_cell->value, MAXPGPATH);
+
+		for (cell = config_file_options.tablespace_mapping.head; cell; cell = cell->next)
+		{
+			if (strcmp(kv_cell->value, cell->old_dir) == 0)
+			{
+				strncpy(job->local_path, cell->new_dir, MAXPGPATH);
+				break;
+			}
+		}
+
+		if (create_pg_dir(job->local_path, runtime_options.force) == false)
+		{
+			log_error(_("unable to use directory \"%s\" for tablespace (OID %s)"),
+					  job->local_path, kv_cell->key);
+			log_hint(_("use -F/--force to force this directory to be overwritten"));
+
+			r = ERR_BAD_BASEBACKUP;
+			goto cleanup;
+		}
+	}
+
+	if (max_jobs <= 0 || max_jobs > job_count)
+		max_jobs = job_count;
+
+	if (start_backup(privileged_conn, "repmgr standby clone", runtime_options.fast_checkpoint, &start_lsn) == false)
+	{
+		log_error(_("unable to start backup on the source node"));
+		r = ERR_BAD_BASEBACKUP;
+		goto cleanup;
+	}
+
+	log_verbose(LOG_INFO, _("backup started at %X/%X; copying %i director%s using %i parallel job%s"),
+				format_lsn(start_lsn),
+				job_count, job_count == 1 ? "y" : "ies",
+				max_jobs, max_jobs == 1 ? "" : "s");
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	while (next_job < job_count || running_jobs > 0)
+	{
+		int			status = 0;
+		pid_t		pid;
+
+		while (next_job < job_count && running_jobs < max_jobs)
+		{
+			if (start_file_copy_job(&jobs[next_job]) == false)
+			{
+				r = ERR_BAD_BASEBACKUP;
+				next_job = job_count;
+				break;
+			}
+
+			next_job++;
+			running_jobs++;
+		}
+
+		if (running_jobs == 0)
+			break;
+
+		pid = waitpid(-1, &status, 0);
+
+		if (pid < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			log_error(_("unable to wait for file copy"));
+			log_detail("%s", strerror(errno));
+			r = ERR_BAD_BASEBACKUP;
+			break;
+		}
+
+		for (i = 0; i < job_count; i++)
+		{
+			instr_time	elapsed;
+
+			if (jobs[i].pid != pid)
+				continue;
+
+			jobs[i].pid = 0;
+			jobs[i].exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+			running_jobs--;
+
+			INSTR_TIME_SET_CURRENT(elapsed);
+			INSTR_TIME_SUBTRACT(elapsed, jobs[i].start_time);
+
+			/* exit code 24 indicates vanished files, which isn't a problem for us */
+			if (jobs[i].exit_code != 0 && jobs[i].exit_code != 24)
+			{
+				log_error(_("unable to copy \"%s\" (rsync exit code %i)"),
+						  jobs[i].remote_path, jobs[i].exit_code);
+
+				r = ERR_BAD_BASEBACKUP;
+
+				/* don't start any further copies */
+				next_job = job_count;
+			}
+			else
+			{
+				log_info(_("copied \"%s\" to \"%s\" in %.1f seconds"),
+						 jobs[i].remote_path,
+						 jobs[i].local_path,
+						 INSTR_TIME_GET_DOUBLE(elapsed));
+			}
+			break;
+		}
+	}
+
+	/*
+	 * pg_control is excluded from the data directory copy and copied last,
+	 * as pg_basebackup does
+	 */
+	if (r == SUCCESS)
+	{
+		char		remote_path[MAXPGPATH] = "";
+
+		maxpath_snprintf(remote_path, "%s/global/pg_control", upstream_data_directory);
+		maxpath_snprintf(filename, "%s/global", local_data_directory);
+
+		i = copy_remote_files(runtime_options.host, runtime_options.remote_user,
+							  remote_path, filename, false, source_server_version_num);
+
+		if (WIFEXITED(i) == false || WEXITSTATUS(i) != 0)
+		{
+			log_error(_("unable to copy \"%s\""), remote_path);
+			r = ERR_BAD_BASEBACKUP;
+		}
+	}
+
+	/*
+	 * Always stop the backup, even if the copy failed, as otherwise it
+	 * will only be terminated by the session ending.
+	 */
+	initPQExpBuffer(&labelfile);
+	initPQExpBuffer(&spcmapfile);
+
+	if (stop_backup(privileged_conn, &labelfile, &spcmapfile, &stop_lsn) == false)
+	{
+		log_error(_("unable to stop backup on the source node"));
+		r = ERR_BAD_BASEBACKUP;
+	}
+
+	if (r == SUCCESS)
+	{
+		INSTR_TIME_SET_CURRENT(current_time);
+		INSTR_TIME_SUBTRACT(current_time, start_time);
+
+		log_info(_("backup completed at %X/%X in %.1f seconds"),
+				 format_lsn(stop_lsn),
+				 INSTR_TIME_GET_DOUBLE(current_time));
+
+		maxpath_snprintf(filename, "%s/backup_label", local_data_directory);
+
+		if (write_backup_file(filename, labelfile.data) == false)
+			r = ERR_BAD_BASEBACKUP;
+	}
+
+	/*
+	 * The tablespace map returned by the server contains the source
+	 * locations; rewrite it with any mapped locations. The server will
+	 * create the pg_tblspc symlinks from this file on startup.
+	 */
+	if (r == SUCCESS && spcmapfile.len > 0)
+	{
+		char	   *line = NULL;
+
+		initPQExpBuffer(&tablespace_map);
+
+		for (line = strtok(spcmapfile.data, "\n"); line != NULL; line = strtok(NULL, "\n"))
+		{
+			char	   *location = strchr(line, ' ');
+
+			if (location == NULL)
+				continue;
+
+			*location++ = '\0';
+
+			for (cell = config_file_options.tablespace_mapping.head; cell; cell = cell->next)
+			{
+				if (strcmp(location, cell->old_dir) == 0)
+				{
+					log_debug(_("mapping source tablespace \"%s\" (OID %s) to \"%s\""),
+							  location, line, cell->new_dir);
+					location = cell->new_dir;
+					break;
+				}
+			}
+
+			appendPQExpBuffer(&tablespace_map, "%s %s\n", line, location);
+		}
+
+		maxpath_snprintf(filename, "%s/%s", local_data_directory, TABLESPACE_MAP);
+
+		if (write_backup_file(filename, tablespace_map.data) == false)
+			r = ERR_BAD_BASEBACKUP;
+
+		termPQExpBuffer(&tablespace_map);
+	}
+
+	termPQExpBuffer(&labelfile);
+	termPQExpBuffer(&spcmapfile);
+
+cleanup:
+	pfree(jobs);
+	key_value_list_free(&tablespaces);
+
+	if (superuser_conn != NULL)
+		PQfinish(superuser_conn);
+
+	if (r == SUCCESS)
+		move_replication_slot_to_upstream(node_record);
+
+	return r;
+}
+
+
+/*
+ * Launch the rsync command for a single copy job; the caller is
+ * responsible for reaping the child process.
+ */
+static bool
+start_file_copy_job(t_file_copy_job *job)
+{
+	PQExpBufferData script;
+	pid_t		pid;
+
+	initPQExpBuffer(&script);
+
+	make_copy_remote_files_command(&script,
+								   runtime_options.host,
+								   runtime_options.remote_user,
+								   job->remote_path,
+								   job->local_path,
+								   true,
+								   source_server_version_num);
+
+	log_verbose(LOG_INFO, _("rsync command line:\n  %s"), script.data);
+
+	/* ensure buffered output isn't duplicated in the child */
+	fflush(stdout);
+	fflush(stderr);
+
+	pid = fork();
+
+	if (pid < 0)
+	{
+		log_error(_("unable to start copy of \"%s\""), job->remote_path);
+		log_detail("%s", strerror(errno));
+		termPQExpBuffer(&script);
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		execl("/bin/sh", "sh", "-c", script.data, (char *) NULL);
+		_exit(127);
+	}
+
+	job->pid = pid;
+	INSTR_TIME_SET_CURRENT(job->start_time);
+
+	termPQExpBuffer(&script);
+
+	return true;
+}
+
+
+static bool
+write_backup_file(const char *filename, const char *contents)
+{
+	FILE	   *fp = fopen(filename, "w");
+
+	if (fp == NULL)
+	{
+		log_error(_("unable to create file \"%s\""), filename);
+		log_detail("%s", strerror(errno));
+		return false;
+	}
+
+	if (fputs(contents, fp) == EOF)
+	{
+		log_error(_("unable to write to file \"%s\""), filename);
+		log_detail("%s", strerror(errno));
+		fclose(fp);
+		return false;
+	}
+
+	fclose(fp);
+
+	return true;
+}
+
+
+static int
+run_file_backup(t_node_info *node_record)
+{
+	int			r = SUCCESS,
+				i;
+
+	char		command[MAXLEN] = "";
+	char		filename[MAXLEN] = "";
+	char		buf[MAXLEN] = "";
+	char		basebackups_directory[MAXLEN] = "";
+	char		backup_id[MAXLEN] = "";
+	char	   *p = NULL,
+			   *q = NULL;
+	TablespaceDataList tablespace_list = {NULL, NULL};
+	TablespaceDataListCell *cell_t = NULL;
+
+	PQExpBufferData tablespace_map;
+	bool		tablespace_map_rewrite = false;
+
+	if (mode == barman)
+	{
+		/*
+		 * Locate Barman's base backups directory
+		 */
+
+		get_barman_property(basebackups_directory, "basebackups_directory", local_repmgr_tmp_directory);
+
+		/*
+		 * Read the list of backup files into a local file. In the process:
+		 *
+		 * - determine the backup ID; - check, and remove, the prefix; -
+		 * detect tablespaces; - filter files in one list per tablespace;
+		 */
+
+		{
+			FILE	   *fi;		/* input stream */
+			FILE	   *fd;		/* output for data.txt */
+			char		prefix[MAXLEN] = "";
+			char		output[MAXLEN] = "";
+			int			n = 0;
+
+			maxlen_snprintf(command, "%s list-files --target=data %s latest",
+							make_barman_ssh_command(barman_command_buf),
+							config_file_options.barman_server);
+
+			log_verbose(LOG_DEBUG, "executing:\n  %s", command);
+
+			fi = popen(command, "r");
+			if (fi == NULL)
+			{
+				log_error("cannot launch command: %s", command);
+				exit(ERR_BARMAN);
+			}
 
 			fd = fopen(datadir_list_filename, "w");
 			if (fd == NULL)
@@ -7038,16 +8056,36 @@ static void
 write_primary_conninfo(PQExpBufferData *dest, t_conninfo_param_list *param_list)
 {
 	PQExpBufferData conninfo_buf;
+	char	   *escaped = NULL;
+
+	initPQExpBuffer(&conninfo_buf);
+
+	build_primary_conninfo(&conninfo_buf, param_list);
+
+	escaped = escape_recovery_conf_value(conninfo_buf.data);
+
+	appendPQExpBuffer(dest,
+					  "primary_conninfo = '%s'\n", escaped);
+
+	free(escaped);
+	termPQExpBuffer(&conninfo_buf);
+}
+
+
+/*
+ * Generate the (unescaped) connection string to be used as "primary_conninfo",
+ * either in recovery.conf or via ALTER SYSTEM.
+ */
+static void
+build_primary_conninfo(PQExpBufferData *conninfo_buf, t_conninfo_param_list *param_list)
+{
 	bool		application_name_provided = false;
 	bool		password_provided = false;
 	int			c;
-	char	   *escaped = NULL;
 	t_conninfo_param_list env_conninfo = T_CONNINFO_PARAM_LIST_INITIALIZER;
 
 	initialize_conninfo_params(&env_conninfo, true);
 
-	initPQExpBuffer(&conninfo_buf);
-
 	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
 	{
 		/*
@@ -7060,70 +8098,255 @@ write_primary_conninfo(PQExpBufferData *dest, t_conninfo_param_list *param_list)
 			(param_list->values[c] != NULL && param_list->values[c][0] == '\0'))
 			continue;
 
-		/* only include "password" if explicitly requested */
-		if (strcmp(param_list->keywords[c], "password") == 0)
+		/* only include "password" if explicitly requested */
+		if (strcmp(param_list->keywords[c], "password") == 0)
+		{
+			password_provided = true;
+		}
+
+		if (conninfo_buf->len != 0)
+			appendPQExpBufferChar(conninfo_buf, ' ');
+
+		if (strcmp(param_list->keywords[c], "application_name") == 0)
+			application_name_provided = true;
+
+		appendPQExpBuffer(conninfo_buf, "%s=", param_list->keywords[c]);
+		appendConnStrVal(conninfo_buf, param_list->values[c]);
+	}
+
+	/* "application_name" not provided - default to repmgr node name */
+	if (application_name_provided == false)
+	{
+		if (strlen(config_file_options.node_name))
+		{
+			appendPQExpBufferStr(conninfo_buf, " application_name=");
+			appendConnStrVal(conninfo_buf, config_file_options.node_name);
+		}
+		else
+		{
+			appendPQExpBufferStr(conninfo_buf, " application_name=repmgr");
+		}
+	}
+
+	/* no password provided explicitly  */
+	if (password_provided == false)
+	{
+		if (config_file_options.use_primary_conninfo_password == true)
+		{
+			const char *password = param_get(&env_conninfo, "password");
+
+			if (password != NULL)
+			{
+				appendPQExpBufferStr(conninfo_buf, " password=");
+				appendConnStrVal(conninfo_buf, password);
+			}
+		}
+	}
+
+	/* passfile provided as configuration option */
+	if (config_file_options.passfile[0] != '\0')
+	{
+		/* check if the libpq we're using supports "passfile=" */
+		if (has_passfile() == true)
+		{
+			appendPQExpBufferStr(conninfo_buf, " passfile=");
+			appendConnStrVal(conninfo_buf, config_file_options.passfile);
+		}
+	}
+
+	free_conninfo_params(&env_conninfo);
+}
+
+
+/*
+ * From PostgreSQL 13, "primary_conninfo" and "primary_slot_name" can be
+ * changed with a configuration reload; the startup process will then
+ * terminate the WAL receiver, which will be restarted with the new settings.
+ *
+ * Here we set the new values via ALTER SYSTEM, reload the configuration and
+ * wait up to "standby_follow_timeout" seconds for a new WAL receiver to
+ * be streaming from the new upstream, which avoids a full server restart.
+ *
+ * Returns true if a new WAL receiver is streaming from the new upstream, or
+ * the settings were already in place. "settings_applied" is set
+ * to true if the settings were successfully written, in which case the
+ * caller must not overwrite them with a recovery.conf file if falling back
+ * to a restart.
+ */
+static bool
+switch_upstream_via_reload(t_node_info *node_record, t_conninfo_param_list *primary_conninfo, bool *settings_applied)
+{
+	PGconn	   *local_conn = NULL;
+	PQExpBufferData conninfo_buf;
+	char		current_setting[MAXLEN] = "";
+	bool		settings_unchanged = false;
+	pid_t		original_wal_receiver_pid = UNKNOWN_PID;
+	t_wal_receiver_info wal_receiver_info = T_WAL_RECEIVER_INFO_INITIALIZER;
+	instr_time	start_time;
+	bool		success = false;
+
+	*settings_applied = false;
+
+	local_conn = establish_db_connection_quiet(config_file_options.conninfo);
+
+	if (PQstatus(local_conn) != CONNECTION_OK)
+	{
+		PQfinish(local_conn);
+		return false;
+	}
+
+	if (PQserverVersion(local_conn) < 130000)
+	{
+		log_debug("switch_upstream_via_reload(): server version is %i, restart required",
+				  PQserverVersion(local_conn));
+		PQfinish(local_conn);
+		return false;
+	}
+
+	if (get_recovery_type(local_conn) != RECTYPE_STANDBY)
+	{
+		log_debug("switch_upstream_via_reload(): node is not in recovery, restart required");
+		PQfinish(local_conn);
+		return false;
+	}
+
+	original_wal_receiver_pid = get_wal_receiver_pid(local_conn);
+
+	initPQExpBuffer(&conninfo_buf);
+	build_primary_conninfo(&conninfo_buf, primary_conninfo);
+
+	/*
+	 * If the settings are already in place, a reload won't restart the WAL
+	 * receiver, so there's nothing to wait for.
+	 */
+	if (get_pg_setting(local_conn, "primary_conninfo", current_setting) == true
+		&& strcmp(current_setting, conninfo_buf.data) == 0)
+	{
+		settings_unchanged = true;
+
+		if (config_file_options.use_replication_slots)
+		{
+			if (get_pg_setting(local_conn, "primary_slot_name", current_setting) == false
+				|| strcmp(current_setting, node_record->slot_name) != 0)
+				settings_unchanged = false;
+		}
+	}
+
+	if (settings_unchanged == true)
+	{
+		log_notice(_("upstream connection settings are unchanged"));
+		termPQExpBuffer(&conninfo_buf);
+		PQfinish(local_conn);
+
+		*settings_applied = true;
+		return true;
+	}
+
+	log_debug("switch_upstream_via_reload(): setting \"primary_conninfo\" to \"%s\"",
+			  conninfo_buf.data);
+
+	if (alter_system_str(local_conn, "primary_conninfo", conninfo_buf.data) == false)
+	{
+		termPQExpBuffer(&conninfo_buf);
+		PQfinish(local_conn);
+		return false;
+	}
+
+	termPQExpBuffer(&conninfo_buf);
+
+	if (config_file_options.use_replication_slots)
+	{
+		if (alter_system_str(local_conn, "primary_slot_name", node_record->slot_name) == false)
 		{
-			password_provided = true;
+			PQfinish(local_conn);
+			return false;
 		}
+	}
 
-		if (conninfo_buf.len != 0)
-			appendPQExpBufferChar(&conninfo_buf, ' ');
+	*settings_applied = true;
 
-		if (strcmp(param_list->keywords[c], "application_name") == 0)
-			application_name_provided = true;
+	log_notice(_("reloading configuration to apply new upstream connection settings"));
 
-		appendPQExpBuffer(&conninfo_buf, "%s=", param_list->keywords[c]);
-		appendConnStrVal(&conninfo_buf, param_list->values[c]);
+	if (pg_reload_conf(local_conn) == false)
+	{
+		PQfinish(local_conn);
+		return false;
 	}
 
-	/* "application_name" not provided - default to repmgr node name */
-	if (application_name_provided == false)
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	/*
+	 * A WAL receiver with a different PID is not in itself proof that the
+	 * new settings are in use: after a failover there will usually be no WAL
+	 * receiver at all, and one may be started with the old settings before
+	 * the startup process has processed the reload. So wait until a new
+	 * receiver is actually streaming from the new upstream.
+	 */
+	while (calculate_elapsed_seconds(start_time) < config_file_options.standby_follow_timeout)
 	{
-		if (strlen(config_file_options.node_name))
-		{
-			appendPQExpBufferStr(&conninfo_buf, " application_name=");
-			appendConnStrVal(&conninfo_buf, config_file_options.node_name);
-		}
-		else
+		if (get_wal_receiver_info(local_conn, &wal_receiver_info) == false)
+			break;
+
+		if (wal_receiver_info.pid > 0
+			&& wal_receiver_info.pid != original_wal_receiver_pid
+			&& strcmp(wal_receiver_info.status, "streaming") == 0
+			&& wal_receiver_matches_upstream(&wal_receiver_info, primary_conninfo) == true)
 		{
-			appendPQExpBufferStr(&conninfo_buf, " application_name=repmgr");
+			success = true;
+			break;
 		}
+
+		pg_usleep(WAL_RECEIVER_RESTART_POLL_INTERVAL_MS * 1000L);
 	}
 
-	/* no password provided explicitly  */
-	if (password_provided == false)
+	if (success == true)
 	{
-		if (config_file_options.use_primary_conninfo_password == true)
-		{
-			const char *password = param_get(&env_conninfo, "password");
-
-			if (password != NULL)
-			{
-				appendPQExpBufferStr(&conninfo_buf, " password=");
-				appendConnStrVal(&conninfo_buf, password);
-			}
-		}
+		log_notice(_("WAL receiver restarted with new upstream settings (PID: %i)"),
+				   (int) wal_receiver_info.pid);
 	}
-
-	/* passfile provided as configuration option */
-	if (config_file_options.passfile[0] != '\0')
+	else
 	{
-		/* check if the libpq we're using supports "passfile=" */
-		if (has_passfile() == true)
-		{
-			appendPQExpBufferStr(&conninfo_buf, " passfile=");
-			appendConnStrVal(&conninfo_buf, config_file_options.passfile);
-		}
+		log_warning(_("no WAL receiver streaming from the new upstream after %i seconds"),
+					config_file_options.standby_follow_timeout);
 	}
 
-	escaped = escape_recovery_conf_value(conninfo_buf.data);
+	PQfinish(local_conn);
 
-	appendPQExpBuffer(dest,
-					  "primary_conninfo = '%s'\n", escaped);
+	return success;
+}
 
-	free(escaped);
-	free_conninfo_params(&env_conninfo);
-	termPQExpBuffer(&conninfo_buf);
+
+/*
+ * Determine whether the WAL receiver is connected to the host and port
+ * specified in the provided "primary_conninfo" parameters. Parameters which
+ * are not set, or list multiple hosts, are not checked.
+ */
+static bool
+wal_receiver_matches_upstream(t_wal_receiver_info *wal_receiver_info, t_conninfo_param_list *primary_conninfo)
+{
+	char	   *host = param_get(primary_conninfo, "host");
+	char	   *port = param_get(primary_conninfo, "port");
+
+	if (host == NULL || host[0] == '\0')
+		host = param_get(primary_conninfo, "hostaddr");
+
+	if (host != NULL && host[0] != '\0' && strchr(host, ',') == NULL
+		&& strcmp(host, wal_receiver_info->sender_host) != 0)
+	{
+		log_verbose(LOG_DEBUG, "wal_receiver_matches_upstream(): WAL receiver is connected to host \"%s\", expected \"%s\"",
+					wal_receiver_info->sender_host, host);
+		return false;
+	}
+
+	if (port != NULL && port[0] != '\0' && strchr(port, ',') == NULL
+		&& atoi(port) != wal_receiver_info->sender_port)
+	{
+		log_verbose(LOG_DEBUG, "wal_receiver_matches_upstream(): WAL receiver is connected to port %i, expected %s",
+					wal_receiver_info->sender_port, port);
+		return false;
+	}
+
+	return true;
 }
 
 
@@ -7367,39 +8590,42 @@ check_free_slots(t_node_info *local_node_record, SiblingNodeStats *sibling_nodes
 }
 
 
+/*
+ * Execute "repmgr standby follow" (or "repmgr witness register" for a
+ * witness) on each reachable sibling node. The commands are executed
+ * concurrently, up to "sibling_nodes_follow_concurrency" at a time; any
+ * command which has not completed after "sibling_nodes_follow_timeout"
+ * seconds is terminated and treated as failed.
+ *
+ * Results are recorded in the provided SiblingNodeStats.
+ */
 static void
 sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats)
 {
-	int			failed_follow_count = 0;
-	char		host[MAXLEN] = "";
 	NodeInfoListCell *cell = NULL;
-	PQExpBufferData remote_command_str;
-	PQExpBufferData command_output;
+	t_sibling_follow_job *jobs = NULL;
+	int			job_count = 0;
+	int			next_job = 0;
+	int			running_jobs = 0;
+	int			completed_jobs = 0;
+	int			i;
 
 	log_notice(_("executing STANDBY FOLLOW on %i of %i siblings"),
 			   sibling_nodes->node_count - sibling_nodes_stats->unreachable_sibling_node_count,
 			   sibling_nodes->node_count);
 
+	jobs = (t_sibling_follow_job *) pg_malloc0(sizeof(t_sibling_follow_job) * sibling_nodes->node_count);
+
 	for (cell = sibling_nodes->head; cell; cell = cell->next)
 	{
-		bool		success = false;
-
 		/* skip nodes previously determined as unreachable */
 		if (cell->node_info->reachable == false)
 			continue;
 
-		initPQExpBuffer(&remote_command_str);
-		make_remote_repmgr_path(&remote_command_str, cell->node_info);
-
 		if (cell->node_info->type == WITNESS)
 		{
 			PGconn *witness_conn = NULL;
 
-			/* TODO: create "repmgr witness resync" or similar */
-			appendPQExpBuffer(&remote_command_str,
-							  "witness register -d \\'%s\\' --force 2>/dev/null && echo \"1\" || echo \"0\"",
-							  local_node_record->conninfo);
-
 			/*
 			 * Notify the witness repmgrd about the new primary, as at this point it will be assuming
 			 * a failover situation is in place. It will detect the new primary at some point, this
@@ -7415,50 +8641,123 @@ sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes
 			}
 			PQfinish(witness_conn);
 		}
-		else
+
+		jobs[job_count++].node_info = cell->node_info;
+	}
+
+	log_verbose(LOG_DEBUG, "sibling_nodes_follow(): %i jobs, concurrency %i, timeout %i seconds",
+				job_count,
+				config_file_options.sibling_nodes_follow_concurrency,
+				config_file_options.sibling_nodes_follow_timeout);
+
+	while (completed_jobs < job_count)
+	{
+		/* start as many jobs as the concurrency limit permits */
+		while (running_jobs < config_file_options.sibling_nodes_follow_concurrency && next_job < job_count)
 		{
-			appendPQExpBufferStr(&remote_command_str,
-								 "standby follow 2>/dev/null && echo \"1\" || echo \"0\"");
+			if (start_sibling_follow_job(&jobs[next_job], local_node_record) == true)
+			{
+				running_jobs++;
+			}
+			else
+			{
+				completed_jobs++;
+			}
+			next_job++;
 		}
-		get_conninfo_value(cell->node_info->conninfo, "host", host);
-		log_debug("executing:\n  %s", remote_command_str.data);
 
-		initPQExpBuffer(&command_output);
+		for (i = 0; i < next_job; i++)
+		{
+			int			status;
+			pid_t		pid;
 
-		success = remote_command(host,
-								 runtime_options.remote_user,
-								 remote_command_str.data,
-								 config_file_options.ssh_options,
-								 &command_output);
+			if (jobs[i].pid == 0)
+				continue;
 
-		termPQExpBuffer(&remote_command_str);
+			pid = waitpid(jobs[i].pid, &status, WNOHANG);
 
-		if (success == false || command_output.data[0] == '0')
-		{
-			if (cell->node_info->type == WITNESS)
+			if (pid == jobs[i].pid)
 			{
-				log_warning(_("WITNESS REGISTER failed on node \"%s\""),
-							cell->node_info->node_name);
+				jobs[i].pid = 0;
+				jobs[i].success = (jobs[i].timed_out == false && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+				running_jobs--;
+				completed_jobs++;
+
+				log_verbose(LOG_DEBUG, "follow command on node \"%s\" completed after %i seconds",
+							jobs[i].node_info->node_name,
+							calculate_elapsed_seconds(jobs[i].start_time));
+				continue;
 			}
-			else
+
+			if (pid < 0 && errno != EINTR)
+			{
+				log_warning(_("unable to wait for follow command on node \"%s\""),
+							jobs[i].node_info->node_name);
+				log_detail("%s", strerror(errno));
+				jobs[i].pid = 0;
+				running_jobs--;
+				completed_jobs++;
+				continue;
+			}
+
+			/* terminate the SSH session if the deadline for this node has passed */
+			if (jobs[i].timed_out == false
+				&& calculate_elapsed_seconds(jobs[i].start_time) >= config_file_options.sibling_nodes_follow_timeout)
 			{
-				log_warning(_("STANDBY FOLLOW failed on node \"%s\""),
-							cell->node_info->node_name);
+				log_warning(_("follow command on node \"%s\" did not complete within %i seconds (\"sibling_nodes_follow_timeout\")"),
+							jobs[i].node_info->node_name,
+							config_file_options.sibling_nodes_follow_timeout);
+				jobs[i].timed_out = true;
+				kill(-jobs[i].pid, SIGTERM);
 			}
-				failed_follow_count++;
 		}
 
-		termPQExpBuffer(&command_output);
+		if (completed_jobs < job_count)
+			pg_usleep(SIBLING_FOLLOW_POLL_INTERVAL_MS * 1000L);
+	}
+
+	for (i = 0; i < job_count; i++)
+	{
+		if (jobs[i].success == true)
+		{
+			sibling_nodes_stats->followed_sibling_node_count++;
+			continue;
+		}
+
+		sibling_nodes_stats->failed_follow_sibling_node_count++;
+
+		if (jobs[i].timed_out == true)
+			sibling_nodes_stats->timed_out_follow_sibling_node_count++;
+
+		if (jobs[i].node_info->type == WITNESS)
+		{
+			log_warning(_("WITNESS REGISTER failed on node \"%s\""),
+						jobs[i].node_info->node_name);
+		}
+		else
+		{
+			log_warning(_("STANDBY FOLLOW failed on node \"%s\""),
+						jobs[i].node_info->node_name);
+		}
 	}
 
-	if (failed_follow_count == 0)
+	pfree(jobs);
+
+	if (sibling_nodes_stats->failed_follow_sibling_node_count == 0)
 	{
 		log_info(_("STANDBY FOLLOW successfully executed on all reachable sibling nodes"));
 	}
 	else
 	{
 		log_warning(_("execution of STANDBY FOLLOW failed on %i sibling nodes"),
-					failed_follow_count);
+					sibling_nodes_stats->failed_follow_sibling_node_count);
+
+		if (sibling_nodes_stats->timed_out_follow_sibling_node_count > 0)
+		{
+			log_detail(_("%i sibling nodes did not respond within %i seconds"),
+					   sibling_nodes_stats->timed_out_follow_sibling_node_count,
+					   config_file_options.sibling_nodes_follow_timeout);
+		}
 	}
 
 	/*
@@ -7468,6 +8767,267 @@ sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes
 }
 
 
+/*
+ * Start the follow command for a single sibling node via SSH in a child
+ * process. The child is placed in its own process group so that, if the
+ * per-node timeout expires, the SSH session can be terminated together
+ * with the shell which launched it.
+ */
+static bool
+start_sibling_follow_job(t_sibling_follow_job *job, t_node_info *local_node_record)
+{
+	char		host[MAXLEN] = "";
+	PQExpBufferData remote_command_str;
+	PQExpBufferData ssh_options;
+	PQExpBufferData ssh_command;
+	pid_t		pid;
+
+	initPQExpBuffer(&remote_command_str);
+	make_remote_repmgr_path(&remote_command_str, job->node_info);
+
+	if (job->node_info->type == WITNESS)
+	{
+		/* TODO: create "repmgr witness resync" or similar */
+		appendPQExpBuffer(&remote_command_str,
+						  "witness register -d \\'%s\\' --force >/dev/null 2>&1",
+						  local_node_record->conninfo);
+	}
+	else
+	{
+		appendPQExpBufferStr(&remote_command_str,
+							 "standby follow >/dev/null 2>&1");
+	}
+
+	get_conninfo_value(job->node_info->conninfo, "host", host);
+
+	/* the job runs in the background, so ssh must not read from stdin */
+	initPQExpBuffer(&ssh_options);
+	appendPQExpBuffer(&ssh_options, "-n %s", config_file_options.ssh_options);
+
+	initPQExpBuffer(&ssh_command);
+	make_remote_command(host,
+						runtime_options.remote_user,
+						remote_command_str.data,
+						ssh_options.data,
+						&ssh_command);
+
+	termPQExpBuffer(&ssh_options);
+	termPQExpBuffer(&remote_command_str);
+
+	log_debug("executing on node \"%s\":\n  %s",
+			  job->node_info->node_name,
+			  ssh_command.data);
+
+	/* ensure buffered output isn't duplicated in the child */
+	fflush(stdout);
+	fflush(stderr);
+
+	pid = fork();
+
+	if (pid < 0)
+	{
+		log_warning(_("unable to execute follow command on node \"%s\""),
+					job->node_info->node_name);
+		log_detail("%s", strerror(errno));
+		termPQExpBuffer(&ssh_command);
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		setpgid(0, 0);
+		execl("/bin/sh", "sh", "-c", ssh_command.data, (char *) NULL);
+		_exit(127);
+	}
+
+	/* also set in the parent, to avoid a race with kill() */
+	setpgid(pid, pid);
+
+	job->pid = pid;
+	INSTR_TIME_SET_CURRENT(job->start_time);
+
+	termPQExpBuffer(&ssh_command);
+
+	return true;
+}
+
+
+static int
+calculate_elapsed_seconds(instr_time start_time)
+{
+	instr_time	elapsed;
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+	return (int) INSTR_TIME_GET_DOUBLE(elapsed);
+}
+
+
+
+/*
+ * Record the end of the current switchover phase (if any) and the start of
+ * the next one; pass NULL to close the current phase only.
+ */
+static void
+switchover_timing_phase(const char *phase)
+{
+	instr_time	current_time;
+
+	INSTR_TIME_SET_CURRENT(current_time);
+
+	if (switchover_timing.current_phase == NULL && switchover_timing.phase_count == 0)
+	{
+		switchover_timing.start_time = current_time;
+	}
+	else if (switchover_timing.current_phase != NULL
+			 && switchover_timing.phase_count < SWITCHOVER_TIMING_MAX_ITEMS)
+	{
+		t_switchover_timing_item *item = &switchover_timing.phases[switchover_timing.phase_count++];
+		instr_time	elapsed = current_time;
+
+		INSTR_TIME_SUBTRACT(elapsed, switchover_timing.phase_start_time);
+
+		item->name = switchover_timing.current_phase;
+		item->elapsed_secs = INSTR_TIME_GET_DOUBLE(elapsed);
+
+		log_verbose(LOG_DEBUG, "switchover phase \"%s\" completed in %.3f seconds",
+					item->name, item->elapsed_secs);
+	}
+
+	switchover_timing.current_phase = phase;
+	switchover_timing.phase_start_time = current_time;
+}
+
+
+static void
+switchover_timing_remote_check(const char *check, instr_time start_time)
+{
+	instr_time	elapsed;
+	t_switchover_timing_item *item = NULL;
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+	if (runtime_options.dry_run == true)
+	{
+		log_verbose(LOG_INFO, _("remote check \"%s\" took %.3f seconds"),
+					check, INSTR_TIME_GET_DOUBLE(elapsed));
+	}
+
+	if (switchover_timing.remote_check_count >= SWITCHOVER_TIMING_MAX_ITEMS)
+		return;
+
+	item = &switchover_timing.remote_checks[switchover_timing.remote_check_count++];
+	item->name = check;
+	item->elapsed_secs = INSTR_TIME_GET_DOUBLE(elapsed);
+}
+
+
+/*
+ * Execute a command on the demotion candidate, recording how long it
+ * took for the --timing report.
+ */
+static bool
+switchover_remote_command(const char *check, const char *host, const char *command, PQExpBufferData *outputbuf)
+{
+	instr_time	start_time;
+	bool		success;
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	success = remote_command(host,
+							 runtime_options.remote_user,
+							 command,
+							 config_file_options.ssh_options,
+							 outputbuf);
+
+	switchover_timing_remote_check(check, start_time);
+
+	return success;
+}
+
+
+/*
+ * Emit the per-phase timings collected during "standby switchover",
+ * either as a table or as a single JSON object, if --timing was provided.
+ */
+static void
+report_switchover_timing(bool success)
+{
+	instr_time	total;
+	int			i;
+
+	switchover_timing_phase(NULL);
+
+	if (runtime_options.timing == false)
+		return;
+
+	INSTR_TIME_SET_CURRENT(total);
+	INSTR_TIME_SUBTRACT(total, switchover_timing.start_time);
+
+	if (runtime_options.timing_format == PROGRESS_FORMAT_JSON)
+	{
+		printf("{\"dry_run\": %s, \"success\": %s, \"total_seconds\": %.3f, \"phases\": [",
+			   runtime_options.dry_run == true ? "true" : "false",
+			   success == true ? "true" : "false",
+			   INSTR_TIME_GET_DOUBLE(total));
+
+		for (i = 0; i < switchover_timing.phase_count; i++)
+		{
+			printf("%s{\"phase\": \"%s\", \"seconds\": %.3f}",
+				   i > 0 ? ", " : "",
+				   switchover_timing.phases[i].name,
+				   switchover_timing.phases[i].elapsed_secs);
+		}
+
+		printf("], \"remote_checks\": [");
+
+		for (i = 0; i < switchover_timing.remote_check_count; i++)
+		{
+			printf("%s{\"check\": \"%s\", \"seconds\": %.3f}",
+				   i > 0 ? ", " : "",
+				   switchover_timing.remote_checks[i].name,
+				   switchover_timing.remote_checks[i].elapsed_secs);
+		}
+
+		printf("]}\n");
+		fflush(stdout);
+		return;
+	}
+
+	printf(" %-30s | %10s\n", _("Phase"), _("Seconds"));
+	printf("-%-30s-+-%10s\n",
+		   "------------------------------",
+		   "----------");
+
+	for (i = 0; i < switchover_timing.phase_count; i++)
+	{
+		printf(" %-30s | %10.3f\n",
+			   switchover_timing.phases[i].name,
+			   switchover_timing.phases[i].elapsed_secs);
+	}
+
+	printf(" %-30s | %10.3f\n", _("total"), INSTR_TIME_GET_DOUBLE(total));
+
+	if (switchover_timing.remote_check_count > 0)
+	{
+		printf("\n %-30s | %10s\n", _("Remote check"), _("Seconds"));
+		printf("-%-30s-+-%10s\n",
+			   "------------------------------",
+			   "----------");
+
+		for (i = 0; i < switchover_timing.remote_check_count; i++)
+		{
+			printf(" %-30s | %10.3f\n",
+				   switchover_timing.remote_checks[i].name,
+				   switchover_timing.remote_checks[i].elapsed_secs);
+		}
+	}
+
+	fflush(stdout);
+}
+
 
 static NodeStatus
 parse_node_status_is_shutdown_cleanly(const char *node_status_output, XLogRecPtr *checkPoint)
@@ -7526,6 +9086,10 @@ parse_node_status_is_shutdown_cleanly(const char *node_status_output, XLogRecPtr
 					{
 						node_status = NODE_STATUS_UNCLEAN_SHUTDOWN;
 					}
+					else if (strncmp(optarg, "SHUTTING_DOWN", MAXLEN) == 0)
+					{
+						node_status = NODE_STATUS_SHUTTING_DOWN;
+					}
 					else if (strncmp(optarg, "UNKNOWN", MAXLEN) == 0)
 					{
 						node_status = NODE_STATUS_UNKNOWN;
@@ -7775,6 +9339,10 @@ do_standby_help(void)
 	printf(_("  --upstream-node-id                  ID of the upstream node to replicate from (optional, defaults to primary node)\n"));
 	printf(_("  --without-barman                    do not use Barman even if configured\n"));
 	printf(_("  --recovery-conf-only                create \"recovery.conf\" file for a previously cloned instance\n"));
+	printf(_("  --progress[={text|json}]            report pg_basebackup progress, throughput and ETA as log\n" \
+			 "                                        lines (default) or as JSON lines on stdout\n"));
+	printf(_("  --parallel-tablespaces[=JOBS]       copy the data directory and each tablespace in parallel\n" \
+			 "                                        via rsync, with at most JOBS concurrent copies\n"));
 
 	puts("");
 
@@ -7828,6 +9396,7 @@ do_standby_help(void)
 	printf(_("  -R, --remote-user=USERNAME          database server username for SSH operations (default: \"%s\")\n"), runtime_options.username);
 	printf(_("  --repmgrd-no-pause                  don't pause repmgrd\n"));
 	printf(_("  --siblings-follow                   have other standbys follow new primary\n"));
+	printf(_("  --timing[={text|json}]              report time taken by each switchover phase and remote check\n"));
 
 	puts("");
 }
@@ -0,0 +1,494 @@
+/*
+ * repmgr-bench.c - micro-benchmarks for repmgr's parsing and query functions
+ *
+ * Measures the per-call latency, and (on glibc) the number and size of heap
+ * allocations, of functions which repmgrd calls on every monitoring cycle
+ * or on every configuration reload. Parsing functions are always measured;
+ * query functions are measured only if a connection string is provided.
+ *
+ * This program is not installed.
+ *
+ * Copyright (c) 2ndQuadrant, 2010-2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "repmgr.h"
+#include "configfile.h"
+#include "portability/instr_time.h"
+
+#define OPT_HELP	1
+
+#define DEFAULT_BENCH_ITERATIONS 10000
+#define DEFAULT_BENCH_DB_ITERATIONS 1000
+
+/*
+ * Representative repmgr.conf, used to measure configuration file parsing
+ * if no file is provided with -f/--config-file
+ */
+static const char *sample_config =
+"node_id=1\n"
+"node_name='node1'\n"
+"conninfo='host=node1 port=5432 user=repmgr dbname=repmgr connect_timeout=2'\n"
+"data_directory='/var/lib/postgresql/data'\n"
+"# comment\n"
+"use_replication_slots=yes\n"
+"location='dc1'\n"
+"priority=100\n"
+"log_level=INFO\n"
+"log_file='/var/log/repmgr/repmgrd.log'\n"
+"pg_bindir='/usr/lib/postgresql/bin'\n"
+"failover=automatic\n"
+"promote_command='repmgr standby promote -f /etc/repmgr.conf --log-to-file'\n"
+"follow_command='repmgr standby follow -f /etc/repmgr.conf --log-to-file --upstream-node-id=%n'\n"
+"monitor_interval_secs=2\n"
+"reconnect_attempts=6\n"
+"reconnect_interval=10\n"
+"connection_check_type=ping\n"
+"monitoring_history=yes\n"
+"degraded_monitoring_timeout=-1\n"
+"event_notification_command='/usr/local/bin/repmgr-event %n %e %s \"%t\" \"%d\"'\n"
+"event_notifications='repmgrd_failover_promote,repmgrd_failover_follow'\n"
+"ssh_options='-q -o ConnectTimeout=10'\n"
+"service_start_command='sudo systemctl start postgresql'\n"
+"service_stop_command='sudo systemctl stop postgresql'\n"
+"service_restart_command='sudo systemctl restart postgresql'\n"
+"service_reload_command='sudo systemctl reload postgresql'\n";
+
+static const char *sample_conninfo = "host=node1 port=5432 user=repmgr dbname=repmgr connect_timeout=2 application_name=node1";
+
+static const char *sample_lsn = "3F/A1B2C3D4";
+
+static int	iterations = DEFAULT_BENCH_ITERATIONS;
+static int	db_iterations = DEFAULT_BENCH_DB_ITERATIONS;
+static char *config_file = NULL;
+static char *conninfo = NULL;
+
+static PGconn *conn = NULL;
+static PGconn *repl_conn = NULL;
+static t_server_type node_type = UNKNOWN;
+static int	bench_node_id = UNKNOWN_NODE_ID;
+static t_system_identification identification = T_SYSTEM_IDENTIFICATION_INITIALIZER;
+
+static t_configuration_options config_options = T_CONFIGURATION_OPTIONS_INITIALIZER;
+
+/*
+ * On glibc, count heap allocations by interposing the allocator entry
+ * points; this covers allocations made by libpq as well as by repmgr.
+ */
+#ifdef __GLIBC__
+#define TRACK_ALLOCATIONS
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static uint64 alloc_count = 0;
+static uint64 alloc_bytes = 0;
+
+void *
+malloc(size_t size)
+{
+	alloc_count++;
+	alloc_bytes += size;
+
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+	alloc_count++;
+	alloc_bytes += nmemb * size;
+
+	return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	alloc_count++;
+	alloc_bytes += size;
+
+	return __libc_realloc(ptr, size);
+}
+#endif
+
+static void show_help(void);
+static void show_usage(void);
+
+static void run_benchmark(const char *name, void (*fn) (void), int count);
+static char *write_sample_config(void);
+
+static void bench_parse_lsn(void);
+static void bench_parse_conninfo_string(void);
+static void bench_param_get(void);
+static void bench_load_config(void);
+static void bench_get_replication_info(void);
+static void bench_get_all_node_records(void);
+static void bench_get_node_record(void);
+static void bench_get_timeline_history(void);
+static void bench_get_timeline_history_cached(void);
+
+
+int
+main(int argc, char **argv)
+{
+	int			optindex;
+	int			c;
+	char	   *sample_config_file = NULL;
+
+	static struct option long_options[] =
+	{
+		{"help", no_argument, NULL, OPT_HELP},
+		{"iterations", required_argument, NULL, 'n'},
+		{"db-iterations", required_argument, NULL, 'N'},
+		{"config-file", required_argument, NULL, 'f'},
+		{"dbname", required_argument, NULL, 'd'},
+		{NULL, 0, NULL, 0}
+	};
+
+	set_progname(argv[0]);
+
+	while ((c = getopt_long(argc, argv, "?n:N:f:d:", long_options, &optindex)) != -1)
+	{
+		switch (c)
+		{
+			case '?':
+				/* Actual help option given? */
+				if (strcmp(argv[optind - 1], "-?") == 0)
+				{
+					show_help();
+					exit(SUCCESS);
+				}
+				show_usage();
+				exit(ERR_BAD_CONFIG);
+
+			case OPT_HELP:
+				show_help();
+				exit(SUCCESS);
+
+			case 'n':
+				iterations = atoi(optarg);
+				break;
+
+			case 'N':
+				db_iterations = atoi(optarg);
+				break;
+
+			case 'f':
+				config_file = optarg;
+				break;
+
+			case 'd':
+				conninfo = optarg;
+				break;
+
+			default:
+				show_usage();
+				exit(ERR_BAD_CONFIG);
+		}
+	}
+
+	if (iterations <= 0 || db_iterations <= 0)
+	{
+		fprintf(stderr, _("%s: number of iterations must be a positive integer\n"), progname());
+		exit(ERR_BAD_CONFIG);
+	}
+
+	logger_set_level(LOG_WARNING);
+
+	if (config_file == NULL)
+	{
+		sample_config_file = write_sample_config();
+		config_file = sample_config_file;
+	}
+
+	printf("%-36s %10s %12s %12s %12s\n",
+		   "benchmark", "calls", "ns/call", "allocs/call", "bytes/call");
+
+	run_benchmark("parse_lsn", bench_parse_lsn, iterations);
+	run_benchmark("parse_conninfo_string", bench_parse_conninfo_string, iterations);
+	run_benchmark("param_get", bench_param_get, iterations);
+	run_benchmark("load_config", bench_load_config, iterations / 10 > 0 ? iterations / 10 : 1);
+
+	if (sample_config_file != NULL)
+	{
+		unlink(sample_config_file);
+		pfree(sample_config_file);
+	}
+
+	if (conninfo == NULL)
+		exit(SUCCESS);
+
+	conn = establish_db_connection(conninfo, true);
+
+	node_type = get_recovery_type(conn) == RECTYPE_STANDBY ? STANDBY : PRIMARY;
+
+	/* use the first registered node for single-record lookups */
+	{
+		NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
+
+		if (get_all_node_records(conn, &nodes) == true && nodes.head != NULL)
+			bench_node_id = nodes.head->node_info->node_id;
+
+		clear_node_info_list(&nodes);
+	}
+
+	run_benchmark("get_replication_info", bench_get_replication_info, db_iterations);
+	run_benchmark("get_all_node_records", bench_get_all_node_records, db_iterations);
+
+	if (bench_node_id != UNKNOWN_NODE_ID)
+		run_benchmark("get_node_record", bench_get_node_record, db_iterations);
+
+	/*
+	 * Timeline history is only available on a replication connection, and
+	 * only once the node is on a timeline later than the first.
+	 */
+	{
+		t_conninfo_param_list repl_conninfo = T_CONNINFO_PARAM_LIST_INITIALIZER;
+
+		initialize_conninfo_params(&repl_conninfo, false);
+		conn_to_param_list(conn, &repl_conninfo);
+		param_set(&repl_conninfo, "replication", "1");
+
+		repl_conn = establish_db_connection_by_params(&repl_conninfo, false);
+		free_conninfo_params(&repl_conninfo);
+	}
+
+	if (PQstatus(repl_conn) == CONNECTION_OK
+		&& identify_system(repl_conn, &identification) == true
+		&& identification.timeline > 1)
+	{
+		run_benchmark("get_timeline_history", bench_get_timeline_history, db_iterations);
+		run_benchmark("get_timeline_history (cached)", bench_get_timeline_history_cached, db_iterations);
+	}
+	else
+	{
+		printf("%-36s %s\n", "get_timeline_history", "skipped (replication connection unavailable or timeline 1)");
+	}
+
+	PQfinish(repl_conn);
+	PQfinish(conn);
+
+	return SUCCESS;
+}
+
+
+static void
+show_usage(void)
+{
+	fprintf(stderr, _("%s: micro-benchmarks for repmgr parsing and query functions\n"), progname());
+	fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname());
+}
+
+
+static void
+show_help(void)
+{
+	printf(_("%s: micro-benchmarks for repmgr parsing and query functions\n"), progname());
+	puts("");
+
+	printf(_("Usage:\n"));
+	printf(_("    %s [OPTIONS]\n"), progname());
+	printf(_("\n"));
+	printf(_("Options:\n"));
+	printf(_("  -?, --help                show this help, then exit\n"));
+	printf(_("  -n, --iterations=N        iterations for parsing benchmarks (default: %i)\n"), DEFAULT_BENCH_ITERATIONS);
+	printf(_("  -N, --db-iterations=N     iterations for query benchmarks (default: %i)\n"), DEFAULT_BENCH_DB_ITERATIONS);
+	printf(_("  -f, --config-file=PATH    configuration file to parse (default: built-in sample)\n"));
+	printf(_("  -d, --dbname=CONNINFO     conninfo of a node with the repmgr extension installed;\n" \
+			 "                            query benchmarks are only run if provided\n"));
+	puts("");
+}
+
+
+/*
+ * Call "fn" "count" times (after a short warm-up) and print the average
+ * time and allocations per call.
+ */
+static void
+run_benchmark(const char *name, void (*fn) (void), int count)
+{
+	instr_time	start_time;
+	instr_time	elapsed;
+	int			i;
+	int			warmup = count / 10 > 0 ? count / 10 : 1;
+
+#ifdef TRACK_ALLOCATIONS
+	uint64		start_alloc_count;
+	uint64		start_alloc_bytes;
+#endif
+
+	for (i = 0; i < warmup; i++)
+		fn();
+
+#ifdef TRACK_ALLOCATIONS
+	start_alloc_count = alloc_count;
+	start_alloc_bytes = alloc_bytes;
+#endif
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	for (i = 0; i < count; i++)
+		fn();
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+#ifdef TRACK_ALLOCATIONS
+	printf("%-36s %10i %12.0f %12.1f %12.0f\n",
+		   name,
+		   count,
+		   INSTR_TIME_GET_DOUBLE(elapsed) * 1000000000.0 / count,
+		   (double) (alloc_count - start_alloc_count) / count,
+		   (double) (alloc_bytes - start_alloc_bytes) / count);
+#else
+	printf("%-36s %10i %12.0f %12s %12s\n",
+		   name,
+		   count,
+		   INSTR_TIME_GET_DOUBLE(elapsed) * 1000000000.0 / count,
+		   "-",
+		   "-");
+#endif
+	fflush(stdout);
+}
+
+
+static char *
+write_sample_config(void)
+{
+	char	   *path = pg_malloc(MAXPGPATH);
+	const char *tmpdir = getenv("TMPDIR");
+	int			fd;
+	FILE	   *fp;
+
+	snprintf(path, MAXPGPATH, "%s/repmgr-bench.XXXXXX",
+			 tmpdir != NULL && tmpdir[0] != '\0' ? tmpdir : "/tmp");
+
+	fd = mkstemp(path);
+
+	if (fd < 0 || (fp = fdopen(fd, "w")) == NULL)
+	{
+		fprintf(stderr, _("%s: unable to create temporary configuration file \"%s\": %s\n"),
+				progname(), path, strerror(errno));
+		exit(ERR_BAD_CONFIG);
+	}
+
+	fputs(sample_config, fp);
+	fclose(fp);
+
+	return path;
+}
+
+
+static void
+bench_parse_lsn(void)
+{
+	(void) parse_lsn(sample_lsn);
+}
+
+
+static void
+bench_parse_conninfo_string(void)
+{
+	t_conninfo_param_list param_list = T_CONNINFO_PARAM_LIST_INITIALIZER;
+
+	initialize_conninfo_params(&param_list, false);
+	(void) parse_conninfo_string(sample_conninfo, &param_list, NULL, false);
+	free_conninfo_params(&param_list);
+}
+
+
+static void
+bench_param_get(void)
+{
+	static t_conninfo_param_list param_list = T_CONNINFO_PARAM_LIST_INITIALIZER;
+
+	if (param_list.keywords == NULL)
+	{
+		initialize_conninfo_params(&param_list, true);
+		(void) parse_conninfo_string(sample_conninfo, &param_list, NULL, false);
+	}
+
+	(void) param_get(&param_list, "application_name");
+	(void) param_get(&param_list, "connect_timeout");
+	(void) param_get(&param_list, "replication");
+}
+
+
+static void
+bench_load_config(void)
+{
+	load_config(config_file, false, true, &config_options, NULL);
+}
+
+
+static void
+bench_get_replication_info(void)
+{
+	ReplInfo	replication_info;
+
+	init_replication_info(&replication_info);
+
+	(void) get_replication_info(conn, node_type, &replication_info);
+}
+
+
+static void
+bench_get_all_node_records(void)
+{
+	NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
+
+	(void) get_all_node_records(conn, &nodes);
+	clear_node_info_list(&nodes);
+}
+
+
+static void
+bench_get_node_record(void)
+{
+	t_node_info node_info = T_NODE_INFO_INITIALIZER;
+
+	(void) get_node_record(conn, bench_node_id, &node_info);
+}
+
+
+static void
+bench_get_timeline_history(void)
+{
+	TimeLineHistoryEntry *history;
+
+	/* an unknown system identifier bypasses the cache */
+	history = get_timeline_history(repl_conn, UNKNOWN_SYSTEM_IDENTIFIER, UNKNOWN_NODE_ID, identification.timeline);
+
+	if (history != NULL)
+		pfree(history);
+}
+
+
+static void
+bench_get_timeline_history_cached(void)
+{
+	TimeLineHistoryEntry *history;
+
+	history = get_timeline_history(repl_conn, identification.system_identifier, UNKNOWN_NODE_ID, identification.timeline);
+
+	if (history != NULL)
+		pfree(history);
+}
@@ -25,9 +25,16 @@
 #define CONFIG_FILE_SAMEPATH 1
 #define CONFIG_FILE_PGDATA 2
 
+/* values for --progress and --timing */
+#define PROGRESS_FORMAT_TEXT 1
+#define PROGRESS_FORMAT_JSON 2
+
 /* default value for "cluster event --limit"*/
 #define CLUSTER_EVENT_LIMIT 20
 
+/* polling interval when waiting for a node to shut down */
+#define SHUTDOWN_CHECK_POLL_INTERVAL_MS 100
+
 typedef struct
 {
 	/* configuration metadata */
@@ -86,6 +93,10 @@ typedef struct
 	char		upstream_conninfo[MAXLEN];
 	bool		without_barman;
 	bool		recovery_conf_only;
+	bool		progress;
+	int			progress_format;
+	bool		parallel_tablespaces;
+	int			parallel_tablespaces_jobs;
 
 	/* "standby clone"/"standby follow" options */
 	int			upstream_node_id;
@@ -102,6 +113,8 @@ typedef struct
 	bool		siblings_follow;
 	bool		repmgrd_no_pause;
 	bool		repmgrd_force_unpause;
+	bool		timing;
+	int			timing_format;
 
 	/* "node status" options */
 	bool		is_shutdown_cleanly;
@@ -158,13 +171,13 @@ typedef struct
 		UNKNOWN_NODE_ID, "", "", UNKNOWN_NODE_ID, \
 		/* "standby clone" options */ \
 		false, CONFIG_FILE_SAMEPATH, false, false, false, "", "", "", \
-		false, false, \
+		false, false, false, PROGRESS_FORMAT_TEXT, false, 0, \
 		/* "standby clone"/"standby follow" options */ \
 		NO_UPSTREAM_NODE, \
 		/* "standby register" options */ \
 		false, -1, DEFAULT_WAIT_START,   \
 		/* "standby switchover" options */ \
-		false, false, "", false, false, false,	\
+		false, false, "", false, false, false, false, PROGRESS_FORMAT_TEXT,	\
 		/* "node status" options */ \
 		false, \
 		/* "node check" options */ \
@@ -185,7 +198,8 @@ typedef struct
 typedef enum
 {
 	barman,
-	pg_basebackup
+	pg_basebackup,
+	rsync
 } standy_clone_mode;
 
 typedef enum
@@ -233,6 +247,8 @@ extern standy_clone_mode get_standby_clone_mode(void);
 
 extern int copy_remote_files(char *host, char *remote_user, char *remote_path,
 				  char *local_path, bool is_directory, int server_version_num);
+extern void make_copy_remote_files_command(PQExpBufferData *script, char *host, char *remote_user, char *remote_path,
+										   char *local_path, bool is_directory, int server_version_num);
 
 extern void print_error_list(ItemList *error_list, int log_level);
 
@@ -257,7 +273,7 @@ extern void init_node_record(t_node_info *node_record);
 extern bool can_use_pg_rewind(PGconn *conn, const char *data_directory, PQExpBufferData *reason);
 extern void drop_replication_slot_if_exists(PGconn *conn, int node_id, char *slot_name);
 
-extern bool check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_record, bool is_rejoin);
+extern bool check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_record, bool is_rejoin, bool *rewind_required);
 extern void check_shared_library(PGconn *conn);
 extern bool is_repmgrd_running(PGconn *conn);
 
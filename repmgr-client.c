@@ -433,6 +433,35 @@ main(int argc, char **argv)
 				runtime_options.recovery_conf_only = true;
 				break;
 
+				/* --parallel-tablespaces[=JOBS] */
+			case OPT_PARALLEL_TABLESPACES:
+				runtime_options.parallel_tablespaces = true;
+				if (optarg != NULL)
+				{
+					runtime_options.parallel_tablespaces_jobs = repmgr_atoi(optarg, "--parallel-tablespaces", &cli_errors, 1);
+				}
+				break;
+
+				/* --progress[={text|json}] */
+			case OPT_PROGRESS:
+				runtime_options.progress = true;
+				if (optarg != NULL)
+				{
+					if (strcmp(optarg, "text") == 0)
+					{
+						runtime_options.progress_format = PROGRESS_FORMAT_TEXT;
+					}
+					else if (strcmp(optarg, "json") == 0)
+					{
+						runtime_options.progress_format = PROGRESS_FORMAT_JSON;
+					}
+					else
+					{
+						item_list_append(&cli_errors,
+										 _("value provided for \"--progress\" must be \"text\" or \"json\""));
+					}
+				}
+				break;
 
 				/*---------------------------
 				 * "standby register" options
@@ -482,6 +511,27 @@ main(int argc, char **argv)
 				runtime_options.repmgrd_force_unpause = true;
 				break;
 
+				/* --timing[={text|json}] */
+			case OPT_TIMING:
+				runtime_options.timing = true;
+				if (optarg != NULL)
+				{
+					if (strcmp(optarg, "text") == 0)
+					{
+						runtime_options.timing_format = PROGRESS_FORMAT_TEXT;
+					}
+					else if (strcmp(optarg, "json") == 0)
+					{
+						runtime_options.timing_format = PROGRESS_FORMAT_JSON;
+					}
+					else
+					{
+						item_list_append(&cli_errors,
+										 _("value provided for \"--timing\" must be \"text\" or \"json\""));
+					}
+				}
+				break;
+
 				/*----------------------
 				 * "node status" options
 				 *----------------------
@@ -1460,6 +1510,18 @@ check_cli_parameters(const int action)
 										 _("-c/--fast-checkpoint has no effect in Barman mode"));
 					}
 
+					if (runtime_options.progress)
+					{
+						item_list_append(&cli_warnings,
+										 _("--progress has no effect in Barman mode"));
+					}
+
+					if (runtime_options.parallel_tablespaces)
+					{
+						item_list_append(&cli_warnings,
+										 _("--parallel-tablespaces has no effect in Barman mode"));
+					}
+
 
 				}
 				else
@@ -1498,6 +1560,12 @@ check_cli_parameters(const int action)
 						item_list_append(&cli_warnings,
 										 _("--no-upstream-connection only effective in Barman mode"));
 					}
+
+					if (runtime_options.progress == true && runtime_options.parallel_tablespaces == true)
+					{
+						item_list_append(&cli_warnings,
+										 _("--progress has no effect when --parallel-tablespaces is provided"));
+					}
 				}
 
 				if (strlen(config_file_options.config_directory))
@@ -1710,6 +1778,32 @@ check_cli_parameters(const int action)
 		}
 	}
 
+	if (runtime_options.progress == true)
+	{
+		switch (action)
+		{
+			case STANDBY_CLONE:
+				break;
+			default:
+				item_list_append_format(&cli_warnings,
+										_("--progress will be ignored when executing %s"),
+										action_name(action));
+		}
+	}
+
+	if (runtime_options.parallel_tablespaces == true)
+	{
+		switch (action)
+		{
+			case STANDBY_CLONE:
+				break;
+			default:
+				item_list_append_format(&cli_warnings,
+										_("--parallel-tablespaces will be ignored when executing %s"),
+										action_name(action));
+		}
+	}
+
 	if (runtime_options.event[0])
 	{
 		switch (action)
@@ -1772,6 +1866,13 @@ check_cli_parameters(const int action)
 				case DAEMON_STOP:
 				case STANDBY_FOLLOW:
 					break;
+				case NODE_STATUS:
+					if (runtime_options.is_shutdown_cleanly == true)
+						break;
+					item_list_append_format(&cli_warnings,
+											_("--wait can only be used with --is-shutdown-cleanly when executing %s"),
+											action_name(action));
+					break;
 				default:
 					item_list_append_format(&cli_warnings,
 											_("--wait will be ignored when executing %s"),
@@ -1878,6 +1979,19 @@ check_cli_parameters(const int action)
 		}
 	}
 
+	if (runtime_options.timing == true)
+	{
+		switch (action)
+		{
+			case STANDBY_SWITCHOVER:
+				break;
+			default:
+				item_list_append_format(&cli_warnings,
+										_("--timing will be ignored when executing %s"),
+										action_name(action));
+		}
+	}
+
 	if (runtime_options.config_files[0] != '\0')
 	{
 		switch (action)
@@ -3000,6 +3114,8 @@ get_standby_clone_mode(void)
 
 	if (*config_file_options.barman_host != '\0' && runtime_options.without_barman == false)
 		mode = barman;
+	else if (runtime_options.parallel_tablespaces == true)
+		mode = rsync;
 	else
 		mode = pg_basebackup;
 
@@ -3019,11 +3135,41 @@ make_pg_path(const char *file)
 int
 copy_remote_files(char *host, char *remote_user, char *remote_path,
 				  char *local_path, bool is_directory, int server_version_num)
+{
+	PQExpBufferData script;
+	int			r = 0;
+
+	initPQExpBuffer(&script);
+
+	make_copy_remote_files_command(&script, host, remote_user, remote_path,
+								   local_path, is_directory, server_version_num);
+
+	log_info(_("rsync command line:\n  %s"), script.data);
+
+	r = system(script.data);
+
+	termPQExpBuffer(&script);
+
+	log_debug("copy_remote_files(): r = %i; WIFEXITED: %i; WEXITSTATUS: %i", r, WIFEXITED(r), WEXITSTATUS(r));
+
+	/* exit code 24 indicates vanished files, which isn't a problem for us */
+	if (WIFEXITED(r) && WEXITSTATUS(r) && WEXITSTATUS(r) != 24)
+		log_verbose(LOG_WARNING, "copy_remote_files(): rsync returned unexpected exit status %i", WEXITSTATUS(r));
+
+	return r;
+}
+
+
+/*
+ * Build the rsync command used by copy_remote_files(); also used directly
+ * by callers which need to execute several copies concurrently.
+ */
+void
+make_copy_remote_files_command(PQExpBufferData *script, char *host, char *remote_user, char *remote_path,
+							   char *local_path, bool is_directory, int server_version_num)
 {
 	PQExpBufferData rsync_flags;
-	char		script[MAXLEN] = "";
 	char		host_string[MAXLEN] = "";
-	int			r = 0;
 
 	initPQExpBuffer(&rsync_flags);
 
@@ -3060,9 +3206,6 @@ copy_remote_files(char *host, char *remote_user, char *remote_path,
 	 * See function 'sendDir()' in 'src/backend/replication/basebackup.c' -
 	 * we're basically simulating what pg_basebackup does, but with rsync
 	 * rather than the BASEBACKUP replication protocol command.
-	 *
-	 * *However* currently we'll always copy the contents of the 'pg_replslot'
-	 * directory and delete later if appropriate.
 	 */
 	if (is_directory)
 	{
@@ -3073,6 +3216,13 @@ copy_remote_files(char *host, char *remote_user, char *remote_path,
 		appendPQExpBuffer(&rsync_flags, "%s",
 						  " --exclude=recovery.conf --exclude=recovery.done");
 
+		/*
+		 * Any backup label or tablespace map will be left over from an
+		 * exclusive backup; for a non-exclusive backup we'll write our own
+		 */
+		appendPQExpBuffer(&rsync_flags, "%s",
+						  " --exclude=backup_label --exclude=tablespace_map");
+
 		if (server_version_num >= 90400)
 		{
 			/*
@@ -3103,28 +3253,24 @@ copy_remote_files(char *host, char *remote_user, char *remote_path,
 		appendPQExpBuffer(&rsync_flags, "%s",
 						  " --exclude=pg_log/* --exclude=pg_stat_tmp/*");
 
-		maxlen_snprintf(script, "rsync %s %s:%s/* %s",
-						rsync_flags.data, host_string, remote_path, local_path);
+		/*
+		 * Replication slots and transient state are not valid on the
+		 * cloned node
+		 */
+		appendPQExpBuffer(&rsync_flags, "%s",
+						  " --exclude=pg_replslot/* --exclude=pg_dynshmem/* --exclude=pg_notify/*"
+						  " --exclude=pg_serial/* --exclude=pg_snapshots/* --exclude=pg_subtrans/*");
+
+		appendPQExpBuffer(script, "rsync %s %s:%s/* %s",
+						  rsync_flags.data, host_string, remote_path, local_path);
 	}
 	else
 	{
-		maxlen_snprintf(script, "rsync %s %s:%s %s",
-						rsync_flags.data, host_string, remote_path, local_path);
+		appendPQExpBuffer(script, "rsync %s %s:%s %s",
+						  rsync_flags.data, host_string, remote_path, local_path);
 	}
 
 	termPQExpBuffer(&rsync_flags);
-
-	log_info(_("rsync command line:\n  %s"), script);
-
-	r = system(script);
-
-	log_debug("copy_remote_files(): r = %i; WIFEXITED: %i; WEXITSTATUS: %i", r, WIFEXITED(r), WEXITSTATUS(r));
-
-	/* exit code 24 indicates vanished files, which isn't a problem for us */
-	if (WIFEXITED(r) && WEXITSTATUS(r) && WEXITSTATUS(r) != 24)
-		log_verbose(LOG_WARNING, "copy_remote_files(): rsync returned unexpected exit status %i", WEXITSTATUS(r));
-
-	return r;
 }
 
 
@@ -3625,10 +3771,14 @@ drop_replication_slot_if_exists(PGconn *conn, int node_id, char *slot_name)
  * Here we'll perform some timeline sanity checks to ensure the follow target
  * can actually be followed.
  *
+ * If "rewind_required" is provided, it will be set to true if the node can
+ * only attach to the target after executing pg_rewind (only applicable when
+ * called by "node rejoin" with --force-rewind).
+ *
  * See also comment for check_node_can_follow() in repmgrd-physical.c .
  */
 bool
-check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_record, bool is_rejoin)
+check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_record, bool is_rejoin, bool *rewind_required)
 {
 	uint64		local_system_identifier = UNKNOWN_SYSTEM_IDENTIFIER;
 	t_conninfo_param_list follow_target_repl_conninfo = T_CONNINFO_PARAM_LIST_INITIALIZER;
@@ -3639,6 +3789,9 @@ check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *fo
 
 	const char *action = is_rejoin == true ? "rejoin" : "follow";
 
+	if (rewind_required != NULL)
+		*rewind_required = false;
+
 	/* check replication connection */
 	initialize_conninfo_params(&follow_target_repl_conninfo, false);
 
@@ -3752,7 +3905,10 @@ check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *fo
 		/*
 		 * upstream has higher timeline - check where it forked off from this node's timeline
 		 */
-		follow_target_history = get_timeline_history(follow_target_repl_conn, local_tli + 1);
+		follow_target_history = get_timeline_history(follow_target_repl_conn,
+													 follow_target_identification.system_identifier,
+													 follow_target_node_record->node_id,
+													 local_tli + 1);
 
 		if (follow_target_history == NULL)
 		{
@@ -3780,6 +3936,9 @@ check_node_can_attach(TimeLineID local_tli, XLogRecPtr local_xlogpos, PGconn *fo
 			{
 				log_notice(_("pg_rewind execution required for this node to attach to rejoin target node %i"),
 						   follow_target_node_record->node_id);
+
+				if (rewind_required != NULL)
+					*rewind_required = true;
 			}
 			else
 			{
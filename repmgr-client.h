@@ -100,6 +100,9 @@
 #define OPT_ENABLE_WAL_RECEIVER			   1045
 #define OPT_DETAIL						   1046
 #define OPT_REPMGRD_FORCE_UNPAUSE		   1047
+#define OPT_PROGRESS					   1048
+#define OPT_PARALLEL_TABLESPACES		   1049
+#define OPT_TIMING						   1050
 
 /* deprecated since 3.3 */
 #define OPT_DATA_DIR						999
@@ -163,6 +166,8 @@ static struct option long_options[] =
 	{"upstream-node-id", required_argument, NULL, OPT_UPSTREAM_NODE_ID},
 	{"without-barman", no_argument, NULL, OPT_WITHOUT_BARMAN},
 	{"recovery-conf-only", no_argument, NULL, OPT_RECOVERY_CONF_ONLY},
+	{"progress", optional_argument, NULL, OPT_PROGRESS},
+	{"parallel-tablespaces", optional_argument, NULL, OPT_PARALLEL_TABLESPACES},
 
 /* "standby register" options */
 	{"wait-start", required_argument, NULL, OPT_WAIT_START},
@@ -176,6 +181,7 @@ static struct option long_options[] =
 	{"siblings-follow", no_argument, NULL, OPT_SIBLINGS_FOLLOW},
 	{"repmgrd-no-pause", no_argument, NULL, OPT_REPMGRD_NO_PAUSE},
 	{"repmgrd-force-unpause", no_argument, NULL, OPT_REPMGRD_FORCE_UNPAUSE},
+	{"timing", optional_argument, NULL, OPT_TIMING},
 
 /* "node status" options */
 	{"is-shutdown-cleanly", no_argument, NULL, OPT_IS_SHUTDOWN_CLEANLY},
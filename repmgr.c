@@ -76,6 +76,7 @@ typedef struct repmgrdSharedState
 	int			local_node_id;
 	int			repmgrd_pid;
 	char		repmgrd_pidfile[MAXPGPATH];
+	bool		repmgrd_wakeup_signal;	/* repmgrd handles SIGUSR1 */
 	bool		repmgrd_paused;
 	/* streaming failover */
 	int			upstream_node_id;
@@ -97,6 +98,7 @@ void		_PG_init(void);
 void		_PG_fini(void);
 
 static void repmgr_shmem_startup(void);
+static bool repmgrd_pidfile_matches(const char *pidfile, int repmgrd_pid);
 
 Datum		set_local_node_id(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(set_local_node_id);
@@ -116,6 +118,9 @@ PG_FUNCTION_INFO_V1(set_upstream_last_seen);
 Datum		get_upstream_last_seen(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(get_upstream_last_seen);
 
+Datum		get_upstream_last_seen_ms(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(get_upstream_last_seen_ms);
+
 Datum		get_upstream_node_id(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(get_upstream_node_id);
 
@@ -146,6 +151,9 @@ PG_FUNCTION_INFO_V1(get_repmgrd_pid);
 Datum		get_repmgrd_pidfile(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(get_repmgrd_pidfile);
 
+Datum		set_repmgrd_wakeup_signal(PG_FUNCTION_ARGS);
+PG_FUNCTION_INFO_V1(set_repmgrd_wakeup_signal);
+
 Datum		repmgrd_is_running(PG_FUNCTION_ARGS);
 PG_FUNCTION_INFO_V1(repmgrd_is_running);
 
@@ -233,6 +241,7 @@ repmgr_shmem_startup(void)
 		shared_state->local_node_id = UNKNOWN_NODE_ID;
 		shared_state->repmgrd_pid = UNKNOWN_PID;
 		memset(shared_state->repmgrd_pidfile, 0, MAXPGPATH);
+		shared_state->repmgrd_wakeup_signal = false;
 		shared_state->repmgrd_paused = false;
 		shared_state->current_electoral_term = 0;
 		shared_state->upstream_node_id = UNKNOWN_NODE_ID;
@@ -430,6 +439,36 @@ get_upstream_last_seen(PG_FUNCTION_ARGS)
 }
 
 
+/*
+ * As get_upstream_last_seen(), but with millisecond resolution, for use
+ * where the monitoring interval is too coarse a measure.
+ */
+Datum
+get_upstream_last_seen_ms(PG_FUNCTION_ARGS)
+{
+	long		secs;
+	int			microsecs;
+	TimestampTz last_seen;
+
+	if (!shared_state)
+		PG_RETURN_INT64(-1);
+
+	LWLockAcquire(shared_state->lock, LW_SHARED);
+
+	last_seen = shared_state->upstream_last_seen;
+
+	LWLockRelease(shared_state->lock);
+
+	if (last_seen == POSTGRES_EPOCH_JDATE)
+		PG_RETURN_INT64(-1);
+
+	TimestampDifference(last_seen, GetCurrentTimestamp(),
+						&secs, &microsecs);
+
+	PG_RETURN_INT64((int64) secs * 1000 + microsecs / 1000);
+}
+
+
 Datum
 get_upstream_node_id(PG_FUNCTION_ARGS)
 {
@@ -485,6 +524,8 @@ Datum
 notify_follow_primary(PG_FUNCTION_ARGS)
 {
 	int			primary_node_id = UNKNOWN_NODE_ID;
+	int			repmgrd_pid = UNKNOWN_PID;
+	char		repmgrd_pidfile[MAXPGPATH];
 
 	if (!shared_state)
 		PG_RETURN_VOID();
@@ -516,10 +557,38 @@ notify_follow_primary(PG_FUNCTION_ARGS)
 		/* Explicitly set the primary node id */
 		shared_state->candidate_node_id = primary_node_id;
 		shared_state->follow_new_primary = true;
+
+		/*
+		 * Only signal a repmgrd which has declared it handles SIGUSR1; for
+		 * any other version, the signal's default action would terminate it.
+		 */
+		if (shared_state->repmgrd_wakeup_signal == true)
+		{
+			repmgrd_pid = shared_state->repmgrd_pid;
+			strncpy(repmgrd_pidfile, shared_state->repmgrd_pidfile, MAXPGPATH);
+		}
 	}
 
 	LWLockRelease(shared_state->lock);
 
+	/*
+	 * Wake repmgrd, which may be waiting for this notification; if the
+	 * signal can't (safely) be sent, it will pick up the notification at
+	 * its next check anyway.
+	 *
+	 * The registered PID is stale if repmgrd exited without deregistering
+	 * itself (e.g. was killed), and may since have been reused by another
+	 * process, so only signal it if it's still the PID in repmgrd's PID file.
+	 */
+	if (repmgrd_pid != UNKNOWN_PID)
+	{
+		if (repmgrd_pidfile_matches(repmgrd_pidfile, repmgrd_pid) == false)
+			elog(DEBUG1, "PID file \"%s\" does not contain repmgrd PID %i, not signalling",
+				 repmgrd_pidfile, repmgrd_pid);
+		else if (kill(repmgrd_pid, SIGUSR1) != 0)
+			elog(DEBUG1, "unable to signal repmgrd (PID %i)", repmgrd_pid);
+	}
+
 	PG_RETURN_VOID();
 }
 
@@ -702,6 +771,9 @@ set_repmgrd_pid(PG_FUNCTION_ARGS)
 	shared_state->repmgrd_pid = repmgrd_pid;
 	memset(shared_state->repmgrd_pidfile, 0, MAXPGPATH);
 
+	/* repmgrd must (re)declare it handles SIGUSR1 after registering itself */
+	shared_state->repmgrd_wakeup_signal = false;
+
 	if(repmgrd_pidfile != NULL)
 	{
 		strncpy(shared_state->repmgrd_pidfile, repmgrd_pidfile, MAXPGPATH);
@@ -712,6 +784,58 @@ set_repmgrd_pid(PG_FUNCTION_ARGS)
 }
 
 
+/*
+ * Called by repmgrd once it has installed its SIGUSR1 handler, to indicate
+ * notify_follow_primary() can wake it with that signal.
+ */
+Datum
+set_repmgrd_wakeup_signal(PG_FUNCTION_ARGS)
+{
+	bool		wakeup_signal = PG_GETARG_BOOL(0);
+
+	if (!shared_state)
+		PG_RETURN_VOID();
+
+	LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+
+	if (shared_state->repmgrd_pid != UNKNOWN_PID)
+		shared_state->repmgrd_wakeup_signal = wakeup_signal;
+
+	LWLockRelease(shared_state->lock);
+
+	PG_RETURN_VOID();
+}
+
+
+/*
+ * Verify the PID file written by repmgrd contains the provided PID.
+ *
+ * Returns false if no PID file was registered or it can't be read.
+ */
+static bool
+repmgrd_pidfile_matches(const char *pidfile, int repmgrd_pid)
+{
+	FILE	   *file = NULL;
+	int			file_pid = UNKNOWN_PID;
+	bool		matches = false;
+
+	if (pidfile[0] == '\0')
+		return false;
+
+	file = AllocateFile(pidfile, PG_BINARY_R);
+
+	if (file == NULL)
+		return false;
+
+	if (fscanf(file, "%d", &file_pid) == 1 && file_pid == repmgrd_pid)
+		matches = true;
+
+	FreeFile(file);
+
+	return matches;
+}
+
+
 Datum
 repmgrd_is_running(PG_FUNCTION_ARGS)
 {
@@ -76,11 +76,18 @@
 #define DEFAULT_PRIORITY		             100
 #define DEFAULT_RECONNECTION_ATTEMPTS        6	 /* seconds */
 #define DEFAULT_RECONNECTION_INTERVAL        10  /* seconds */
+#define DEFAULT_RECONNECT_TIMEOUT_MS         -1
+#define DEFAULT_RECONNECT_REFUSED_ATTEMPTS   -1
+#define DEFAULT_CONNECTION_POOL_IDLE_TIMEOUT 60	 /* seconds */
+#define DEFAULT_PRIMARY_HEARTBEAT_INTERVAL_MS 0	 /* milliseconds; 0 = disabled */
+#define DEFAULT_PRIMARY_HEARTBEAT_TIMEOUT_MS -1	 /* milliseconds; -1 = 3 * interval */
 #define DEFAULT_MONITORING_INTERVAL          2	 /* seconds */
 #define DEFAULT_ASYNC_QUERY_TIMEOUT          60  /* seconds */
 #define DEFAULT_PRIMARY_NOTIFICATION_TIMEOUT 60  /* seconds */
 #define DEFAULT_PRIMARY_FOLLOW_TIMEOUT       60  /* seconds */
 #define DEFAULT_STANDBY_FOLLOW_TIMEOUT       30  /* seconds */
+#define DEFAULT_SIBLING_NODES_FOLLOW_CONCURRENCY 4
+#define DEFAULT_SIBLING_NODES_FOLLOW_TIMEOUT 120 /* seconds */
 #define DEFAULT_BDR_RECOVERY_TIMEOUT         30  /* seconds */
 #define DEFAULT_ARCHIVE_READY_WARNING        16  /* WAL files */
 #define DEFAULT_ARCHIVE_READY_CRITICAL       128 /* WAL files */
@@ -95,6 +102,10 @@
 #define DEFAULT_NODE_REJOIN_TIMEOUT          60  /* seconds */
 #define DEFAULT_WAL_RECEIVE_CHECK_TIMEOUT    30  /* seconds */
 #define DEFAULT_SIBLING_NODES_DISCONNECT_TIMEOUT 30 /* seconds */
+#define DEFAULT_STANDBY_DISCONNECT_TIMEOUT   30  /* seconds */
+#define DEFAULT_PRIMARY_VISIBILITY_CONSENSUS_QUORUM 1
+#define DEFAULT_PRIMARY_VISIBILITY_CONSENSUS_TIMEOUT 5 /* seconds */
+#define DEFAULT_PRIMARY_VISIBILITY_THRESHOLD -1 /* milliseconds */
 #define DEFAULT_ELECTION_RERUN_INTERVAL      15  /* seconds */
 #define DEFAULT_CHILD_NODES_CHECK_INTERVAL   5   /* seconds */
 #define DEFAULT_CHILD_NODES_DISCONNECT_MIN_COUNT -1
@@ -310,16 +310,20 @@ loop:
 
 		if (got_SIGHUP)
 		{
+			int			config_reloaded = reload_config(&config_file_options, BDR);
+
 			/*
-			 * if we can reload, then could need to change local_conn
+			 * if "conninfo" has changed, then we need to change local_conn
 			 */
-			if (reload_config(&config_file_options, BDR))
+			if (config_reloaded & CONFIG_RELOAD_CONNECTION)
 			{
 				PQfinish(local_conn);
 				local_conn = establish_db_connection(config_file_options.conninfo, true);
-				update_registration(local_conn);
 			}
 
+			if (config_reloaded & (CONFIG_RELOAD_CONNECTION | CONFIG_RELOAD_OTHER))
+				update_registration(local_conn);
+
 			got_SIGHUP = false;
 		}
 
@@ -328,7 +332,7 @@ loop:
 		{
 			log_debug("SIGHUP received");
 
-			if (reload_config(&config_file_options, BDR))
+			if (reload_config(&config_file_options, BDR) & CONFIG_RELOAD_CONNECTION)
 			{
 				PQfinish(local_conn);
 				local_conn = establish_db_connection(config_file_options.conninfo, true);
@@ -0,0 +1,369 @@
+/*
+ * repmgrd-election-test.c - tests for repmgrd's failover election decisions
+ *
+ * Runs the decision functions in repmgrd-election.c against scripted
+ * sibling node states and checks the outcome. No database connection
+ * is required.
+ *
+ * This program is not installed; run it with "make election-check".
+ *
+ * Copyright (c) 2ndQuadrant, 2010-2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "repmgr.h"
+#include "repmgrd-election.h"
+
+#define PRIMARY_NODE_ID 1
+
+/*
+ * state of a sibling node, as gathered by do_election(); "reachable" is
+ * false if the node's replication state could not be retrieved
+ */
+typedef struct
+{
+	int			node_id;
+	t_server_type type;
+	int			priority;
+	XLogRecPtr	last_wal_receive_lsn;
+	int			upstream_node_id;
+	int			upstream_last_seen;
+	bool		reachable;
+} t_scripted_node;
+
+static int	tests_run = 0;
+static int	tests_failed = 0;
+
+static void check(bool result, const char *description);
+static int	run_election(t_scripted_node *local_node, t_scripted_node *siblings, int sibling_count, int threshold_ms, int *nodes_with_primary_visible);
+static void test_visibility_threshold(void);
+static void test_primary_visibility(void);
+static void test_majority(void);
+static void test_candidate_comparison(void);
+static void test_scripted_elections(void);
+
+
+static void
+check(bool result, const char *description)
+{
+	tests_run++;
+
+	if (result == true)
+	{
+		printf("ok %i - %s\n", tests_run, description);
+	}
+	else
+	{
+		tests_failed++;
+		printf("not ok %i - %s\n", tests_run, description);
+	}
+}
+
+
+/*
+ * Build the sibling node list do_election() passes to
+ * select_promotion_candidate() from the scripted node states, and return
+ * the ID of the selected promotion candidate. Nodes with "reachable" unset
+ * are treated as nodes whose state could not be retrieved.
+ */
+static int
+run_election(t_scripted_node *local_node, t_scripted_node *siblings, int sibling_count, int threshold_ms, int *nodes_with_primary_visible)
+{
+	t_node_info local_node_info = T_NODE_INFO_INITIALIZER;
+	NodeInfoList sibling_nodes = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoListCell *cell = NULL;
+	PQExpBufferData nodes_with_primary_visible_details;
+	int			candidate_node_id;
+	int			i;
+
+	local_node_info.node_id = local_node->node_id;
+	local_node_info.priority = local_node->priority;
+	local_node_info.last_wal_receive_lsn = local_node->last_wal_receive_lsn;
+
+	for (i = 0; i < sibling_count; i++)
+	{
+		cell = (NodeInfoListCell *) pg_malloc0(sizeof(NodeInfoListCell));
+		cell->node_info = (t_node_info *) pg_malloc0(sizeof(t_node_info));
+
+		cell->node_info->node_id = siblings[i].node_id;
+		cell->node_info->type = siblings[i].type;
+		cell->node_info->priority = siblings[i].priority;
+
+		if (siblings[i].reachable == true)
+		{
+			cell->node_info->replication_info = (ReplInfo *) pg_malloc0(sizeof(ReplInfo));
+			cell->node_info->replication_info->in_recovery = true;
+			cell->node_info->replication_info->last_wal_receive_lsn = siblings[i].last_wal_receive_lsn;
+			cell->node_info->replication_info->upstream_node_id = siblings[i].upstream_node_id;
+			cell->node_info->replication_info->upstream_last_seen = siblings[i].upstream_last_seen;
+		}
+
+		if (sibling_nodes.tail)
+			sibling_nodes.tail->next = cell;
+		else
+			sibling_nodes.head = cell;
+
+		sibling_nodes.tail = cell;
+		sibling_nodes.node_count++;
+	}
+
+	initPQExpBuffer(&nodes_with_primary_visible_details);
+
+	candidate_node_id = select_promotion_candidate(&local_node_info,
+												   &sibling_nodes,
+												   PRIMARY_NODE_ID,
+												   threshold_ms,
+												   nodes_with_primary_visible,
+												   &nodes_with_primary_visible_details)->node_id;
+
+	termPQExpBuffer(&nodes_with_primary_visible_details);
+
+	cell = sibling_nodes.head;
+
+	while (cell != NULL)
+	{
+		NodeInfoListCell *next_cell = cell->next;
+
+		if (cell->node_info->replication_info != NULL)
+			pfree(cell->node_info->replication_info);
+
+		pfree(cell->node_info);
+		pfree(cell);
+
+		cell = next_cell;
+	}
+
+	return candidate_node_id;
+}
+
+
+static void
+test_visibility_threshold(void)
+{
+	check(calculate_primary_visibility_threshold(-1, 2) == 4000,
+		  "threshold defaults to two monitoring intervals");
+	check(calculate_primary_visibility_threshold(1500, 2) == 1500,
+		  "explicit threshold is used as-is");
+	check(calculate_primary_visibility_threshold(0, 2) == 0,
+		  "zero threshold is not replaced by the default");
+}
+
+
+static void
+test_primary_visibility(void)
+{
+	check(classify_primary_visibility(500, PRIMARY_NODE_ID, PRIMARY_NODE_ID, 4000) == PRIMARY_SEEN,
+		  "primary seen within threshold is visible");
+	check(classify_primary_visibility(3999, PRIMARY_NODE_ID, PRIMARY_NODE_ID, 4000) == PRIMARY_SEEN,
+		  "primary seen just inside threshold is visible");
+	check(classify_primary_visibility(4000, PRIMARY_NODE_ID, PRIMARY_NODE_ID, 4000) == PRIMARY_NOT_SEEN,
+		  "primary seen at threshold is not visible");
+	check(classify_primary_visibility(-1, PRIMARY_NODE_ID, PRIMARY_NODE_ID, 4000) == PRIMARY_NOT_SEEN,
+		  "primary never seen is not visible");
+	check(classify_primary_visibility(500, 3, PRIMARY_NODE_ID, 4000) == PRIMARY_SEEN_OTHER_UPSTREAM,
+		  "recently seen node other than the primary is reported");
+	check(classify_primary_visibility(5000, 3, PRIMARY_NODE_ID, 4000) == PRIMARY_NOT_SEEN,
+		  "other upstream outside threshold is not visible");
+	check(classify_primary_visibility(0, PRIMARY_NODE_ID, PRIMARY_NODE_ID, 0) == PRIMARY_NOT_SEEN,
+		  "zero threshold never considers the primary visible");
+}
+
+
+static void
+test_majority(void)
+{
+	check(visible_nodes_form_majority(1, 1) == true,
+		  "single node is a majority of one");
+	check(visible_nodes_form_majority(1, 2) == false,
+		  "one of two nodes is not a majority");
+	check(visible_nodes_form_majority(2, 3) == true,
+		  "two of three nodes is a majority");
+	check(visible_nodes_form_majority(2, 4) == false,
+		  "two of four nodes is not a majority");
+	check(visible_nodes_form_majority(3, 4) == true,
+		  "three of four nodes is a majority");
+}
+
+
+static void
+test_candidate_comparison(void)
+{
+	t_node_info candidate = T_NODE_INFO_INITIALIZER;
+	t_node_info node = T_NODE_INFO_INITIALIZER;
+
+	candidate.node_id = 2;
+	candidate.priority = 100;
+	candidate.last_wal_receive_lsn = 0x3000060;
+
+	node.node_id = 3;
+	node.priority = 100;
+
+	node.last_wal_receive_lsn = 0x3000100;
+	check(compare_promotion_candidates(&node, &candidate) == CANDIDATE_LSN_AHEAD,
+		  "node with higher LSN is ahead");
+
+	node.last_wal_receive_lsn = 0x3000000;
+	node.priority = 200;
+	check(compare_promotion_candidates(&node, &candidate) == CANDIDATE_LSN_BEHIND,
+		  "node with lower LSN is behind regardless of priority");
+
+	node.last_wal_receive_lsn = candidate.last_wal_receive_lsn;
+	check(compare_promotion_candidates(&node, &candidate) == CANDIDATE_PRIORITY_HIGHER,
+		  "same LSN, higher priority");
+
+	node.priority = 50;
+	check(compare_promotion_candidates(&node, &candidate) == CANDIDATE_PRIORITY_LOWER,
+		  "same LSN, lower priority");
+
+	node.priority = candidate.priority;
+	check(compare_promotion_candidates(&node, &candidate) == CANDIDATE_NODE_ID_HIGHER,
+		  "same LSN and priority, higher node ID");
+
+	node.node_id = 1;
+	check(compare_promotion_candidates(&node, &candidate) == CANDIDATE_NODE_ID_LOWER,
+		  "same LSN and priority, lower node ID");
+
+	check(is_preferred_promotion_candidate(CANDIDATE_LSN_AHEAD) == true
+		  && is_preferred_promotion_candidate(CANDIDATE_PRIORITY_HIGHER) == true
+		  && is_preferred_promotion_candidate(CANDIDATE_NODE_ID_LOWER) == true,
+		  "preferred comparisons replace the candidate");
+	check(is_preferred_promotion_candidate(CANDIDATE_LSN_BEHIND) == false
+		  && is_preferred_promotion_candidate(CANDIDATE_PRIORITY_LOWER) == false
+		  && is_preferred_promotion_candidate(CANDIDATE_NODE_ID_HIGHER) == false,
+		  "other comparisons keep the candidate");
+}
+
+
+static void
+test_scripted_elections(void)
+{
+	int			visible = 0;
+
+	/* primary node 1 has failed; local node is node 2 */
+	t_scripted_node local_node = {2, STANDBY, 100, 0x3000060, PRIMARY_NODE_ID, -1, false};
+
+	{
+		/* local node is furthest ahead */
+		t_scripted_node siblings[] = {
+			{3, STANDBY, 100, 0x3000000, PRIMARY_NODE_ID, 10, true},
+			{4, STANDBY, 100, 0x3000028, PRIMARY_NODE_ID, 10, true},
+		};
+
+		check(run_election(&local_node, siblings, lengthof(siblings), 4000, &visible) == 2,
+			  "scripted: local node with highest LSN wins");
+		check(visible == 0,
+			  "scripted: no sibling still sees the primary");
+	}
+
+	{
+		/* a sibling is ahead, another has the same LSN as the local node */
+		t_scripted_node siblings[] = {
+			{3, STANDBY, 100, 0x3000060, PRIMARY_NODE_ID, 10, true},
+			{4, STANDBY, 100, 0x3000100, PRIMARY_NODE_ID, 10, true},
+		};
+
+		check(run_election(&local_node, siblings, lengthof(siblings), 4000, &visible) == 4,
+			  "scripted: sibling with highest LSN wins");
+	}
+
+	{
+		/* all at the same LSN; priority decides */
+		t_scripted_node siblings[] = {
+			{3, STANDBY, 150, 0x3000060, PRIMARY_NODE_ID, 10, true},
+			{4, STANDBY, 120, 0x3000060, PRIMARY_NODE_ID, 10, true},
+		};
+
+		check(run_election(&local_node, siblings, lengthof(siblings), 4000, &visible) == 3,
+			  "scripted: highest priority wins on equal LSN");
+	}
+
+	{
+		/* same LSN and priority; lowest node ID decides */
+		t_scripted_node local_node_5 = {5, STANDBY, 100, 0x3000060, PRIMARY_NODE_ID, -1, false};
+		t_scripted_node siblings[] = {
+			{6, STANDBY, 100, 0x3000060, PRIMARY_NODE_ID, 10, true},
+			{3, STANDBY, 100, 0x3000060, PRIMARY_NODE_ID, 10, true},
+			{4, STANDBY, 100, 0x3000060, PRIMARY_NODE_ID, 10, true},
+		};
+
+		check(run_election(&local_node_5, siblings, lengthof(siblings), 4000, &visible) == 3,
+			  "scripted: lowest node ID wins on equal LSN and priority");
+	}
+
+	{
+		/* witness and zero-priority nodes are never candidates */
+		t_scripted_node siblings[] = {
+			{3, WITNESS, 100, 0x9000000, PRIMARY_NODE_ID, 10, true},
+			{4, STANDBY, 0, 0x9000000, PRIMARY_NODE_ID, 10, true},
+		};
+
+		check(run_election(&local_node, siblings, lengthof(siblings), 4000, &visible) == 2,
+			  "scripted: witness and zero-priority nodes are skipped");
+	}
+
+	{
+		/* some siblings (including the witness) can still see the primary */
+		t_scripted_node siblings[] = {
+			{3, STANDBY, 100, 0x3000000, PRIMARY_NODE_ID, 1, true},
+			{4, STANDBY, 100, 0x3000000, 7, 0, true},
+			{5, WITNESS, 0, InvalidXLogRecPtr, PRIMARY_NODE_ID, 0, true},
+			{6, STANDBY, 100, 0x3000000, PRIMARY_NODE_ID, 5, true},
+		};
+
+		run_election(&local_node, siblings, lengthof(siblings), 4000, &visible);
+		check(visible == 2,
+			  "scripted: only nodes which recently saw the primary count as visible");
+	}
+
+	{
+		/* state could not be retrieved from a node which is further ahead */
+		t_scripted_node siblings[] = {
+			{3, STANDBY, 100, 0x9000000, PRIMARY_NODE_ID, 0, false},
+			{4, STANDBY, 100, 0x3000028, PRIMARY_NODE_ID, 10, true},
+		};
+
+		check(run_election(&local_node, siblings, lengthof(siblings), 4000, &visible) == 2,
+			  "scripted: nodes whose state could not be retrieved are skipped");
+		check(visible == 0,
+			  "scripted: nodes whose state could not be retrieved are not visible");
+	}
+}
+
+
+int
+main(int argc, char **argv)
+{
+	/* suppress the decisions logged by select_promotion_candidate() */
+	log_level = LOG_ERROR;
+
+	test_visibility_threshold();
+	test_primary_visibility();
+	test_majority();
+	test_candidate_comparison();
+	test_scripted_elections();
+
+	printf("1..%i\n", tests_run);
+
+	if (tests_failed > 0)
+	{
+		fprintf(stderr, "%i of %i tests failed\n", tests_failed, tests_run);
+		exit(EXIT_FAILURE);
+	}
+
+	exit(EXIT_SUCCESS);
+}
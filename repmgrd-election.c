@@ -0,0 +1,266 @@
+/*
+ * repmgrd-election.c - failover election decisions for repmgrd
+ *
+ * These functions make the decisions taken by do_election() from node
+ * state which has already been gathered; they do not access the database,
+ * the configuration or repmgrd's global state, so they can be exercised
+ * in isolation (see repmgrd-election-test.c).
+ *
+ * Copyright (c) 2ndQuadrant, 2010-2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "repmgr.h"
+#include "repmgrd-election.h"
+
+
+/*
+ * Return the length of time (in milliseconds) within which a node must have
+ * seen the primary for the primary to be considered visible from that node;
+ * if "primary_visibility_threshold" is not set, this is two monitoring
+ * intervals.
+ */
+int
+calculate_primary_visibility_threshold(int primary_visibility_threshold, int monitor_interval_secs)
+{
+	if (primary_visibility_threshold >= 0)
+		return primary_visibility_threshold;
+
+	return monitor_interval_secs * 2 * 1000;
+}
+
+
+/*
+ * Determine from a sibling node's report whether it can still see the
+ * primary. A negative "upstream_last_seen_ms" means the node has never
+ * seen its upstream.
+ */
+PrimaryVisibility
+classify_primary_visibility(int64 upstream_last_seen_ms, int upstream_node_id, int primary_node_id, int threshold_ms)
+{
+	if (upstream_last_seen_ms < 0 || upstream_last_seen_ms >= threshold_ms)
+		return PRIMARY_NOT_SEEN;
+
+	if (upstream_node_id != primary_node_id)
+		return PRIMARY_SEEN_OTHER_UPSTREAM;
+
+	return PRIMARY_SEEN;
+}
+
+
+/*
+ * Check whether the visible nodes (including the local node) form a strict
+ * majority of all nodes attached to the primary.
+ */
+bool
+visible_nodes_form_majority(int visible_nodes, int total_nodes)
+{
+	return visible_nodes > (total_nodes / 2.0);
+}
+
+
+/*
+ * Compare "node" with the current promotion candidate: the node with the
+ * highest last receive LSN is preferred, then the node with the highest
+ * priority, then the node with the lowest node ID.
+ */
+CandidateComparison
+compare_promotion_candidates(t_node_info *node, t_node_info *candidate)
+{
+	if (node->last_wal_receive_lsn > candidate->last_wal_receive_lsn)
+		return CANDIDATE_LSN_AHEAD;
+
+	if (node->last_wal_receive_lsn < candidate->last_wal_receive_lsn)
+		return CANDIDATE_LSN_BEHIND;
+
+	if (node->priority > candidate->priority)
+		return CANDIDATE_PRIORITY_HIGHER;
+
+	if (node->priority < candidate->priority)
+		return CANDIDATE_PRIORITY_LOWER;
+
+	if (node->node_id < candidate->node_id)
+		return CANDIDATE_NODE_ID_LOWER;
+
+	return CANDIDATE_NODE_ID_HIGHER;
+}
+
+
+bool
+is_preferred_promotion_candidate(CandidateComparison comparison)
+{
+	switch (comparison)
+	{
+		case CANDIDATE_LSN_AHEAD:
+		case CANDIDATE_PRIORITY_HIGHER:
+		case CANDIDATE_NODE_ID_LOWER:
+			return true;
+
+		case CANDIDATE_LSN_BEHIND:
+		case CANDIDATE_PRIORITY_LOWER:
+		case CANDIDATE_NODE_ID_HIGHER:
+			return false;
+	}
+
+	/* should never reach here */
+	return false;
+}
+
+
+/*
+ * Select the promotion candidate from the local node and those sibling
+ * nodes whose replication state do_election() was able to retrieve (i.e.
+ * which have "replication_info" set). Witness servers and nodes with a
+ * priority of zero or less are never candidates.
+ *
+ * Also counts the sibling nodes which have seen the primary within
+ * "threshold_ms", appending their details to "nodes_with_primary_visible".
+ */
+t_node_info *
+select_promotion_candidate(t_node_info *local_node, NodeInfoList *sibling_nodes, int primary_node_id, int threshold_ms, int *nodes_with_primary_still_visible, PQExpBufferData *nodes_with_primary_visible)
+{
+	NodeInfoListCell *cell = NULL;
+
+	/* pointer to "winning" node, initially self */
+	t_node_info *candidate_node = local_node;
+
+	*nodes_with_primary_still_visible = 0;
+
+	for (cell = sibling_nodes->head; cell; cell = cell->next)
+	{
+		ReplInfo   *replication_info = cell->node_info->replication_info;
+		CandidateComparison comparison;
+
+		if (replication_info == NULL)
+			continue;
+
+		/*
+		 * Check if node has seen primary "recently" - if so, we may have "partial primary visibility".
+		 * This is informational only; if "primary_visibility_consensus" is set, the failover
+		 * decision has already been made by check_primary_visibility_consensus().
+		 */
+		switch (classify_primary_visibility((int64) replication_info->upstream_last_seen * 1000,
+											replication_info->upstream_node_id,
+											primary_node_id,
+											threshold_ms))
+		{
+			case PRIMARY_SEEN_OTHER_UPSTREAM:
+				log_warning(_("assumed sibling node %i monitoring different upstream node %i"),
+							cell->node_info->node_id,
+							replication_info->upstream_node_id);
+				break;
+
+			case PRIMARY_SEEN:
+				(*nodes_with_primary_still_visible)++;
+				log_notice(_("node %i last saw primary node %i second(s) ago, considering primary still visible"),
+						   cell->node_info->node_id,
+						   replication_info->upstream_last_seen);
+				appendPQExpBuffer(nodes_with_primary_visible,
+								  " - node \"%s\" (ID: %i): %i second(s) ago\n",
+								  cell->node_info->node_name,
+								  cell->node_info->node_id,
+								  replication_info->upstream_last_seen);
+				break;
+
+			case PRIMARY_NOT_SEEN:
+				log_info(_("node %i last saw primary node %i second(s) ago"),
+						 cell->node_info->node_id,
+						 replication_info->upstream_last_seen);
+				break;
+		}
+
+		/* don't interrogate a witness server */
+		if (cell->node_info->type == WITNESS)
+		{
+			log_debug("node %i is witness, not querying state", cell->node_info->node_id);
+			continue;
+		}
+
+		/* don't check 0-priority nodes */
+		if (cell->node_info->priority <= 0)
+		{
+			log_info(_("node %i has priority of %i, skipping"),
+					   cell->node_info->node_id,
+					   cell->node_info->priority);
+			continue;
+		}
+
+		/* get node's last receive LSN - if "higher" than current winner, current node is candidate */
+		cell->node_info->last_wal_receive_lsn = replication_info->last_wal_receive_lsn;
+
+		log_info(_("last receive LSN for sibling node \"%s\" (ID: %i) is: %X/%X"),
+				 cell->node_info->node_name,
+				 cell->node_info->node_id,
+				 format_lsn(cell->node_info->last_wal_receive_lsn));
+
+		/* compare LSN, then tiebreak on priority, then node_id */
+		comparison = compare_promotion_candidates(cell->node_info, candidate_node);
+
+		switch (comparison)
+		{
+			case CANDIDATE_LSN_AHEAD:
+				log_info(_("node \"%s\" (ID: %i) is ahead of current candidate \"%s\" (ID: %i)"),
+						 cell->node_info->node_name,
+						 cell->node_info->node_id,
+						 candidate_node->node_name,
+						 candidate_node->node_id);
+				break;
+
+			case CANDIDATE_LSN_BEHIND:
+				break;
+
+			case CANDIDATE_PRIORITY_HIGHER:
+				log_info(_("node \"%s\" (ID: %i) has same LSN but higher priority (%i) than current candidate \"%s\" (ID: %i) (%i)"),
+						 cell->node_info->node_name,
+						 cell->node_info->node_id,
+						 cell->node_info->priority,
+						 candidate_node->node_name,
+						 candidate_node->node_id,
+						 candidate_node->priority);
+				break;
+
+			case CANDIDATE_PRIORITY_LOWER:
+				log_info(_("node \"%s\" (ID: %i) has same LSN but lower priority (%i) than current candidate \"%s\" (ID: %i) (%i)"),
+						 cell->node_info->node_name,
+						 cell->node_info->node_id,
+						 cell->node_info->priority,
+						 candidate_node->node_name,
+						 candidate_node->node_id,
+						 candidate_node->priority);
+				break;
+
+			case CANDIDATE_NODE_ID_LOWER:
+				log_info(_("node \"%s\" (ID: %i) has same LSN and priority but lower node_id than current candidate \"%s\" (ID: %i)"),
+						 cell->node_info->node_name,
+						 cell->node_info->node_id,
+						 candidate_node->node_name,
+						 candidate_node->node_id);
+				break;
+
+			case CANDIDATE_NODE_ID_HIGHER:
+				log_info(_("node \"%s\" (ID: %i) has same LSN and priority as current candidate \"%s\" (ID: %i)"),
+						 cell->node_info->node_name,
+						 cell->node_info->node_id,
+						 candidate_node->node_name,
+						 candidate_node->node_id);
+				break;
+		}
+
+		if (is_preferred_promotion_candidate(comparison) == true)
+			candidate_node = cell->node_info;
+	}
+
+	return candidate_node;
+}
@@ -0,0 +1,46 @@
+/*
+ * repmgrd-election.h
+ * Copyright (c) 2ndQuadrant, 2010-2019
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _REPMGRD_ELECTION_H_
+#define _REPMGRD_ELECTION_H_
+
+typedef enum
+{
+	PRIMARY_NOT_SEEN = 0,
+	PRIMARY_SEEN,
+	PRIMARY_SEEN_OTHER_UPSTREAM
+} PrimaryVisibility;
+
+typedef enum
+{
+	CANDIDATE_LSN_AHEAD = 0,
+	CANDIDATE_LSN_BEHIND,
+	CANDIDATE_PRIORITY_HIGHER,
+	CANDIDATE_PRIORITY_LOWER,
+	CANDIDATE_NODE_ID_LOWER,
+	CANDIDATE_NODE_ID_HIGHER
+} CandidateComparison;
+
+extern int	calculate_primary_visibility_threshold(int primary_visibility_threshold, int monitor_interval_secs);
+extern PrimaryVisibility classify_primary_visibility(int64 upstream_last_seen_ms, int upstream_node_id, int primary_node_id, int threshold_ms);
+extern bool visible_nodes_form_majority(int visible_nodes, int total_nodes);
+extern CandidateComparison compare_promotion_candidates(t_node_info *node, t_node_info *candidate);
+extern bool is_preferred_promotion_candidate(CandidateComparison comparison);
+extern t_node_info *select_promotion_candidate(t_node_info *local_node, NodeInfoList *sibling_nodes, int primary_node_id, int threshold_ms, int *nodes_with_primary_still_visible, PQExpBufferData *nodes_with_primary_visible);
+
+#endif							/* _REPMGRD_ELECTION_H_ */
@@ -22,6 +22,11 @@
 #include "repmgr.h"
 #include "repmgrd.h"
 #include "repmgrd-physical.h"
+#include "repmgrd-election.h"
+
+/* bounds for the interval between checks of sibling nodes' WAL receivers */
+#define SIBLING_DISCONNECT_CHECK_MIN_INTERVAL_MS 50
+#define SIBLING_DISCONNECT_CHECK_MAX_INTERVAL_MS 1000
 
 typedef enum
 {
@@ -53,6 +58,18 @@ typedef enum
 } ElectionResult;
 
 
+/*
+ * Event to be generated for a child node following the most recent
+ * execution of check_primary_child_nodes()
+ */
+typedef enum
+{
+	CHILD_NODE_EVENT_NONE = 0,
+	CHILD_NODE_EVENT_DISCONNECT,
+	CHILD_NODE_EVENT_RECONNECT,
+	CHILD_NODE_EVENT_NEW_CONNECT
+} ChildNodeEvent;
+
 typedef struct t_child_node_info
 {
 	int node_id;
@@ -60,22 +77,84 @@ typedef struct t_child_node_info
 	t_server_type type;
 	NodeAttached attached;
 	instr_time detached_time;
-	struct t_child_node_info *next;
+	instr_time reconnected_detached_time;
+	ChildNodeEvent pending_event;
+	bool seen;
 } t_child_node_info;
 
-typedef struct t_child_node_info_list
+/*
+ * The primary's child nodes, stored in a single allocation containing a
+ * dense array of node entries followed by an open-addressing hash index
+ * mapping node IDs to array positions, so a check of the child nodes'
+ * status is linear in the number of nodes and does not allocate memory
+ * unless new nodes have appeared.
+ */
+typedef struct t_child_node_table
 {
-	t_child_node_info *head;
-	t_child_node_info *tail;
+	t_child_node_info *nodes;
+	int		   *index;
+	int			index_size;
 	int			node_count;
-} t_child_node_info_list;
+	int			capacity;
+} t_child_node_table;
 
-#define T_CHILD_NODE_INFO_LIST_INITIALIZER { \
+#define T_CHILD_NODE_TABLE_INITIALIZER { \
 	NULL, \
 	NULL, \
+	0, \
+	0, \
 	0 \
 }
 
+#define CHILD_NODE_TABLE_MIN_CAPACITY 16
+
+
+/*
+ * State of a single follower notification sent by notify_followers();
+ * notifications are sent concurrently, up to
+ * "sibling_nodes_follow_concurrency" at a time.
+ */
+typedef enum
+{
+	NOTIFICATION_PENDING,
+	NOTIFICATION_CONNECTING,
+	NOTIFICATION_SENT,
+	NOTIFICATION_DONE
+} NotificationState;
+
+typedef struct
+{
+	t_node_info *node_info;
+	NotificationState state;
+	PostgresPollingStatusType poll_status;
+	instr_time	start_time;
+	bool		success;
+} t_follower_notification;
+
+
+/*
+ * State of a single primary visibility probe sent by
+ * check_primary_visibility_consensus(); all sibling nodes (including
+ * the witness) are probed concurrently with a single deadline.
+ */
+typedef enum
+{
+	VISIBILITY_PROBE_CONNECTING,
+	VISIBILITY_PROBE_SENT,
+	VISIBILITY_PROBE_DONE
+} VisibilityProbeState;
+
+typedef struct
+{
+	t_node_info *node_info;
+	PGconn	   *conn;
+	VisibilityProbeState state;
+	PostgresPollingStatusType poll_status;
+	int			upstream_node_id;
+	int64		upstream_last_seen_ms;
+	bool		success;
+} t_visibility_probe;
+
 static PGconn *upstream_conn = NULL;
 static PGconn *primary_conn = NULL;
 
@@ -86,6 +165,19 @@ static t_node_info upstream_node_info = T_NODE_INFO_INITIALIZER;
 
 static instr_time last_monitoring_update;
 
+/*
+ * Most recent heartbeat value replayed from the primary, and when (by the
+ * local clock) it was last seen to change; see "primary_heartbeat_interval_ms".
+ * The first value read only serves as a baseline. If the most recent attempt
+ * to read the heartbeat failed, it is not polled again until the next
+ * monitoring cycle.
+ */
+static int64 last_primary_heartbeat_us = 0;
+static bool primary_heartbeat_baseline_set = false;
+static instr_time last_primary_heartbeat_change;
+static bool primary_heartbeat_stale = false;
+static bool primary_heartbeat_read_failed = false;
+
 static bool child_nodes_disconnect_command_executed = false;
 
 static ElectionResult do_election(NodeInfoList *sibling_nodes, int *new_primary_id);
@@ -93,11 +185,16 @@ static const char *_print_election_result(ElectionResult result);
 
 static FailoverState promote_self(void);
 static void notify_followers(NodeInfoList *standby_nodes, int follow_node_id);
+static void start_follower_notification(t_follower_notification *notification, int follow_node_id);
+static void send_follower_notification(t_follower_notification *notification, int follow_node_id);
+
+static int	check_primary_visibility_consensus(NodeInfoList *sibling_nodes, PQExpBufferData *nodes_with_primary_visible);
+static int	get_primary_visibility_threshold(void);
 
 static void check_connection(t_node_info *node_info, PGconn **conn);
 
 static bool check_primary_status(int degraded_monitoring_elapsed);
-static void check_primary_child_nodes(t_child_node_info_list *local_child_nodes);
+static void check_primary_child_nodes(t_child_node_table *local_child_nodes, ChildNodeStatusList *db_child_nodes);
 
 static bool wait_primary_notification(int *new_primary_id);
 static FailoverState follow_new_primary(int new_primary_id);
@@ -111,19 +208,29 @@ static bool do_witness_failover(void);
 
 static void update_monitoring_history(void);
 
+static void primary_heartbeat_sleep(void);
+static bool primary_heartbeat_enabled(void);
+static void reset_primary_heartbeat(void);
+static void update_primary_heartbeat_status(void);
+static bool primary_heartbeat_is_fresh(void);
+static long primary_heartbeat_age_ms(void);
+static void standby_heartbeat_sleep(void);
+
 static void handle_sighup(PGconn **conn, t_server_type server_type);
 
 static const char *format_failover_state(FailoverState failover_state);
 static ElectionResult execute_failover_validation_command(t_node_info *node_info);
 static void parse_failover_validation_command(const char *template,  t_node_info *node_info, PQExpBufferData *out);
 static bool check_node_can_follow(PGconn *local_conn, XLogRecPtr local_xlogpos, PGconn *follow_target_conn, t_node_info *follow_target_node_info);
-static void check_witness_attached(t_node_info *node_info, bool startup);
+static void check_witness_attached(t_child_node_status *node, bool startup);
 
-static t_child_node_info *append_child_node_record(t_child_node_info_list *nodes, int node_id, const char *node_name, t_server_type type, NodeAttached attached);
-static void remove_child_node_record(t_child_node_info_list *nodes, int node_id);
-static void clear_child_node_info_list(t_child_node_info_list *nodes);
+static t_child_node_info *find_child_node_record(t_child_node_table *nodes, int node_id);
+static t_child_node_info *append_child_node_record(t_child_node_table *nodes, int node_id, const char *node_name, t_server_type type, NodeAttached attached);
+static void remove_unseen_child_node_records(t_child_node_table *nodes);
+static void rebuild_child_node_index(t_child_node_table *nodes);
+static void clear_child_node_table(t_child_node_table *nodes);
 static void parse_child_nodes_disconnect_command(char *parsed_command, char *template, int reporting_node_id);
-static void execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_child_node_info_list *local_child_nodes);
+static void execute_child_nodes_disconnect_command(t_child_node_table *local_child_nodes);
 
 void
 handle_sigint_physical(SIGNAL_ARGS)
@@ -260,7 +367,8 @@ monitor_streaming_primary(void)
 {
 	instr_time	log_status_interval_start;
 	instr_time	child_nodes_check_interval_start;
-	t_child_node_info_list local_child_nodes = T_CHILD_NODE_INFO_LIST_INITIALIZER;
+	t_child_node_table local_child_nodes = T_CHILD_NODE_TABLE_INITIALIZER;
+	ChildNodeStatusList db_child_nodes = T_CHILD_NODE_STATUS_LIST_INITIALIZER;
 
 	reset_node_voting_status();
 	repmgrd_set_upstream_node_id(local_conn, NO_UPSTREAM_NODE);
@@ -310,8 +418,7 @@ monitor_streaming_primary(void)
 	 */
 
 	{
-		NodeInfoList db_child_node_records = T_NODE_INFO_LIST_INITIALIZER;
-		bool success = get_child_nodes(local_conn, config_file_options.node_id, &db_child_node_records);
+		bool success = get_child_node_status(local_conn, config_file_options.node_id, &db_child_nodes);
 
 		if (!success)
 		{
@@ -319,10 +426,20 @@ monitor_streaming_primary(void)
 		}
 		else
 		{
-			NodeInfoListCell *cell;
+			int i;
 
-			for (cell = db_child_node_records.head; cell; cell = cell->next)
+			for (i = 0; i < db_child_nodes.node_count; i++)
 			{
+				t_child_node_status *db_child_node = &db_child_nodes.nodes[i];
+
+				/*
+				 * witness will not be "attached" in the normal way
+				 */
+				if (db_child_node->type == WITNESS)
+				{
+					check_witness_attached(db_child_node, true);
+				}
+
 				/*
 				 * At startup, if a node for which a repmgr record exists, is not found
 				 * in pg_stat_replication, we can't know whether it has become detached, or
@@ -331,30 +448,22 @@ monitor_streaming_primary(void)
 				 * emitting bogus "node has become detached" alerts.
 				 */
 				(void) append_child_node_record(&local_child_nodes,
-												cell->node_info->node_id,
-												cell->node_info->node_name,
-												cell->node_info->type,
-												cell->node_info->attached == NODE_ATTACHED ? NODE_ATTACHED : NODE_ATTACHED_UNKNOWN);
-
-				/*
-				 * witness will not be "attached" in the normal way
-				 */
-				if (cell->node_info->type == WITNESS)
-				{
-					check_witness_attached(cell->node_info, true);
-				}
+												db_child_node->node_id,
+												db_child_node->node_name,
+												db_child_node->type,
+												db_child_node->attached == NODE_ATTACHED ? NODE_ATTACHED : NODE_ATTACHED_UNKNOWN);
 
-				if (cell->node_info->attached == NODE_ATTACHED)
+				if (db_child_node->attached == NODE_ATTACHED)
 				{
 					log_info(_("child node \"%s\" (ID: %i) is attached"),
-							 cell->node_info->node_name,
-							 cell->node_info->node_id);
+							 db_child_node->node_name,
+							 db_child_node->node_id);
 				}
 				else
 				{
 					log_info(_("child node \"%s\" (ID: %i) is not yet attached"),
-								 cell->node_info->node_name,
-							 cell->node_info->node_id);
+							 db_child_node->node_name,
+							 db_child_node->node_id);
 				}
 			}
 		}
@@ -450,7 +559,11 @@ monitor_streaming_primary(void)
 					 * to standby monitoring
 					 */
 					if (check_primary_status(NO_DEGRADED_MONITORING_ELAPSED) == false)
+					{
+						clear_child_node_table(&local_child_nodes);
+						clear_child_node_status_list(&db_child_nodes);
 						return;
+					}
 
 					goto loop;
 				}
@@ -507,7 +620,11 @@ monitor_streaming_primary(void)
 					local_node_info.node_status = NODE_STATUS_UP;
 
 					if (check_primary_status(degraded_monitoring_elapsed) == false)
+					{
+						clear_child_node_table(&local_child_nodes);
+						clear_child_node_status_list(&db_child_nodes);
 						return;
+					}
 
 					goto loop;
 				}
@@ -529,7 +646,7 @@ monitor_streaming_primary(void)
 				if (child_nodes_check_interval_elapsed >= config_file_options.child_nodes_check_interval)
 				{
 					INSTR_TIME_SET_CURRENT(child_nodes_check_interval_start);
-					check_primary_child_nodes(&local_child_nodes);
+					check_primary_child_nodes(&local_child_nodes, &db_child_nodes);
 				}
 			}
 		}
@@ -538,7 +655,11 @@ loop:
 
 		/* check node is still primary, if not restart monitoring */
 		if (check_primary_status(NO_DEGRADED_MONITORING_ELAPSED) == false)
+		{
+			clear_child_node_table(&local_child_nodes);
+			clear_child_node_status_list(&db_child_nodes);
 			return;
+		}
 
 		/* emit "still alive" log message at regular intervals, if requested */
 		if (config_file_options.log_status_interval > 0)
@@ -566,10 +687,13 @@ loop:
 			handle_sighup(&local_conn, PRIMARY);
 		}
 
+		/* close pooled connections which have been idle for too long */
+		expire_pooled_connections();
+
 		log_verbose(LOG_DEBUG, "sleeping %i seconds (parameter \"monitor_interval_secs\")",
 					config_file_options.monitor_interval_secs);
 
-		sleep(config_file_options.monitor_interval_secs);
+		primary_heartbeat_sleep();
 	}
 }
 
@@ -782,16 +906,12 @@ check_primary_status(int degraded_monitoring_elapsed)
 
 
 static void
-check_primary_child_nodes(t_child_node_info_list *local_child_nodes)
+check_primary_child_nodes(t_child_node_table *local_child_nodes, ChildNodeStatusList *db_child_nodes)
 {
-	NodeInfoList db_child_node_records = T_NODE_INFO_LIST_INITIALIZER;
-	NodeInfoListCell *cell;
-	/* lists for newly attached and missing nodes */
-	t_child_node_info_list disconnected_child_nodes = T_CHILD_NODE_INFO_LIST_INITIALIZER;
-	t_child_node_info_list reconnected_child_nodes = T_CHILD_NODE_INFO_LIST_INITIALIZER;
-	t_child_node_info_list new_child_nodes = T_CHILD_NODE_INFO_LIST_INITIALIZER;
+	t_child_node_info *local_child_node_rec;
+	int i;
 
-	bool success = get_child_nodes(local_conn, config_file_options.node_id, &db_child_node_records);
+	bool success = get_child_node_status(local_conn, config_file_options.node_id, db_child_nodes);
 
 	if (!success)
 	{
@@ -800,96 +920,78 @@ check_primary_child_nodes(t_child_node_info_list *local_child_nodes)
 		return;
 	}
 
-	if (db_child_node_records.node_count == 0)
+	if (db_child_nodes->node_count == 0)
 	{
 		/* no registered child nodes - nothing to do */
 		return;
 	}
 
+	for (i = 0; i < local_child_nodes->node_count; i++)
+	{
+		local_child_nodes->nodes[i].seen = false;
+		local_child_nodes->nodes[i].pending_event = CHILD_NODE_EVENT_NONE;
+	}
+
 	/*
-	 * compare DB records with our internal list;
+	 * compare DB records with our internal table;
 	 * this will tell us about:
 	 *  - previously known nodes and their current status
 	 *  - newly registered nodes we didn't know about
 	 *
-	 * We'll need to compare the opposite way to check for nodes
-	 * which are in the internal list, but which have now vanished
+	 * Any nodes in the internal table not seen here have vanished.
 	 */
-	for (cell = db_child_node_records.head; cell; cell = cell->next)
+	for (i = 0; i < db_child_nodes->node_count; i++)
 	{
-		t_child_node_info *local_child_node_rec;
-		bool local_child_node_rec_found = false;
-
+		t_child_node_status *db_child_node = &db_child_nodes->nodes[i];
 
 		/*
 		 * witness will not be "attached" in the normal way
 		 */
-		if (cell->node_info->type == WITNESS)
+		if (db_child_node->type == WITNESS)
 		{
-			check_witness_attached(cell->node_info, false);
+			check_witness_attached(db_child_node, false);
 		}
 
 		log_debug("child node: %i; attached: %s",
-				  cell->node_info->node_id,
-				  cell->node_info->attached == NODE_ATTACHED ? "yes" : "no");
+				  db_child_node->node_id,
+				  db_child_node->attached == NODE_ATTACHED ? "yes" : "no");
 
-		for (local_child_node_rec = local_child_nodes->head; local_child_node_rec; local_child_node_rec = local_child_node_rec->next)
-		{
-			if (local_child_node_rec->node_id == cell->node_info->node_id)
-			{
-				local_child_node_rec_found = true;
-				break;
-			}
-		}
+		local_child_node_rec = find_child_node_record(local_child_nodes, db_child_node->node_id);
 
-		if (local_child_node_rec_found == true)
+		if (local_child_node_rec != NULL)
 		{
+			local_child_node_rec->seen = true;
+
 			/* our node record shows node attached, DB record indicates detached */
-			if (local_child_node_rec->attached == NODE_ATTACHED && cell->node_info->attached == NODE_DETACHED)
+			if (local_child_node_rec->attached == NODE_ATTACHED && db_child_node->attached == NODE_DETACHED)
 			{
-				t_child_node_info *detached_child_node;
-
 				local_child_node_rec->attached = NODE_DETACHED;
 				INSTR_TIME_SET_CURRENT(local_child_node_rec->detached_time);
 
-				detached_child_node = append_child_node_record(&disconnected_child_nodes,
-															   local_child_node_rec->node_id,
-															   local_child_node_rec->node_name,
-															   local_child_node_rec->type,
-															   NODE_DETACHED);
-				detached_child_node->detached_time = local_child_node_rec->detached_time;
+				local_child_node_rec->pending_event = CHILD_NODE_EVENT_DISCONNECT;
 			}
 			/* our node record shows node detached, DB record indicates attached */
-			else if (local_child_node_rec->attached == NODE_DETACHED && cell->node_info->attached == NODE_ATTACHED)
+			else if (local_child_node_rec->attached == NODE_DETACHED && db_child_node->attached == NODE_ATTACHED)
 			{
-				t_child_node_info *attached_child_node;
-
 				local_child_node_rec->attached = NODE_ATTACHED;
 
-				attached_child_node = append_child_node_record(&reconnected_child_nodes,
-															   local_child_node_rec->node_id,
-															   local_child_node_rec->node_name,
-															   local_child_node_rec->type,
-															   NODE_ATTACHED);
-				attached_child_node->detached_time = local_child_node_rec->detached_time;
+				local_child_node_rec->reconnected_detached_time = local_child_node_rec->detached_time;
 				INSTR_TIME_SET_ZERO(local_child_node_rec->detached_time);
+
+				local_child_node_rec->pending_event = CHILD_NODE_EVENT_RECONNECT;
 			}
-			else if (local_child_node_rec->attached == NODE_ATTACHED_UNKNOWN  && cell->node_info->attached == NODE_ATTACHED)
+			else if (local_child_node_rec->attached == NODE_ATTACHED_UNKNOWN  && db_child_node->attached == NODE_ATTACHED)
 			{
 				local_child_node_rec->attached = NODE_ATTACHED;
 
-				append_child_node_record(&new_child_nodes,
-										 local_child_node_rec->node_id,
-										 local_child_node_rec->node_name,
-										 local_child_node_rec->type,
-										 NODE_ATTACHED);
+				local_child_node_rec->pending_event = CHILD_NODE_EVENT_NEW_CONNECT;
 			}
 		}
 		else
 		{
 			/* node we didn't know about before */
 
-			NodeAttached attached = cell->node_info->attached;
+			NodeAttached attached = db_child_node->attached;
 
 			/*
 			 * node registered but not attached - set state to "UNKNOWN"
@@ -898,126 +1000,105 @@ check_primary_child_nodes(t_child_node_info_list *local_child_nodes)
 			if (attached == NODE_DETACHED)
 				attached = NODE_ATTACHED_UNKNOWN;
 
-			(void) append_child_node_record(local_child_nodes,
-											cell->node_info->node_id,
-											cell->node_info->node_name,
-											cell->node_info->type,
-											attached);
-			(void) append_child_node_record(&new_child_nodes,
-											cell->node_info->node_id,
-											cell->node_info->node_name,
-											cell->node_info->type,
-											attached);
+			local_child_node_rec = append_child_node_record(local_child_nodes,
+															db_child_node->node_id,
+															db_child_node->node_name,
+															db_child_node->type,
+															attached);
+			local_child_node_rec->seen = true;
+			local_child_node_rec->pending_event = CHILD_NODE_EVENT_NEW_CONNECT;
 		}
 	}
 
 	/*
-	 * Check if any nodes in local list are no longer in list returned
-	 * from database.
+	 * Remove any nodes in the internal table which are no longer in the list
+	 * returned from the database.
 	 */
+	remove_unseen_child_node_records(local_child_nodes);
+
+	/* generate "child_node_disconnect" events */
+	for (i = 0; i < local_child_nodes->node_count; i++)
 	{
-		t_child_node_info *local_child_node_rec;
-		bool db_node_rec_found = false;
+		PQExpBufferData event_details;
 
-		for (local_child_node_rec = local_child_nodes->head; local_child_node_rec; local_child_node_rec = local_child_node_rec->next)
-		{
-			for (cell = db_child_node_records.head; cell; cell = cell->next)
-			{
-				if (cell->node_info->node_id == local_child_node_rec->node_id)
-				{
-					db_node_rec_found = true;
-					break;
-				}
-			}
+		local_child_node_rec = &local_child_nodes->nodes[i];
 
-			if (db_node_rec_found == false)
-			{
-				log_notice(_("%s node \"%s\" (ID: %i) is no longer connected or registered"),
-						   get_node_type_string(local_child_node_rec->type),
-						   local_child_node_rec->node_name,
-						   local_child_node_rec->node_id);
-				remove_child_node_record(local_child_nodes, local_child_node_rec->node_id);
-			}
-		}
-	}
+		if (local_child_node_rec->pending_event != CHILD_NODE_EVENT_DISCONNECT)
+			continue;
 
-	/* generate "child_node_disconnect" events */
-	if (disconnected_child_nodes.node_count > 0)
-	{
-		t_child_node_info *child_node_rec;
-		for (child_node_rec = disconnected_child_nodes.head; child_node_rec; child_node_rec = child_node_rec->next)
-		{
-			PQExpBufferData event_details;
-			initPQExpBuffer(&event_details);
-			appendPQExpBuffer(&event_details,
-							  _("%s node \"%s\" (ID: %i) has disconnected"),
-							  get_node_type_string(child_node_rec->type),
-							  child_node_rec->node_name,
-							  child_node_rec->node_id);
-			log_notice("%s",  event_details.data);
+		initPQExpBuffer(&event_details);
+		appendPQExpBuffer(&event_details,
+						  _("%s node \"%s\" (ID: %i) has disconnected"),
+						  get_node_type_string(local_child_node_rec->type),
+						  local_child_node_rec->node_name,
+						  local_child_node_rec->node_id);
+		log_notice("%s",  event_details.data);
 
-			create_event_notification(local_conn,
-									  &config_file_options,
-									  local_node_info.node_id,
-									  "child_node_disconnect",
-									  true,
-									  event_details.data);
+		create_event_notification(local_conn,
+								  &config_file_options,
+								  local_node_info.node_id,
+								  "child_node_disconnect",
+								  true,
+								  event_details.data);
 
-			termPQExpBuffer(&event_details);
-		}
+		termPQExpBuffer(&event_details);
 	}
 
 	/* generate "child_node_reconnect" events */
-	if (reconnected_child_nodes.node_count > 0)
+	for (i = 0; i < local_child_nodes->node_count; i++)
 	{
-		t_child_node_info *child_node_rec;
-		for (child_node_rec = reconnected_child_nodes.head; child_node_rec; child_node_rec = child_node_rec->next)
-		{
-			PQExpBufferData event_details;
-			initPQExpBuffer(&event_details);
-			appendPQExpBuffer(&event_details,
-							  _("%s node \"%s\" (ID: %i) has reconnected after %i seconds"),
-							  get_node_type_string(child_node_rec->type),
-							  child_node_rec->node_name,
-							  child_node_rec->node_id,
-							  calculate_elapsed( child_node_rec->detached_time ));
-			log_notice("%s",  event_details.data);
+		PQExpBufferData event_details;
 
-			create_event_notification(local_conn,
-									  &config_file_options,
-									  local_node_info.node_id,
-									  "child_node_reconnect",
-									  true,
-									  event_details.data);
+		local_child_node_rec = &local_child_nodes->nodes[i];
 
-			termPQExpBuffer(&event_details);
-		}
+		if (local_child_node_rec->pending_event != CHILD_NODE_EVENT_RECONNECT)
+			continue;
+
+		initPQExpBuffer(&event_details);
+		appendPQExpBuffer(&event_details,
+						  _("%s node \"%s\" (ID: %i) has reconnected after %i seconds"),
+						  get_node_type_string(local_child_node_rec->type),
+						  local_child_node_rec->node_name,
+						  local_child_node_rec->node_id,
+						  calculate_elapsed( local_child_node_rec->reconnected_detached_time ));
+		log_notice("%s",  event_details.data);
+
+		create_event_notification(local_conn,
+								  &config_file_options,
+								  local_node_info.node_id,
+								  "child_node_reconnect",
+								  true,
+								  event_details.data);
+
+		termPQExpBuffer(&event_details);
 	}
 
 	/* generate "child_node_new_connect" events */
-	if (new_child_nodes.node_count > 0)
+	for (i = 0; i < local_child_nodes->node_count; i++)
 	{
-		t_child_node_info *child_node_rec;
-		for (child_node_rec = new_child_nodes.head; child_node_rec; child_node_rec = child_node_rec->next)
-		{
-			PQExpBufferData event_details;
-			initPQExpBuffer(&event_details);
-			appendPQExpBuffer(&event_details,
-							  _("new %s \"%s\" (ID: %i) has connected"),
-							  get_node_type_string(child_node_rec->type),
-							  child_node_rec->node_name,
-							  child_node_rec->node_id);
-			log_notice("%s",  event_details.data);
+		PQExpBufferData event_details;
 
-			create_event_notification(local_conn,
-									  &config_file_options,
-									  local_node_info.node_id,
-									  "child_node_new_connect",
-									  true,
-									  event_details.data);
+		local_child_node_rec = &local_child_nodes->nodes[i];
 
-			termPQExpBuffer(&event_details);
-		}
+		if (local_child_node_rec->pending_event != CHILD_NODE_EVENT_NEW_CONNECT)
+			continue;
+
+		initPQExpBuffer(&event_details);
+		appendPQExpBuffer(&event_details,
+						  _("new %s \"%s\" (ID: %i) has connected"),
+						  get_node_type_string(local_child_node_rec->type),
+						  local_child_node_rec->node_name,
+						  local_child_node_rec->node_id);
+		log_notice("%s",  event_details.data);
+
+		create_event_notification(local_conn,
+								  &config_file_options,
+								  local_node_info.node_id,
+								  "child_node_new_connect",
+								  true,
+								  event_details.data);
+
+		termPQExpBuffer(&event_details);
 	}
 
 
@@ -1028,20 +1109,14 @@ check_primary_child_nodes(t_child_node_info_list *local_child_nodes)
 		if (repmgrd_paused == false)
 		{
 			/* check criteria for execution, and execute if criteria met */
-			execute_child_nodes_disconnect_command(&db_child_node_records, local_child_nodes);
+			execute_child_nodes_disconnect_command(local_child_nodes);
 		}
 	}
-
-	clear_child_node_info_list(&disconnected_child_nodes);
-	clear_child_node_info_list(&reconnected_child_nodes);
-	clear_child_node_info_list(&new_child_nodes);
-
-	clear_node_info_list(&db_child_node_records);
 }
 
 
 void
-execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_child_node_info_list *local_child_nodes)
+execute_child_nodes_disconnect_command(t_child_node_table *local_child_nodes)
 {
 	/*
 	 * script will only be executed if the number of attached
@@ -1049,7 +1124,7 @@ execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_ch
 	 */
 	int min_required_connected_count = 1;
 	int connected_count = 0;
-	NodeInfoListCell *cell;
+	int i;
 
 	/*
 	 * Calculate minimum number of nodes which need to be connected
@@ -1063,14 +1138,14 @@ execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_ch
 	}
 	else if (config_file_options.child_nodes_disconnect_min_count > 0)
 	{
-		int child_node_count = db_child_node_records->node_count;
+		int child_node_count = local_child_nodes->node_count;
 
 		if (config_file_options.child_nodes_connected_include_witness == false)
 		{
 			/* reduce total, if witness server in child node list */
-			for (cell = db_child_node_records->head; cell; cell = cell->next)
+			for (i = 0; i < local_child_nodes->node_count; i++)
 			{
-				if (cell->node_info->type == WITNESS)
+				if (local_child_nodes->nodes[i].type == WITNESS)
 				{
 					child_node_count--;
 					break;
@@ -1084,14 +1159,14 @@ execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_ch
 	}
 
 	/* calculate number of connected child nodes */
-	for (cell = db_child_node_records->head; cell; cell = cell->next)
+	for (i = 0; i < local_child_nodes->node_count; i++)
 	{
 		/* exclude witness server from total, if necessay */
 		if (config_file_options.child_nodes_connected_include_witness == false &&
-			cell->node_info->type == WITNESS)
+			local_child_nodes->nodes[i].type == WITNESS)
 			continue;
 
-		if (cell->node_info->attached == NODE_ATTACHED)
+		if (local_child_nodes->nodes[i].attached == NODE_ATTACHED)
 			connected_count ++;
 	}
 
@@ -1103,7 +1178,7 @@ execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_ch
 	{
 		log_notice(_("%i (of %i) child nodes are connected, but at least %i child nodes required"),
 				   connected_count,
-				   db_child_node_records->node_count,
+				   local_child_nodes->node_count,
 				   min_required_connected_count);
 
 		if (child_nodes_disconnect_command_executed == false)
@@ -1119,11 +1194,13 @@ execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_ch
 
 			INSTR_TIME_SET_CURRENT(current_time_base);
 
-			for (child_node_rec = local_child_nodes->head; child_node_rec; child_node_rec = child_node_rec->next)
+			for (i = 0; i < local_child_nodes->node_count; i++)
 			{
 				instr_time  current_time = current_time_base;
 				int seconds_since_detached;
 
+				child_node_rec = &local_child_nodes->nodes[i];
+
 				/* exclude witness server from calculatin if neccessary */
 				if (config_file_options.child_nodes_connected_include_witness == false &&
 					child_node_rec->type == WITNESS)
@@ -1232,7 +1309,7 @@ execute_child_nodes_disconnect_command(NodeInfoList *db_child_node_records, t_ch
 		{
 			log_notice(_("%i (of %i) child nodes are now connected, meeting minimum requirement of %i child nodes"),
 					   connected_count,
-					   db_child_node_records->node_count,
+					   local_child_nodes->node_count,
 					   min_required_connected_count);
 			child_nodes_disconnect_command_executed = false;
 		}
@@ -1260,6 +1337,11 @@ monitor_streaming_standby(void)
 
 	INSTR_TIME_SET_ZERO(last_monitoring_update);
 
+	reset_primary_heartbeat();
+
+	/* monitoring (re)starts, possibly with a new upstream */
+	reset_timeline_history_cache();
+
 	/*
 	 * If no upstream node id is specified in the metadata, we'll try and
 	 * determine the current cluster primary in the assumption we should
@@ -1438,10 +1520,28 @@ monitor_streaming_standby(void)
 	while (true)
 	{
 		log_verbose(LOG_DEBUG, "checking %s", upstream_node_info.conninfo);
+
+		update_primary_heartbeat_status();
+
 		if (check_upstream_connection(&upstream_conn, upstream_node_info.conninfo) == true)
 		{
 			set_upstream_last_seen(local_conn, upstream_node_info.node_id);
 		}
+		else if (primary_heartbeat_is_fresh() == true)
+		{
+			/*
+			 * The primary is still writing heartbeats which reach this node
+			 * via replication, so the problem is with this node's connection
+			 * to it rather than the primary itself.
+			 */
+			log_warning(_("unable to connect to upstream node \"%s\" (ID: %i), but its heartbeat is still being replayed"),
+						upstream_node_info.node_name,
+						upstream_node_info.node_id);
+			log_detail(_("heartbeat last advanced %li ms ago"),
+					   primary_heartbeat_age_ms());
+
+			set_upstream_last_seen(local_conn, upstream_node_info.node_id);
+		}
 		else
 		{
 			/* upstream node is down, we were expecting it to be up */
@@ -1757,6 +1857,7 @@ monitor_streaming_standby(void)
 														&sibling_nodes);
 						notify_followers(&sibling_nodes, local_node_info.node_id);
 
+						release_node_list_connections(&sibling_nodes);
 						clear_node_info_list(&sibling_nodes);
 
 						/* this will restart monitoring in primary mode */
@@ -1818,7 +1919,7 @@ monitor_streaming_standby(void)
 								continue;
 							}
 
-							cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
+							cell->node_info->conn = get_pooled_connection(cell->node_info, false);
 
 							if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 							{
@@ -1829,10 +1930,10 @@ monitor_streaming_standby(void)
 							if (get_recovery_type(cell->node_info->conn) == RECTYPE_PRIMARY)
 							{
 								follow_node_id = cell->node_info->node_id;
-								close_connection(&cell->node_info->conn);
+								release_pooled_connection(cell->node_info, &cell->node_info->conn);
 								break;
 							}
-							close_connection(&cell->node_info->conn);
+							release_pooled_connection(cell->node_info, &cell->node_info->conn);
 						}
 
 						if (follow_node_id != UNKNOWN_NODE_ID)
@@ -1841,6 +1942,7 @@ monitor_streaming_standby(void)
 						}
 					}
 
+					release_node_list_connections(&sibling_nodes);
 					clear_node_info_list(&sibling_nodes);
 				}
 			}
@@ -2089,6 +2191,9 @@ loop:
 			handle_sighup(&local_conn, STANDBY);
 		}
 
+		/* close pooled connections which have been idle for too long */
+		expire_pooled_connections();
+
 		refresh_node_record(local_conn, local_node_info.node_id, &local_node_info);
 
 		if (local_monitoring_state == MS_NORMAL && last_known_upstream_node_id != local_node_info.upstream_node_id)
@@ -2106,7 +2211,7 @@ loop:
 					config_file_options.monitor_interval_secs);
 
 
-		sleep(config_file_options.monitor_interval_secs);
+		standby_heartbeat_sleep();
 	}
 }
 
@@ -2406,7 +2511,7 @@ monitor_streaming_witness(void)
 							continue;
 						}
 
-						cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
+						cell->node_info->conn = get_pooled_connection(cell->node_info, false);
 
 						if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 						{
@@ -2417,10 +2522,10 @@ monitor_streaming_witness(void)
 						if (get_recovery_type(cell->node_info->conn) == RECTYPE_PRIMARY)
 						{
 							follow_node_id = cell->node_info->node_id;
-							close_connection(&cell->node_info->conn);
+							release_pooled_connection(cell->node_info, &cell->node_info->conn);
 							break;
 						}
-						close_connection(&cell->node_info->conn);
+						release_pooled_connection(cell->node_info, &cell->node_info->conn);
 					}
 
 					if (follow_node_id != UNKNOWN_NODE_ID)
@@ -2428,6 +2533,7 @@ monitor_streaming_witness(void)
 						witness_follow_new_primary(follow_node_id);
 					}
 				}
+				release_node_list_connections(&sibling_nodes);
 				clear_node_info_list(&sibling_nodes);
 			}
 		}
@@ -2597,6 +2703,9 @@ loop:
 			handle_sighup(&local_conn, WITNESS);
 		}
 
+		/* close pooled connections which have been idle for too long */
+		expire_pooled_connections();
+
 		log_verbose(LOG_DEBUG, "sleeping %i seconds (parameter \"monitor_interval_secs\")",
 					config_file_options.monitor_interval_secs);
 
@@ -2629,7 +2738,8 @@ do_primary_failover(void)
 	{
 		NodeInfoListCell *cell = NULL;
 		NodeInfoList check_sibling_nodes = T_NODE_INFO_LIST_INITIALIZER;
-		int i;
+		instr_time	disconnect_start_time;
+		long		interval_ms = SIBLING_DISCONNECT_CHECK_MIN_INTERVAL_MS;
 
 		bool sibling_node_wal_receiver_connected = false;
 
@@ -2641,7 +2751,7 @@ do_primary_failover(void)
 		}
 		else
 		{
-			disable_wal_receiver(local_conn);
+			disable_wal_receiver(local_conn, config_file_options.standby_disconnect_timeout);
 
 			/*
 			 * Loop through all reachable sibling nodes to determine whether
@@ -2656,14 +2766,20 @@ do_primary_failover(void)
 											local_node_info.upstream_node_id,
 											&check_sibling_nodes);
 
-			for (i = 0; i < config_file_options.sibling_nodes_disconnect_timeout; i++)
+			INSTR_TIME_SET_CURRENT(disconnect_start_time);
+
+			for (;;)
 			{
+				instr_time	elapsed;
+
+				sibling_node_wal_receiver_connected = false;
+
 				for (cell = check_sibling_nodes.head; cell; cell = cell->next)
 				{
 					pid_t sibling_wal_receiver_pid;
 
 					if (cell->node_info->conn == NULL)
-						cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
+						cell->node_info->conn = get_pooled_connection(cell->node_info, false);
 
 					sibling_wal_receiver_pid = (pid_t)get_wal_receiver_pid(cell->node_info->conn);
 
@@ -2687,9 +2803,22 @@ do_primary_failover(void)
 					break;
 				}
 
-				log_debug("sleeping %i of max %i seconds (\"sibling_nodes_disconnect_timeout\")",
-						  i + 1, config_file_options.sibling_nodes_disconnect_timeout);
-				sleep(1);
+				INSTR_TIME_SET_CURRENT(elapsed);
+				INSTR_TIME_SUBTRACT(elapsed, disconnect_start_time);
+
+				if (INSTR_TIME_GET_DOUBLE(elapsed) >= config_file_options.sibling_nodes_disconnect_timeout)
+					break;
+
+				log_debug("sleeping %li ms; %.2f of max %i seconds elapsed (\"sibling_nodes_disconnect_timeout\")",
+						  interval_ms,
+						  INSTR_TIME_GET_DOUBLE(elapsed),
+						  config_file_options.sibling_nodes_disconnect_timeout);
+
+				pg_usleep(interval_ms * 1000L);
+
+				interval_ms *= 2;
+				if (interval_ms > SIBLING_DISCONNECT_CHECK_MAX_INTERVAL_MS)
+					interval_ms = SIBLING_DISCONNECT_CHECK_MAX_INTERVAL_MS;
 			}
 
 			if (sibling_node_wal_receiver_connected == true)
@@ -2703,6 +2832,7 @@ do_primary_failover(void)
 						 check_sibling_nodes.node_count);
 			}
 
+			release_node_list_connections(&check_sibling_nodes);
 			clear_node_info_list(&check_sibling_nodes);
 		}
 	}
@@ -2719,7 +2849,7 @@ do_primary_failover(void)
 	if (config_file_options.standby_disconnect_on_failover == true)
 	{
 		/* adjust "wal_retrieve_retry_interval" but don't wait for WAL receiver to start */
-		enable_wal_receiver(local_conn, false);
+		enable_wal_receiver(local_conn, false, config_file_options.standby_disconnect_timeout);
 	}
 
 	/* election was cancelled and do_election() did not determine a new primary */
@@ -2728,6 +2858,7 @@ do_primary_failover(void)
 		if (new_primary_id == UNKNOWN_NODE_ID)
 		{
 			log_notice(_("election cancelled"));
+			release_node_list_connections(&sibling_nodes);
 			clear_node_info_list(&sibling_nodes);
 			return false;
 		}
@@ -2891,6 +3022,7 @@ do_primary_failover(void)
 		case FAILOVER_STATE_ELECTION_RERUN:
 
 			/* we no longer care about our former siblings */
+			release_node_list_connections(&sibling_nodes);
 			clear_node_info_list(&sibling_nodes);
 
 			log_notice(_("rerunning election after %i seconds (\"election_rerun_interval\")"),
@@ -2993,6 +3125,7 @@ do_primary_failover(void)
 	}
 
 	/* we no longer care about our former siblings */
+	release_node_list_connections(&sibling_nodes);
 	clear_node_info_list(&sibling_nodes);
 
 	return final_result;
@@ -3095,97 +3228,333 @@ update_monitoring_history(void)
 
 
 /*
- * do_upstream_standby_failover()
- *
- * Attach cascaded standby to another node, currently the primary.
+ * primary_heartbeat_sleep()
  *
- * Note that in contrast to a primary failover, where one of the downstrean
- * standby nodes will become a primary, a cascaded standby failover (where the
- * upstream standby has gone away) is "just" a case of attaching the standby to
- * another node.
- *
- * Currently we will try to attach the node to the cluster primary.
- *
- * TODO: As of repmgr 4.3, "repmgr standby follow" supports attaching a standby to another
- * standby node. We need to provide a selection of reconnection strategies as different
- * behaviour might be desirable in different situations.
+ * Wait "monitor_interval_secs" between monitoring cycles on the primary; if
+ * "primary_heartbeat_interval_ms" is set, write a heartbeat at that interval
+ * while waiting.
  */
-
-static bool
-do_upstream_standby_failover(void)
+static void
+primary_heartbeat_sleep(void)
 {
-	t_node_info primary_node_info = T_NODE_INFO_INITIALIZER;
-	RecordStatus record_status = RECORD_NOT_FOUND;
-	RecoveryType primary_type = RECTYPE_UNKNOWN;
-	int			i, standby_follow_result;
-	char		parsed_follow_command[MAXPGPATH] = "";
-
-	close_connection(&upstream_conn);
-
-	/*
-	 *
-	 */
-	if (config_file_options.failover == FAILOVER_MANUAL)
-	{
-		log_notice(_("this node is not configured for automatic failover"));
-		return false;
-	}
+	instr_time	sleep_start;
+	instr_time	elapsed;
+	long		interval_ms = config_file_options.primary_heartbeat_interval_ms;
 
-	if (get_primary_node_record(local_conn, &primary_node_info) == false)
+	if (interval_ms <= 0 || PQstatus(local_conn) != CONNECTION_OK)
 	{
-		log_error(_("unable to retrieve primary node record"));
-		return false;
+		sleep(config_file_options.monitor_interval_secs);
+		return;
 	}
 
-	/*
-	 * Verify that we can still talk to the cluster primary, even though the
-	 * node's upstream is not available
-	 */
-
-	check_connection(&primary_node_info, &primary_conn);
+	INSTR_TIME_SET_CURRENT(sleep_start);
 
-	if (PQstatus(primary_conn) != CONNECTION_OK)
+	while (true)
 	{
-		log_error(_("unable to connect to last known primary \"%s\" (ID: %i)"),
-				  primary_node_info.node_name,
-				  primary_node_info.node_id);
+		long		remaining_ms;
 
-		close_connection(&primary_conn);
-		monitoring_state = MS_DEGRADED;
-		INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
-		return false;
-	}
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, sleep_start);
 
-	primary_type = get_recovery_type(primary_conn);
+		remaining_ms = (long) config_file_options.monitor_interval_secs * 1000
+			- (long) INSTR_TIME_GET_MILLISEC(elapsed);
 
-	if (primary_type != RECTYPE_PRIMARY)
-	{
-		if (primary_type == RECTYPE_STANDBY)
-		{
-			log_error(_("last known primary \"%s\" (ID: %i) is in recovery, not following"),
-					  primary_node_info.node_name,
-					  primary_node_info.node_id);
-		}
-		else
+		if (remaining_ms <= 0 || got_SIGHUP)
+			break;
+
+		/*
+		 * If the heartbeat can't be written (the error will have been logged),
+		 * don't retry until the next monitoring cycle, which will establish
+		 * whether anything is amiss with the local node.
+		 */
+		if (update_primary_heartbeat(local_conn, local_node_info.node_id) == false)
 		{
-			log_error(_("unable to determine status of last known primary \"%s\" (ID: %i), not following"),
-					  primary_node_info.node_name,
-					  primary_node_info.node_id);
+			pg_usleep(remaining_ms * 1000L);
+			break;
 		}
 
-		close_connection(&primary_conn);
-		monitoring_state = MS_DEGRADED;
-		INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
-		return false;
+		pg_usleep(Min(interval_ms, remaining_ms) * 1000L);
 	}
+}
 
-	/* Close the connection to this server */
-	close_connection(&local_conn);
-
-	log_debug(_("standby follow command is:\n  \"%s\""),
-			  config_file_options.follow_command);
 
-	/*
+/*
+ * Heartbeat checks are only meaningful on a standby directly attached to the
+ * primary, as that is the only node whose heartbeats it replays.
+ */
+static bool
+primary_heartbeat_enabled(void)
+{
+	return config_file_options.primary_heartbeat_interval_ms > 0
+		&& upstream_node_info.type == PRIMARY;
+}
+
+
+static void
+reset_primary_heartbeat(void)
+{
+	last_primary_heartbeat_us = 0;
+	primary_heartbeat_baseline_set = false;
+	INSTR_TIME_SET_ZERO(last_primary_heartbeat_change);
+	primary_heartbeat_stale = false;
+	primary_heartbeat_read_failed = false;
+}
+
+
+/*
+ * update_primary_heartbeat_status()
+ *
+ * Read the replayed heartbeat and note when it was last seen to change;
+ * the heartbeat is not considered fresh until it has been seen to advance
+ * after reset_primary_heartbeat().
+ *
+ * Only changes in the value are considered, measured by the local clock,
+ * so clock skew between primary and standby does not affect the result.
+ */
+static void
+update_primary_heartbeat_status(void)
+{
+	int64		heartbeat_us = 0;
+	RecordStatus record_status;
+
+	if (primary_heartbeat_enabled() == false)
+		return;
+
+	if (PQstatus(local_conn) != CONNECTION_OK)
+		return;
+
+	record_status = get_primary_heartbeat(local_conn, upstream_node_info.node_id, &heartbeat_us);
+
+	primary_heartbeat_read_failed = (record_status == RECORD_ERROR);
+
+	if (record_status != RECORD_FOUND)
+		return;
+
+	/*
+	 * The value read first may have been replayed long ago, so it isn't
+	 * evidence that the primary is currently writing heartbeats.
+	 */
+	if (primary_heartbeat_baseline_set == false)
+	{
+		last_primary_heartbeat_us = heartbeat_us;
+		primary_heartbeat_baseline_set = true;
+		return;
+	}
+
+	if (heartbeat_us == last_primary_heartbeat_us)
+		return;
+
+	last_primary_heartbeat_us = heartbeat_us;
+	INSTR_TIME_SET_CURRENT(last_primary_heartbeat_change);
+
+	if (primary_heartbeat_stale == true)
+	{
+		log_notice(_("heartbeat from upstream node \"%s\" (ID: %i) is advancing again"),
+				   upstream_node_info.node_name,
+				   upstream_node_info.node_id);
+		primary_heartbeat_stale = false;
+	}
+}
+
+
+static long
+primary_heartbeat_age_ms(void)
+{
+	instr_time	elapsed;
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, last_primary_heartbeat_change);
+
+	return (long) INSTR_TIME_GET_MILLISEC(elapsed);
+}
+
+
+/*
+ * Determine whether the replayed heartbeat has advanced within
+ * "primary_heartbeat_timeout_ms" (default: three heartbeat intervals).
+ */
+static bool
+primary_heartbeat_is_fresh(void)
+{
+	long		timeout_ms;
+
+	if (primary_heartbeat_enabled() == false)
+		return false;
+
+	if (INSTR_TIME_IS_ZERO(last_primary_heartbeat_change))
+		return false;
+
+	if (config_file_options.primary_heartbeat_timeout_ms >= 0)
+		timeout_ms = config_file_options.primary_heartbeat_timeout_ms;
+	else
+		timeout_ms = (long) config_file_options.primary_heartbeat_interval_ms * 3;
+
+	return primary_heartbeat_age_ms() < timeout_ms;
+}
+
+
+/*
+ * standby_heartbeat_sleep()
+ *
+ * Wait "monitor_interval_secs" between monitoring cycles on a standby; if
+ * heartbeats are enabled, poll the replayed heartbeat while waiting and
+ * return early as soon as it becomes stale, so the upstream connection is
+ * checked straight away rather than at the end of the interval.
+ */
+static void
+standby_heartbeat_sleep(void)
+{
+	instr_time	sleep_start;
+	instr_time	elapsed;
+	long		interval_ms = config_file_options.primary_heartbeat_interval_ms;
+
+	if (primary_heartbeat_enabled() == false)
+	{
+		sleep(config_file_options.monitor_interval_secs);
+		return;
+	}
+
+	INSTR_TIME_SET_CURRENT(sleep_start);
+
+	while (true)
+	{
+		long		remaining_ms;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, sleep_start);
+
+		remaining_ms = (long) config_file_options.monitor_interval_secs * 1000
+			- (long) INSTR_TIME_GET_MILLISEC(elapsed);
+
+		if (remaining_ms <= 0 || got_SIGHUP)
+			break;
+
+		if (primary_heartbeat_read_failed == false)
+			update_primary_heartbeat_status();
+
+		/*
+		 * If the heartbeat can't be read (the error will have been logged,
+		 * possibly by the monitoring cycle itself), don't retry until the
+		 * next monitoring cycle, which will establish whether anything is
+		 * amiss with the local node.
+		 */
+		if (primary_heartbeat_read_failed == true)
+		{
+			pg_usleep(remaining_ms * 1000L);
+			break;
+		}
+
+		/* only return early on the transition to stale, not while it remains so */
+		if (primary_heartbeat_stale == false
+			&& !INSTR_TIME_IS_ZERO(last_primary_heartbeat_change)
+			&& primary_heartbeat_is_fresh() == false)
+		{
+			primary_heartbeat_stale = true;
+
+			log_warning(_("heartbeat from upstream node \"%s\" (ID: %i) has not advanced for %li ms"),
+						upstream_node_info.node_name,
+						upstream_node_info.node_id,
+						primary_heartbeat_age_ms());
+			break;
+		}
+
+		pg_usleep(Min(interval_ms, remaining_ms) * 1000L);
+	}
+}
+
+
+/*
+ * do_upstream_standby_failover()
+ *
+ * Attach cascaded standby to another node, currently the primary.
+ *
+ * Note that in contrast to a primary failover, where one of the downstrean
+ * standby nodes will become a primary, a cascaded standby failover (where the
+ * upstream standby has gone away) is "just" a case of attaching the standby to
+ * another node.
+ *
+ * Currently we will try to attach the node to the cluster primary.
+ *
+ * TODO: As of repmgr 4.3, "repmgr standby follow" supports attaching a standby to another
+ * standby node. We need to provide a selection of reconnection strategies as different
+ * behaviour might be desirable in different situations.
+ */
+
+static bool
+do_upstream_standby_failover(void)
+{
+	t_node_info primary_node_info = T_NODE_INFO_INITIALIZER;
+	RecordStatus record_status = RECORD_NOT_FOUND;
+	RecoveryType primary_type = RECTYPE_UNKNOWN;
+	int			i, standby_follow_result;
+	char		parsed_follow_command[MAXPGPATH] = "";
+
+	close_connection(&upstream_conn);
+
+	/*
+	 *
+	 */
+	if (config_file_options.failover == FAILOVER_MANUAL)
+	{
+		log_notice(_("this node is not configured for automatic failover"));
+		return false;
+	}
+
+	if (get_primary_node_record(local_conn, &primary_node_info) == false)
+	{
+		log_error(_("unable to retrieve primary node record"));
+		return false;
+	}
+
+	/*
+	 * Verify that we can still talk to the cluster primary, even though the
+	 * node's upstream is not available
+	 */
+
+	check_connection(&primary_node_info, &primary_conn);
+
+	if (PQstatus(primary_conn) != CONNECTION_OK)
+	{
+		log_error(_("unable to connect to last known primary \"%s\" (ID: %i)"),
+				  primary_node_info.node_name,
+				  primary_node_info.node_id);
+
+		close_connection(&primary_conn);
+		monitoring_state = MS_DEGRADED;
+		INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
+		return false;
+	}
+
+	primary_type = get_recovery_type(primary_conn);
+
+	if (primary_type != RECTYPE_PRIMARY)
+	{
+		if (primary_type == RECTYPE_STANDBY)
+		{
+			log_error(_("last known primary \"%s\" (ID: %i) is in recovery, not following"),
+					  primary_node_info.node_name,
+					  primary_node_info.node_id);
+		}
+		else
+		{
+			log_error(_("unable to determine status of last known primary \"%s\" (ID: %i), not following"),
+					  primary_node_info.node_name,
+					  primary_node_info.node_id);
+		}
+
+		close_connection(&primary_conn);
+		monitoring_state = MS_DEGRADED;
+		INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
+		return false;
+	}
+
+	/* Close the connection to this server */
+	close_connection(&local_conn);
+
+	log_debug(_("standby follow command is:\n  \"%s\""),
+			  config_file_options.follow_command);
+
+	/*
 	 * replace %n in "config_file_options.follow_command" with ID of primary
 	 * to follow.
 	 */
@@ -3480,6 +3849,9 @@ promote_self(void)
 		termPQExpBuffer(&event_details);
 	}
 
+	/* this node has started a new timeline */
+	reset_timeline_history_cache();
+
 	return FAILOVER_STATE_PROMOTED;
 }
 
@@ -3492,73 +3864,310 @@ promote_self(void)
  * before this node could be promoted, we'll inform the followers they
  * should resume monitoring the original primary.
  */
+/*
+ * Notify the provided standbys to follow the new primary (or to rerun the
+ * election). Notifications, including any reconnections required, are
+ * sent concurrently using non-blocking libpq calls, up to
+ * "sibling_nodes_follow_concurrency" at a time; a node which has not
+ * acknowledged its notification within "sibling_nodes_follow_timeout"
+ * seconds is skipped.
+ */
 static void
 notify_followers(NodeInfoList *standby_nodes, int follow_node_id)
 {
 	NodeInfoListCell *cell;
+	t_follower_notification *notifications = NULL;
+	int			notification_count = 0;
+	int			next_notification = 0;
+	int			active_count = 0;
+	int			completed_count = 0;
+	int			success_count = 0;
+	int			i;
 
 	log_info(_("%i followers to notify"),
 			 standby_nodes->node_count);
 
+	if (standby_nodes->node_count == 0)
+		return;
+
+	notifications = (t_follower_notification *) pg_malloc0(sizeof(t_follower_notification) * standby_nodes->node_count);
+
 	for (cell = standby_nodes->head; cell; cell = cell->next)
 	{
-		log_verbose(LOG_DEBUG, "intending to notify node %i...", cell->node_info->node_id);
+		notifications[notification_count].node_info = cell->node_info;
+		notifications[notification_count].state = NOTIFICATION_PENDING;
+		notification_count++;
+	}
 
-		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
+	while (completed_count < notification_count)
+	{
+		fd_set		read_set;
+		fd_set		write_set;
+		int			max_fd = -1;
+		struct timeval timeout;
+
+		/* start as many notifications as the concurrency limit permits */
+		while (active_count < config_file_options.sibling_nodes_follow_concurrency
+			   && next_notification < notification_count)
 		{
-			log_info(_("reconnecting to node \"%s\" (ID: %i)..."),
-					 cell->node_info->node_name,
-					 cell->node_info->node_id);
+			start_follower_notification(&notifications[next_notification], follow_node_id);
 
-			cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
+			if (notifications[next_notification].state == NOTIFICATION_DONE)
+				completed_count++;
+			else
+				active_count++;
+
+			next_notification++;
 		}
 
-		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
+		FD_ZERO(&read_set);
+		FD_ZERO(&write_set);
+
+		for (i = 0; i < next_notification; i++)
 		{
-			log_warning(_("unable to reconnect to \"%s\" (ID: %i)"),
-						cell->node_info->node_name,
-						cell->node_info->node_id);
-			log_detail("\n%s", PQerrorMessage(cell->node_info->conn));
+			t_follower_notification *notification = &notifications[i];
+			int			sock;
 
-			continue;
+			if (notification->state == NOTIFICATION_DONE)
+				continue;
+
+			sock = PQsocket(notification->node_info->conn);
+
+			if (sock < 0)
+				continue;
+
+			if (notification->state == NOTIFICATION_CONNECTING
+				&& notification->poll_status == PGRES_POLLING_WRITING)
+				FD_SET(sock, &write_set);
+			else
+				FD_SET(sock, &read_set);
+
+			if (sock > max_fd)
+				max_fd = sock;
 		}
 
-		if (follow_node_id == ELECTION_RERUN_NOTIFICATION)
+		timeout.tv_sec = 0;
+		timeout.tv_usec = 100000;
+
+		if (max_fd >= 0 && select(max_fd + 1, &read_set, &write_set, NULL, &timeout) < 0 && errno != EINTR)
 		{
-			log_notice(_("notifying node \"%s\" (ID: %i) to rerun promotion candidate selection"),
-					   cell->node_info->node_name,
-					   cell->node_info->node_id);
+			log_warning(_("notify_followers(): select() returned with error"));
+			log_detail("%s", strerror(errno));
 		}
-		else
+
+		for (i = 0; i < next_notification; i++)
 		{
-			log_notice(_("notifying node \"%s\" (ID: %i) to follow node %i"),
-					   cell->node_info->node_name,
-					   cell->node_info->node_id,
-					   follow_node_id);
+			t_follower_notification *notification = &notifications[i];
+			PGconn	   *conn = notification->node_info->conn;
+
+			if (notification->state == NOTIFICATION_DONE)
+				continue;
+
+			if (notification->state == NOTIFICATION_CONNECTING)
+			{
+				int			sock = PQsocket(conn);
+
+				/* only advance the connection once the socket is ready */
+				if (sock < 0 || FD_ISSET(sock, &read_set) || FD_ISSET(sock, &write_set))
+				{
+					notification->poll_status = PQconnectPoll(conn);
+
+					if (notification->poll_status == PGRES_POLLING_OK)
+					{
+						send_follower_notification(notification, follow_node_id);
+					}
+					else if (notification->poll_status == PGRES_POLLING_FAILED)
+					{
+						log_warning(_("unable to reconnect to \"%s\" (ID: %i)"),
+									notification->node_info->node_name,
+									notification->node_info->node_id);
+						log_detail("\n%s", PQerrorMessage(conn));
+						notification->state = NOTIFICATION_DONE;
+					}
+				}
+			}
+			else if (notification->state == NOTIFICATION_SENT)
+			{
+				if (PQconsumeInput(conn) == 0)
+				{
+					log_warning(_("unable to notify node \"%s\" (ID: %i)"),
+								notification->node_info->node_name,
+								notification->node_info->node_id);
+					log_detail("%s", PQerrorMessage(conn));
+					notification->state = NOTIFICATION_DONE;
+				}
+				else if (PQisBusy(conn) == 0)
+				{
+					PGresult   *res = NULL;
+
+					notification->success = true;
+
+					while ((res = PQgetResult(conn)) != NULL)
+					{
+						if (PQresultStatus(res) != PGRES_TUPLES_OK)
+						{
+							log_warning(_("unable to execute repmgr.notify_follow_primary() on node \"%s\" (ID: %i)"),
+										notification->node_info->node_name,
+										notification->node_info->node_id);
+							log_detail("%s", PQerrorMessage(conn));
+							notification->success = false;
+						}
+						PQclear(res);
+					}
+
+					notification->state = NOTIFICATION_DONE;
+				}
+			}
+
+			if (notification->state != NOTIFICATION_DONE
+				&& calculate_elapsed(notification->start_time) >= config_file_options.sibling_nodes_follow_timeout)
+			{
+				log_warning(_("no response from node \"%s\" (ID: %i) after %i seconds (\"sibling_nodes_follow_timeout\")"),
+							notification->node_info->node_name,
+							notification->node_info->node_id,
+							config_file_options.sibling_nodes_follow_timeout);
+
+				/* the connection is in an indeterminate state, so discard it */
+				PQfinish(conn);
+				notification->node_info->conn = NULL;
+				notification->state = NOTIFICATION_DONE;
+			}
+
+			if (notification->state == NOTIFICATION_DONE)
+			{
+				active_count--;
+				completed_count++;
+
+				if (notification->success == true)
+					success_count++;
+			}
 		}
-		notify_follow_primary(cell->node_info->conn, follow_node_id);
 	}
+
+	pfree(notifications);
+
+	if (success_count < notification_count)
+	{
+		log_warning(_("%i of %i followers notified"),
+					success_count, notification_count);
+	}
+	else
+	{
+		log_info(_("%i followers notified"), success_count);
+	}
+}
+
+
+static void
+start_follower_notification(t_follower_notification *notification, int follow_node_id)
+{
+	t_node_info *node_info = notification->node_info;
+
+	log_verbose(LOG_DEBUG, "intending to notify node %i...", node_info->node_id);
+
+	INSTR_TIME_SET_CURRENT(notification->start_time);
+
+	if (PQstatus(node_info->conn) == CONNECTION_OK)
+	{
+		send_follower_notification(notification, follow_node_id);
+		return;
+	}
+
+	log_info(_("reconnecting to node \"%s\" (ID: %i)..."),
+			 node_info->node_name,
+			 node_info->node_id);
+
+	if (node_info->conn != NULL)
+		PQfinish(node_info->conn);
+
+	node_info->conn = acquire_pooled_connection(node_info);
+
+	if (node_info->conn != NULL)
+	{
+		send_follower_notification(notification, follow_node_id);
+		return;
+	}
+
+	node_info->conn = establish_db_connection_async(node_info->conninfo);
+
+	if (node_info->conn == NULL)
+	{
+		log_warning(_("unable to reconnect to \"%s\" (ID: %i)"),
+					node_info->node_name,
+					node_info->node_id);
+		notification->state = NOTIFICATION_DONE;
+		return;
+	}
+
+	notification->state = NOTIFICATION_CONNECTING;
+	notification->poll_status = PGRES_POLLING_WRITING;
+}
+
+
+static void
+send_follower_notification(t_follower_notification *notification, int follow_node_id)
+{
+	t_node_info *node_info = notification->node_info;
+
+	if (follow_node_id == ELECTION_RERUN_NOTIFICATION)
+	{
+		log_notice(_("notifying node \"%s\" (ID: %i) to rerun promotion candidate selection"),
+				   node_info->node_name,
+				   node_info->node_id);
+	}
+	else
+	{
+		log_notice(_("notifying node \"%s\" (ID: %i) to follow node %i"),
+				   node_info->node_name,
+				   node_info->node_id,
+				   follow_node_id);
+	}
+
+	if (notify_follow_primary_async(node_info->conn, follow_node_id) == false)
+	{
+		notification->state = NOTIFICATION_DONE;
+		return;
+	}
+
+	notification->state = NOTIFICATION_SENT;
 }
 
 
+/*
+ * Wait for the new primary to notify us to follow it. The repmgr extension
+ * sends SIGUSR1 to repmgrd when the notification arrives, so we only need to
+ * check the shared memory state when woken, or once a second in case the
+ * signal could not be sent (e.g. the extension library is an older version).
+ */
 static bool
 wait_primary_notification(int *new_primary_id)
 {
-	int			i;
+	instr_time	start_time;
+	int			elapsed = 0;
+
+	INSTR_TIME_SET_CURRENT(start_time);
 
-	for (i = 0; i < config_file_options.primary_notification_timeout; i++)
+	for (;;)
 	{
+		got_SIGUSR1 = false;
+
 		if (get_new_primary(local_conn, new_primary_id) == true)
 		{
 			log_debug("new primary is %i; elapsed: %i seconds",
-					  *new_primary_id, i);
+					  *new_primary_id, elapsed);
 			return true;
 		}
 
+		elapsed = calculate_elapsed(start_time);
+
+		if (elapsed >= config_file_options.primary_notification_timeout)
+			break;
+
 		log_verbose(LOG_DEBUG, "waiting for new primary notification, %i of max %i seconds (\"primary_notification_timeout\")",
-					i, config_file_options.primary_notification_timeout);
+					elapsed, config_file_options.primary_notification_timeout);
 
-		sleep(1);
+		if (wait_for_sigusr1(1) == true)
+			log_verbose(LOG_DEBUG, "wait_primary_notification(): SIGUSR1 received");
 	}
 
 	log_warning(_("no notification received from new primary after %i seconds"),
@@ -3610,7 +4219,7 @@ follow_new_primary(int new_primary_id)
 		fflush(stderr);
 	}
 
-	upstream_conn = establish_db_connection(new_primary.conninfo, false);
+	upstream_conn = get_pooled_connection(&new_primary, false);
 
 	if (PQstatus(upstream_conn) == CONNECTION_OK)
 	{
@@ -3666,7 +4275,7 @@ follow_new_primary(int new_primary_id)
 		 * be the new primary becoming unavailable just after it's sent notifications
 		 * to its follower nodes, and the old primary becoming available again.
 		 */
-		old_primary_conn = establish_db_connection(failed_primary.conninfo, false);
+		old_primary_conn = get_pooled_connection(&failed_primary, false);
 
 		if (PQstatus(old_primary_conn) == CONNECTION_OK)
 		{
@@ -3691,14 +4300,14 @@ follow_new_primary(int new_primary_id)
 
 				termPQExpBuffer(&event_details);
 
-				close_connection(&old_primary_conn);
+				release_pooled_connection(&failed_primary, &old_primary_conn);
 
 				return FAILOVER_STATE_PRIMARY_REAPPEARED;
 			}
 
 			log_notice(_("original primary reappeared as standby"));
 
-			close_connection(&old_primary_conn);
+			release_pooled_connection(&failed_primary, &old_primary_conn);
 		}
 
 		return FAILOVER_STATE_FOLLOW_FAIL;
@@ -3776,6 +4385,9 @@ follow_new_primary(int new_primary_id)
 		termPQExpBuffer(&event_details);
 	}
 
+	/* the replication topology has changed */
+	reset_timeline_history_cache();
+
 	return FAILOVER_STATE_FOLLOWED_NEW_PRIMARY;
 }
 
@@ -3803,7 +4415,7 @@ witness_follow_new_primary(int new_primary_id)
 		fflush(stderr);
 	}
 
-	upstream_conn = establish_db_connection(new_primary.conninfo, false);
+	upstream_conn = get_pooled_connection(&new_primary, false);
 
 	if (PQstatus(upstream_conn) == CONNECTION_OK)
 	{
@@ -3823,90 +4435,360 @@ witness_follow_new_primary(int new_primary_id)
 				log_warning(_("unable to determine status of new primary"));
 				break;
 		}
-	}
+	}
+
+	if (new_primary_ok == false)
+	{
+		close_connection(&upstream_conn);
+
+		return FAILOVER_STATE_FOLLOW_FAIL;
+	}
+
+	/* set new upstream node ID on primary */
+	update_node_record_set_upstream(upstream_conn, local_node_info.node_id, new_primary_id);
+
+	witness_copy_node_records(upstream_conn, local_conn);
+
+	/*
+	 * refresh local copy of local and primary node records - we get these
+	 * directly from the primary to ensure they're the current version
+	 */
+
+	record_status = get_node_record(upstream_conn, new_primary_id, &upstream_node_info);
+
+	if (record_status != RECORD_FOUND)
+	{
+		log_error(_("unable to retrieve metadata record found for node %i"),
+				  new_primary_id);
+		return FAILOVER_STATE_FOLLOW_FAIL;
+	}
+
+	record_status = get_node_record(upstream_conn, local_node_info.node_id, &local_node_info);
+	if (record_status != RECORD_FOUND)
+	{
+		log_error(_("unable to retrieve metadata record found for node %i"),
+				  local_node_info.node_id);
+		return FAILOVER_STATE_FOLLOW_FAIL;
+	}
+
+	{
+		PQExpBufferData event_details;
+
+		initPQExpBuffer(&event_details);
+		appendPQExpBuffer(&event_details,
+						  _("witness node %i now following new primary node %i"),
+						  local_node_info.node_id,
+						  upstream_node_info.node_id);
+
+		log_notice("%s", event_details.data);
+
+		create_event_notification(upstream_conn,
+								  &config_file_options,
+								  local_node_info.node_id,
+								  "repmgrd_failover_follow",
+								  true,
+								  event_details.data);
+
+		termPQExpBuffer(&event_details);
+	}
+
+	/* the replication topology has changed */
+	reset_timeline_history_cache();
+
+	return FAILOVER_STATE_FOLLOWED_NEW_PRIMARY;
+}
+
+
+static const char *
+_print_election_result(ElectionResult result)
+{
+	switch (result)
+	{
+		case ELECTION_NOT_CANDIDATE:
+			return "NOT CANDIDATE";
+
+		case ELECTION_WON:
+			return "WON";
+
+		case ELECTION_LOST:
+			return "LOST";
+
+		case ELECTION_CANCELLED:
+			return "CANCELLED";
+
+		case ELECTION_RERUN:
+			return "RERUN";
+	}
+
+	/* should never reach here */
+	return "UNKNOWN";
+}
+
+
+static int
+get_primary_visibility_threshold(void)
+{
+	return calculate_primary_visibility_threshold(config_file_options.primary_visibility_threshold,
+												  config_file_options.monitor_interval_secs);
+}
+
+
+/*
+ * Ask all sibling nodes (including the witness, if any) concurrently how
+ * long ago their repmgrd last saw the primary, waiting no longer than
+ * "primary_visibility_consensus_timeout" for the replies.
+ *
+ * Returns the number of nodes which have seen the primary within
+ * "primary_visibility_threshold"; details of these nodes are appended
+ * to "nodes_with_primary_visible".
+ */
+static int
+check_primary_visibility_consensus(NodeInfoList *sibling_nodes, PQExpBufferData *nodes_with_primary_visible)
+{
+	NodeInfoListCell *cell;
+	t_visibility_probe *probes = NULL;
+	int			probe_count = 0;
+	int			completed_count = 0;
+	int			response_count = 0;
+	int			visible_count = 0;
+	int			threshold = get_primary_visibility_threshold();
+	int			i;
+	instr_time	start_time;
+	instr_time	elapsed;
+
+	if (sibling_nodes->node_count == 0)
+		return 0;
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	probes = (t_visibility_probe *) pg_malloc0(sizeof(t_visibility_probe) * sibling_nodes->node_count);
+
+	for (cell = sibling_nodes->head; cell; cell = cell->next)
+	{
+		t_visibility_probe *probe = &probes[probe_count++];
+
+		probe->node_info = cell->node_info;
+
+		/* reuse a pooled connection if available, otherwise connect asynchronously */
+		probe->conn = acquire_pooled_connection(cell->node_info);
+
+		if (probe->conn != NULL)
+		{
+			if (send_upstream_last_seen_ms_query(probe->conn, cell->node_info->type) == true)
+			{
+				probe->state = VISIBILITY_PROBE_SENT;
+				continue;
+			}
+
+			PQfinish(probe->conn);
+		}
+
+		probe->conn = establish_db_connection_async(cell->node_info->conninfo);
+
+		if (probe->conn == NULL)
+		{
+			probe->state = VISIBILITY_PROBE_DONE;
+			completed_count++;
+			continue;
+		}
+
+		probe->state = VISIBILITY_PROBE_CONNECTING;
+		probe->poll_status = PGRES_POLLING_WRITING;
+	}
+
+	while (completed_count < probe_count)
+	{
+		fd_set		read_set;
+		fd_set		write_set;
+		int			max_fd = -1;
+		long		remaining_ms;
+		struct timeval timeout;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+		remaining_ms = (long) config_file_options.primary_visibility_consensus_timeout * 1000
+			- (long) INSTR_TIME_GET_MILLISEC(elapsed);
+
+		if (remaining_ms <= 0)
+			break;
+
+		FD_ZERO(&read_set);
+		FD_ZERO(&write_set);
+
+		for (i = 0; i < probe_count; i++)
+		{
+			int			sock;
+
+			if (probes[i].state == VISIBILITY_PROBE_DONE)
+				continue;
+
+			sock = PQsocket(probes[i].conn);
+
+			if (sock < 0)
+				continue;
+
+			if (probes[i].state == VISIBILITY_PROBE_CONNECTING
+				&& probes[i].poll_status == PGRES_POLLING_WRITING)
+				FD_SET(sock, &write_set);
+			else
+				FD_SET(sock, &read_set);
+
+			if (sock > max_fd)
+				max_fd = sock;
+		}
 
-	if (new_primary_ok == false)
-	{
-		close_connection(&upstream_conn);
+		if (remaining_ms > 100)
+			remaining_ms = 100;
 
-		return FAILOVER_STATE_FOLLOW_FAIL;
-	}
+		timeout.tv_sec = 0;
+		timeout.tv_usec = remaining_ms * 1000;
 
-	/* set new upstream node ID on primary */
-	update_node_record_set_upstream(upstream_conn, local_node_info.node_id, new_primary_id);
+		if (max_fd >= 0 && select(max_fd + 1, &read_set, &write_set, NULL, &timeout) < 0 && errno != EINTR)
+		{
+			log_warning(_("check_primary_visibility_consensus(): select() returned with error"));
+			log_detail("%s", strerror(errno));
+		}
 
-	witness_copy_node_records(upstream_conn, local_conn);
+		for (i = 0; i < probe_count; i++)
+		{
+			t_visibility_probe *probe = &probes[i];
+			int			sock;
 
-	/*
-	 * refresh local copy of local and primary node records - we get these
-	 * directly from the primary to ensure they're the current version
-	 */
+			if (probe->state == VISIBILITY_PROBE_DONE)
+				continue;
 
-	record_status = get_node_record(upstream_conn, new_primary_id, &upstream_node_info);
+			sock = PQsocket(probe->conn);
 
-	if (record_status != RECORD_FOUND)
-	{
-		log_error(_("unable to retrieve metadata record found for node %i"),
-				  new_primary_id);
-		return FAILOVER_STATE_FOLLOW_FAIL;
-	}
+			/* only advance the connection once the socket is ready */
+			if (sock >= 0 && !FD_ISSET(sock, &read_set) && !FD_ISSET(sock, &write_set))
+				continue;
 
-	record_status = get_node_record(upstream_conn, local_node_info.node_id, &local_node_info);
-	if (record_status != RECORD_FOUND)
-	{
-		log_error(_("unable to retrieve metadata record found for node %i"),
-				  local_node_info.node_id);
-		return FAILOVER_STATE_FOLLOW_FAIL;
+			if (probe->state == VISIBILITY_PROBE_CONNECTING)
+			{
+				probe->poll_status = PQconnectPoll(probe->conn);
+
+				if (probe->poll_status == PGRES_POLLING_OK)
+				{
+					if (send_upstream_last_seen_ms_query(probe->conn, probe->node_info->type) == true)
+						probe->state = VISIBILITY_PROBE_SENT;
+					else
+						probe->state = VISIBILITY_PROBE_DONE;
+				}
+				else if (probe->poll_status == PGRES_POLLING_FAILED)
+				{
+					log_warning(_("unable to connect to node \"%s\" (ID: %i)"),
+								probe->node_info->node_name,
+								probe->node_info->node_id);
+					log_detail("\n%s", PQerrorMessage(probe->conn));
+					probe->state = VISIBILITY_PROBE_DONE;
+				}
+			}
+			else if (probe->state == VISIBILITY_PROBE_SENT)
+			{
+				if (PQconsumeInput(probe->conn) == 0)
+				{
+					log_warning(_("unable to retrieve primary visibility from node \"%s\" (ID: %i)"),
+								probe->node_info->node_name,
+								probe->node_info->node_id);
+					log_detail("%s", PQerrorMessage(probe->conn));
+					probe->state = VISIBILITY_PROBE_DONE;
+				}
+				else if (PQisBusy(probe->conn) == 0)
+				{
+					probe->success = get_upstream_last_seen_ms_result(probe->conn,
+																	  &probe->upstream_node_id,
+																	  &probe->upstream_last_seen_ms);
+					probe->state = VISIBILITY_PROBE_DONE;
+				}
+			}
+
+			if (probe->state == VISIBILITY_PROBE_DONE)
+				completed_count++;
+		}
 	}
 
+	for (i = 0; i < probe_count; i++)
 	{
-		PQExpBufferData event_details;
+		t_visibility_probe *probe = &probes[i];
+		PrimaryVisibility visibility;
 
-		initPQExpBuffer(&event_details);
-		appendPQExpBuffer(&event_details,
-						  _("witness node %i now following new primary node %i"),
-						  local_node_info.node_id,
-						  upstream_node_info.node_id);
+		if (probe->success == false)
+		{
+			if (probe->state != VISIBILITY_PROBE_DONE)
+			{
+				log_warning(_("no primary visibility report from node \"%s\" (ID: %i) after %i seconds (\"primary_visibility_consensus_timeout\")"),
+							probe->node_info->node_name,
+							probe->node_info->node_id,
+							config_file_options.primary_visibility_consensus_timeout);
+			}
 
-		log_notice("%s", event_details.data);
+			/* the connection may be in an indeterminate state, so discard it */
+			if (probe->conn != NULL)
+				PQfinish(probe->conn);
 
-		create_event_notification(upstream_conn,
-								  &config_file_options,
-								  local_node_info.node_id,
-								  "repmgrd_failover_follow",
-								  true,
-								  event_details.data);
+			continue;
+		}
 
-		termPQExpBuffer(&event_details);
-	}
+		response_count++;
 
-	return FAILOVER_STATE_FOLLOWED_NEW_PRIMARY;
-}
+		/* hand the connection over for use by the rest of the election */
+		if (probe->node_info->conn == NULL)
+			probe->node_info->conn = probe->conn;
+		else
+			PQfinish(probe->conn);
 
+		visibility = classify_primary_visibility(probe->upstream_last_seen_ms,
+												 probe->upstream_node_id,
+												 upstream_node_info.node_id,
+												 threshold);
 
-static const char *
-_print_election_result(ElectionResult result)
-{
-	switch (result)
-	{
-		case ELECTION_NOT_CANDIDATE:
-			return "NOT CANDIDATE";
+		if (visibility == PRIMARY_NOT_SEEN)
+		{
+			log_info(_("node \"%s\" (ID: %i) last saw primary node %i " INT64_FORMAT " ms ago"),
+					 probe->node_info->node_name,
+					 probe->node_info->node_id,
+					 probe->upstream_node_id,
+					 probe->upstream_last_seen_ms);
+			continue;
+		}
 
-		case ELECTION_WON:
-			return "WON";
+		if (visibility == PRIMARY_SEEN_OTHER_UPSTREAM)
+		{
+			log_warning(_("assumed sibling node %i monitoring different upstream node %i"),
+						probe->node_info->node_id,
+						probe->upstream_node_id);
+			continue;
+		}
 
-		case ELECTION_LOST:
-			return "LOST";
+		visible_count++;
 
-		case ELECTION_CANCELLED:
-			return "CANCELLED";
+		log_notice(_("node \"%s\" (ID: %i) last saw primary node %i " INT64_FORMAT " ms ago, considering primary still visible"),
+				   probe->node_info->node_name,
+				   probe->node_info->node_id,
+				   probe->upstream_node_id,
+				   probe->upstream_last_seen_ms);
 
-		case ELECTION_RERUN:
-			return "RERUN";
+		appendPQExpBuffer(nodes_with_primary_visible,
+						  " - node \"%s\" (ID: %i): " INT64_FORMAT " ms ago\n",
+						  probe->node_info->node_name,
+						  probe->node_info->node_id,
+						  probe->upstream_last_seen_ms);
 	}
 
-	/* should never reach here */
-	return "UNKNOWN";
+	pfree(probes);
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+	log_info(_("%i of %i sibling nodes reported their view of the primary in %.0f ms; %i have seen it within the last %i ms"),
+			 response_count,
+			 probe_count,
+			 INSTR_TIME_GET_MILLISEC(elapsed),
+			 visible_count,
+			 threshold);
+
+	return visible_count;
 }
 
 
@@ -4045,6 +4927,40 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 		}
 	}
 
+	/*
+	 * Before doing anything else, find out whether enough of the other nodes
+	 * can still see the primary; if so there's no point continuing.
+	 */
+	if (config_file_options.primary_visibility_consensus == true)
+	{
+		initPQExpBuffer(&nodes_with_primary_visible);
+
+		nodes_with_primary_still_visible = check_primary_visibility_consensus(sibling_nodes,
+																			  &nodes_with_primary_visible);
+
+		if (nodes_with_primary_still_visible >= config_file_options.primary_visibility_consensus_quorum)
+		{
+			log_notice(_("cancelling failover as %i node(s) can still see the primary (\"primary_visibility_consensus_quorum\": %i)"),
+					   nodes_with_primary_still_visible,
+					   config_file_options.primary_visibility_consensus_quorum);
+			log_detail(_("following nodes can see the primary:\n%s"),
+					   nodes_with_primary_visible.data);
+
+			monitoring_state = MS_DEGRADED;
+			INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
+
+			reset_node_voting_status();
+
+			termPQExpBuffer(&nodes_with_primary_visible);
+
+			return ELECTION_CANCELLED;
+		}
+
+		termPQExpBuffer(&nodes_with_primary_visible);
+
+		nodes_with_primary_still_visible = 0;
+	}
+
 	/* get our lsn */
 	if (get_replication_info(local_conn, STANDBY, &local_replication_info) == false)
 	{
@@ -4079,9 +4995,6 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 
 	log_info(_("local node's last receive lsn: %X/%X"), format_lsn(local_node_info.last_wal_receive_lsn));
 
-	/* pointer to "winning" node, initially self */
-	candidate_node = &local_node_info;
-
 	initPQExpBuffer(&nodes_with_primary_visible);
 
 	for (cell = sibling_nodes->head; cell; cell = cell->next)
@@ -4095,7 +5008,14 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 		/* assume the worst case */
 		cell->node_info->node_status = NODE_STATUS_UNKNOWN;
 
-		cell->node_info->conn = establish_db_connection(cell->node_info->conninfo, false);
+		/* the connection may already have been opened for the visibility check */
+		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
+		{
+			if (cell->node_info->conn != NULL)
+				PQfinish(cell->node_info->conn);
+
+			cell->node_info->conn = get_pooled_connection(cell->node_info, false);
+		}
 
 		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
 		{
@@ -4218,127 +5138,18 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 			}
 		}
 
-		/*
-		 * Check if node has seen primary "recently" - if so, we may have "partial primary visibility".
-		 * For now we'll assume the primary is visible if it's been seen less than
-		 * monitor_interval_secs * 2 seconds ago. We may need to adjust this, and/or make the value
-		 * configurable.
-		 */
-
-		if (sibling_replication_info.upstream_last_seen >= 0 && sibling_replication_info.upstream_last_seen < (config_file_options.monitor_interval_secs * 2))
-		{
-			if (sibling_replication_info.upstream_node_id != upstream_node_info.node_id)
-			{
-				log_warning(_("assumed sibling node %i monitoring different upstream node %i"),
-							cell->node_info->node_id,
-							sibling_replication_info.upstream_node_id);
-
-			}
-			else
-			{
-				nodes_with_primary_still_visible++;
-				log_notice(_("node %i last saw primary node %i second(s) ago, considering primary still visible"),
-						   cell->node_info->node_id,
-						   sibling_replication_info.upstream_last_seen);
-				appendPQExpBuffer(&nodes_with_primary_visible,
-								  " - node \"%s\" (ID: %i): %i second(s) ago\n",
-								  cell->node_info->node_name,
-								  cell->node_info->node_id,
-								  sibling_replication_info.upstream_last_seen);
-			}
-		}
-		else
-		{
-			log_info(_("node %i last saw primary node %i second(s) ago"),
-					 cell->node_info->node_id,
-					 sibling_replication_info.upstream_last_seen);
-		}
-
-
-		/* don't interrogate a witness server */
-		if (cell->node_info->type == WITNESS)
-		{
-			log_debug("node %i is witness, not querying state", cell->node_info->node_id);
-			continue;
-		}
-
-		/* don't check 0-priority nodes */
-		if (cell->node_info->priority <= 0)
-		{
-			log_info(_("node %i has priority of %i, skipping"),
-					   cell->node_info->node_id,
-					   cell->node_info->priority);
-			continue;
-		}
-
-
-		/* get node's last receive LSN - if "higher" than current winner, current node is candidate */
-		cell->node_info->last_wal_receive_lsn = sibling_replication_info.last_wal_receive_lsn;
-
-		log_info(_("last receive LSN for sibling node \"%s\" (ID: %i) is: %X/%X"),
-				 cell->node_info->node_name,
-				 cell->node_info->node_id,
-				 format_lsn(cell->node_info->last_wal_receive_lsn));
-
-		/* compare LSN */
-		if (cell->node_info->last_wal_receive_lsn > candidate_node->last_wal_receive_lsn)
-		{
-			/* other node is ahead */
-			log_info(_("node \"%s\" (ID: %i) is ahead of current candidate \"%s\" (ID: %i)"),
-					 cell->node_info->node_name,
-					 cell->node_info->node_id,
-					 candidate_node->node_name,
-					 candidate_node->node_id);
-
-			candidate_node = cell->node_info;
-		}
-		/* LSN is same - tiebreak on priority, then node_id */
-		else if (cell->node_info->last_wal_receive_lsn == candidate_node->last_wal_receive_lsn)
-		{
-			log_info(_("node \"%s\" (ID: %i) has same LSN as current candidate \"%s\" (ID: %i)"),
-					 cell->node_info->node_name,
-					 cell->node_info->node_id,
-					 candidate_node->node_name,
-					 candidate_node->node_id);
-
-			if (cell->node_info->priority > candidate_node->priority)
-			{
-				log_info(_("node \"%s\" (ID: %i) has higher priority (%i) than current candidate \"%s\" (ID: %i) (%i)"),
-						 cell->node_info->node_name,
-						 cell->node_info->node_id,
-						 cell->node_info->priority,
-						 candidate_node->node_name,
-						 candidate_node->node_id,
-						 candidate_node->priority);
-
-				candidate_node = cell->node_info;
-			}
-			else if (cell->node_info->priority == candidate_node->priority)
-			{
-				if (cell->node_info->node_id < candidate_node->node_id)
-				{
-					log_info(_("node \"%s\" (ID: %i) has same priority but lower node_id than current candidate \"%s\" (ID: %i)"),
-							 cell->node_info->node_name,
-							 cell->node_info->node_id,
-							 candidate_node->node_name,
-							 candidate_node->node_id);
-
-					candidate_node = cell->node_info;
-				}
-			}
-			else
-			{
-				log_info(_("node \"%s\" (ID: %i) has lower priority (%i) than current candidate \"%s\" (ID: %i) (%i)"),
-						 cell->node_info->node_name,
-						 cell->node_info->node_id,
-						 cell->node_info->priority,
-						 candidate_node->node_name,
-						 candidate_node->node_id,
-						 candidate_node->priority);
-			}
-		}
+		/* retain the node's state for select_promotion_candidate() */
+		cell->node_info->replication_info = (ReplInfo *) pg_malloc0(sizeof(ReplInfo));
+		*cell->node_info->replication_info = sibling_replication_info;
 	}
 
+	candidate_node = select_promotion_candidate(&local_node_info,
+												sibling_nodes,
+												upstream_node_info.node_id,
+												get_primary_visibility_threshold(),
+												&nodes_with_primary_still_visible,
+												&nodes_with_primary_visible);
+
 	if (primary_location_seen == false)
 	{
 		log_notice(_("no nodes from the primary location \"%s\" visible - assuming network split"),
@@ -4362,29 +5173,17 @@ do_election(NodeInfoList *sibling_nodes, int *new_primary_id)
 
 		log_detail(_("following nodes can see the primary:\n%s"),
 				   nodes_with_primary_visible.data);
-
-		if (config_file_options.primary_visibility_consensus == true)
-		{
-			log_notice(_("cancelling failover as some nodes can still see the primary"));
-			monitoring_state = MS_DEGRADED;
-			INSTR_TIME_SET_CURRENT(degraded_monitoring_start);
-
-			reset_node_voting_status();
-
-			termPQExpBuffer(&nodes_with_primary_visible);
-
-			return ELECTION_CANCELLED;
-		}
 	}
 
 	termPQExpBuffer(&nodes_with_primary_visible);
 
-	log_info(_("visible nodes: %i; total nodes: %i; no nodes have seen the primary within the last %i seconds"),
-			  visible_nodes,
+	log_info(_("visible nodes: %i; total nodes: %i; %i node(s) have seen the primary within the last %i ms"),
+			 visible_nodes,
 			 total_nodes,
-			 (config_file_options.monitor_interval_secs * 2));
+			 nodes_with_primary_still_visible,
+			 get_primary_visibility_threshold());
 
-	if (visible_nodes <= (total_nodes / 2.0))
+	if (visible_nodes_form_majority(visible_nodes, total_nodes) == false)
 	{
 		log_notice(_("unable to reach a qualified majority of nodes"));
 		log_detail(_("node will enter degraded monitoring state waiting for reconnect"));
@@ -4612,12 +5411,19 @@ format_failover_state(FailoverState failover_state)
 static void
 handle_sighup(PGconn **conn, t_server_type server_type)
 {
+	int			config_reloaded;
+
 	log_debug("SIGHUP received");
 
-	if (reload_config(&config_file_options, server_type))
+	config_reloaded = reload_config(&config_file_options, server_type);
+
+	/* only reconnect if the connection parameters have actually changed */
+	if (config_reloaded & CONFIG_RELOAD_CONNECTION)
 	{
 		PQfinish(*conn);
 		*conn = establish_db_connection(config_file_options.conninfo, true);
+
+		close_connection_pool();
 	}
 
 	if (*config_file_options.log_file)
@@ -4885,6 +5691,8 @@ check_node_can_follow(PGconn *local_conn, XLogRecPtr local_xlogpos, PGconn *foll
 		 * upstream has higher timeline - check where it forked off from this node's timeline
 		 */
 		follow_target_history = get_timeline_history(follow_target_repl_conn,
+													 follow_target_identification.system_identifier,
+													 follow_target_node_info->node_id,
 													 local_identification.timeline + 1);
 
 		if (follow_target_history == NULL)
@@ -4942,44 +5750,111 @@ check_node_can_follow(PGconn *local_conn, XLogRecPtr local_xlogpos, PGconn *foll
 
 
 static void
-check_witness_attached(t_node_info *node_info, bool startup)
+check_witness_attached(t_child_node_status *node, bool startup)
 {
+	t_node_info witness_node_info = T_NODE_INFO_INITIALIZER;
+	PGconn *witness_conn = NULL;
+
+	if (get_node_record(local_conn, node->node_id, &witness_node_info) != RECORD_FOUND)
+	{
+		log_warning(_("unable to retrieve node record for witness node %i"),
+					node->node_id);
+		node->attached = startup == true ? NODE_ATTACHED_UNKNOWN : NODE_DETACHED;
+		return;
+	}
+
 	/*
 	 * connect and check upstream node id; at this point we don't care if it's
 	 * not reachable, only whether we can mark it as attached or not.
 	 */
-	PGconn *witness_conn = establish_db_connection_quiet(node_info->conninfo);
+	witness_conn = get_pooled_connection(&witness_node_info, true);
 
 	if (PQstatus(witness_conn) == CONNECTION_OK)
 	{
 		int witness_upstream_node_id = repmgrd_get_upstream_node_id(witness_conn);
 
 		log_debug("witness node %i's upstream node ID reported as %i",
-				  node_info->node_id,
+				  node->node_id,
 				  witness_upstream_node_id);
 
 		if (witness_upstream_node_id == local_node_info.node_id)
 		{
-			node_info->attached = NODE_ATTACHED;
+			node->attached = NODE_ATTACHED;
 		}
 		else
 		{
-			node_info->attached = NODE_DETACHED;
+			node->attached = NODE_DETACHED;
 		}
 	}
 	else
 	{
-		node_info->attached = startup == true ? NODE_ATTACHED_UNKNOWN : NODE_DETACHED;
+		node->attached = startup == true ? NODE_ATTACHED_UNKNOWN : NODE_DETACHED;
+	}
+
+	release_pooled_connection(&witness_node_info, &witness_conn);
+}
+
+
+/*
+ * Look up a child node in the table's index; returns NULL if not found.
+ */
+static t_child_node_info *
+find_child_node_record(t_child_node_table *nodes, int node_id)
+{
+	int slot;
+
+	if (nodes->node_count == 0)
+		return NULL;
+
+	slot = (unsigned int) node_id & (nodes->index_size - 1);
+
+	while (nodes->index[slot] != -1)
+	{
+		t_child_node_info *node = &nodes->nodes[nodes->index[slot]];
+
+		if (node->node_id == node_id)
+			return node;
+
+		slot = (slot + 1) & (nodes->index_size - 1);
 	}
 
-	PQfinish(witness_conn);
+	return NULL;
 }
 
 
+/*
+ * Add a node to the table, growing it (and rebuilding the index) if
+ * necessary; the returned pointer is valid until the table is next
+ * modified.
+ */
 static t_child_node_info *
-append_child_node_record(t_child_node_info_list *nodes, int node_id, const char *node_name, t_server_type type, NodeAttached attached)
+append_child_node_record(t_child_node_table *nodes, int node_id, const char *node_name, t_server_type type, NodeAttached attached)
 {
-	t_child_node_info *child_node = pg_malloc0(sizeof(t_child_node_info));
+	t_child_node_info *child_node = NULL;
+	int slot;
+
+	if (nodes->node_count == nodes->capacity)
+	{
+		int new_capacity = nodes->capacity == 0 ? CHILD_NODE_TABLE_MIN_CAPACITY : nodes->capacity * 2;
+		int new_index_size = new_capacity * 2;
+		char *storage = pg_malloc0(sizeof(t_child_node_info) * new_capacity + sizeof(int) * new_index_size);
+
+		if (nodes->nodes != NULL)
+		{
+			memcpy(storage, nodes->nodes, sizeof(t_child_node_info) * nodes->node_count);
+			pfree(nodes->nodes);
+		}
+
+		nodes->nodes = (t_child_node_info *) storage;
+		nodes->index = (int *) (storage + sizeof(t_child_node_info) * new_capacity);
+		nodes->index_size = new_index_size;
+		nodes->capacity = new_capacity;
+
+		rebuild_child_node_index(nodes);
+	}
+
+	child_node = &nodes->nodes[nodes->node_count];
+	memset(child_node, 0, sizeof(t_child_node_info));
 
 	child_node->node_id = node_id;
 	snprintf(child_node->node_name, sizeof(child_node->node_name), "%s", node_name);
@@ -4987,77 +5862,85 @@ append_child_node_record(t_child_node_info_list *nodes, int node_id, const char
 	child_node->type = type;
 	child_node->attached = attached;
 
-	if (nodes->tail)
-		nodes->tail->next = child_node;
-	else
-		nodes->head = child_node;
+	slot = (unsigned int) node_id & (nodes->index_size - 1);
 
-	nodes->tail = child_node;
+	while (nodes->index[slot] != -1)
+		slot = (slot + 1) & (nodes->index_size - 1);
+
+	nodes->index[slot] = nodes->node_count;
 	nodes->node_count++;
 
 	return child_node;
 }
 
 
+/*
+ * Remove all nodes whose "seen" flag is not set, compacting the array
+ * in place, then rebuild the index if any nodes were removed.
+ */
 static void
-remove_child_node_record(t_child_node_info_list *nodes, int node_id)
+remove_unseen_child_node_records(t_child_node_table *nodes)
 {
-	t_child_node_info *node;
-	t_child_node_info *prev_node = NULL;
-	t_child_node_info *next_node = NULL;
-
-	node = nodes->head;
+	int i;
+	int kept = 0;
 
-	while (node != NULL)
+	for (i = 0; i < nodes->node_count; i++)
 	{
-		next_node = node->next;
+		t_child_node_info *node = &nodes->nodes[i];
 
-		if (node->node_id == node_id)
-		{
-			/* first node */
-			if (node == nodes->head)
-			{
-				nodes->head = next_node;
-			}
-			/* last node */
-			else if (next_node == NULL)
-			{
-				prev_node->next = NULL;
-			}
-			else
-			{
-				prev_node->next = next_node;
-			}
-			pfree(node);
-			nodes->node_count--;
-			return;
-		}
-		else
+		if (node->seen == false)
 		{
-			prev_node = node;
+			log_notice(_("%s node \"%s\" (ID: %i) is no longer connected or registered"),
+					   get_node_type_string(node->type),
+					   node->node_name,
+					   node->node_id);
+			continue;
 		}
-		node = next_node;
+
+		if (kept != i)
+			nodes->nodes[kept] = *node;
+
+		kept++;
+	}
+
+	if (kept != nodes->node_count)
+	{
+		nodes->node_count = kept;
+		rebuild_child_node_index(nodes);
 	}
 }
 
+
 static void
-clear_child_node_info_list(t_child_node_info_list *nodes)
+rebuild_child_node_index(t_child_node_table *nodes)
 {
-	t_child_node_info *node;
-	t_child_node_info *next_node;
+	int i;
 
-	node = nodes->head;
+	memset(nodes->index, -1, sizeof(int) * nodes->index_size);
 
-	while (node != NULL)
+	for (i = 0; i < nodes->node_count; i++)
 	{
-		next_node = node->next;
-		pfree(node);
-		node = next_node;
+		int slot = (unsigned int) nodes->nodes[i].node_id & (nodes->index_size - 1);
+
+		while (nodes->index[slot] != -1)
+			slot = (slot + 1) & (nodes->index_size - 1);
+
+		nodes->index[slot] = i;
 	}
+}
+
+
+static void
+clear_child_node_table(t_child_node_table *nodes)
+{
+	if (nodes->nodes != NULL)
+		pfree(nodes->nodes);
 
-	nodes->head = NULL;
-	nodes->tail = NULL;
+	nodes->nodes = NULL;
+	nodes->index = NULL;
+	nodes->index_size = 0;
 	nodes->node_count = 0;
+	nodes->capacity = 0;
 }
 
 
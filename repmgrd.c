@@ -20,7 +20,11 @@
 #include <stdio.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <sys/stat.h>
+#ifndef WIN32
+#include <sys/select.h>
+#endif
 
 
 #include "repmgr.h"
@@ -32,6 +36,31 @@
 
 #define OPT_HELP	1
 
+#define RECONNECT_BACKOFF_INITIAL_INTERVAL_MS 250
+#define CONNECTION_POOL_PING_TIMEOUT_MS 1000
+
+/*
+ * Outcome of a failed reconnection attempt made by try_reconnect()
+ */
+typedef enum
+{
+	RECONNECT_REFUSED,
+	RECONNECT_TIMEOUT,
+	RECONNECT_REJECTED
+} ReconnectResult;
+
+/*
+ * Idle connection to another node, kept for reuse by
+ * get_pooled_connection() / acquire_pooled_connection()
+ */
+typedef struct
+{
+	int			node_id;
+	char		conninfo[MAXLEN];
+	PGconn	   *conn;
+	instr_time	released_time;
+} t_pooled_connection;
+
 
 static char *config_file = NULL;
 static bool verbose = false;
@@ -40,6 +69,10 @@ static bool daemonize = true;
 static bool show_pid_file = false;
 static bool no_pid_file = false;
 
+static t_pooled_connection *connection_pool = NULL;
+static int	connection_pool_size = 0;
+static int	connection_pool_count = 0;
+
 t_configuration_options config_file_options = T_CONFIGURATION_OPTIONS_INITIALIZER;
 
 t_node_info local_node_info = T_NODE_INFO_INITIALIZER;
@@ -61,6 +94,12 @@ instr_time	degraded_monitoring_start;
  */
 volatile sig_atomic_t got_SIGHUP = false;
 
+/*
+ * Record receipt of SIGUSR1, which is sent by the repmgr extension when
+ * another node has notified this node to follow a new primary.
+ */
+volatile sig_atomic_t got_SIGUSR1 = false;
+
 static void show_help(void);
 static void show_usage(void);
 static void daemonize_process(void);
@@ -68,6 +107,13 @@ static void check_and_create_pid_file(const char *pid_file);
 
 static void start_monitoring(void);
 
+static PGconn *attempt_reconnection(t_conninfo_param_list *conninfo_params, int connect_timeout, ReconnectResult *result);
+static long calculate_reconnect_interval(int attempt);
+
+static t_pooled_connection *find_pooled_connection(int node_id);
+static void remove_pooled_connection(t_pooled_connection *entry, bool close);
+static bool ping_pooled_connection(PGconn *conn);
+
 
 #ifndef WIN32
 static void setup_event_handlers(void);
@@ -538,13 +584,13 @@ main(int argc, char **argv)
 		check_and_create_pid_file(pid_file);
 	}
 
-	repmgrd_set_pid(local_conn, getpid(), pid_file);
-
-
 #ifndef WIN32
+	/* must be in place before repmgrd registers itself as handling SIGUSR1 */
 	setup_event_handlers();
 #endif
 
+	repmgrd_set_pid(local_conn, getpid(), pid_file);
+
 	start_monitoring();
 
 	logger_shutdown();
@@ -759,10 +805,18 @@ handle_sighup(SIGNAL_ARGS)
 	got_SIGHUP = true;
 }
 
+/* SIGUSR1: new primary notification received, wake up any waiter */
+static void
+handle_sigusr1(SIGNAL_ARGS)
+{
+	got_SIGUSR1 = true;
+}
+
 static void
 setup_event_handlers(void)
 {
 	pqsignal(SIGHUP, handle_sighup);
+	pqsignal(SIGUSR1, handle_sigusr1);
 
 	/*
 	 * we want to be able to write a "repmgrd_shutdown" event, so delegate
@@ -905,6 +959,167 @@ check_upstream_connection(PGconn **conn, const char *conninfo)
 }
 
 
+/*
+ * Make a single, non-blocking connection attempt for try_reconnect(),
+ * returning the connection (which the caller must check with PQstatus()).
+ *
+ * If the attempt fails, "result" is set to distinguish a node which is
+ * definitely down from one which is unreachable due to e.g. a network
+ * interruption. libpq doesn't expose the error which caused the attempt to
+ * fail, and its error messages may be translated, so this is determined
+ * from how far the attempt progressed: if no connection could be made to
+ * the server's socket before "connect_timeout" expired, the connection was
+ * refused (e.g. nothing is listening on the node's address, or the Unix
+ * socket does not exist; an immediate "unreachable" error from the network
+ * can't be distinguished from this); if the server was reached, it
+ * rejected the connection.
+ */
+static PGconn *
+attempt_reconnection(t_conninfo_param_list *conninfo_params, int connect_timeout, ReconnectResult *result)
+{
+	PGconn	   *conn = NULL;
+	PostgresPollingStatusType poll_status = PGRES_POLLING_WRITING;
+	bool		server_reached = false;
+	instr_time	attempt_start;
+	instr_time	elapsed;
+
+	*result = RECONNECT_REJECTED;
+
+	INSTR_TIME_SET_CURRENT(attempt_start);
+
+	conn = PQconnectStartParams((const char **) conninfo_params->keywords,
+								(const char **) conninfo_params->values,
+								true);
+
+	if (conn == NULL)
+		return NULL;
+
+	if (PQstatus(conn) == CONNECTION_BAD)
+		poll_status = PGRES_POLLING_FAILED;
+
+	while (poll_status != PGRES_POLLING_OK && poll_status != PGRES_POLLING_FAILED)
+	{
+		int			sock = PQsocket(conn);
+		long		remaining_ms = -1;
+		fd_set		read_set;
+		fd_set		write_set;
+		struct timeval timeout;
+
+		if (connect_timeout > 0)
+		{
+			INSTR_TIME_SET_CURRENT(elapsed);
+			INSTR_TIME_SUBTRACT(elapsed, attempt_start);
+
+			remaining_ms = (long) connect_timeout * 1000 - (long) INSTR_TIME_GET_MILLISEC(elapsed);
+
+			if (remaining_ms <= 0)
+			{
+				log_error(_("connection to database failed"));
+				log_detail(_("no connection within %i seconds (\"connect_timeout\")"), connect_timeout);
+
+				*result = RECONNECT_TIMEOUT;
+
+				return conn;
+			}
+		}
+
+		/* wait until the socket is ready for libpq to continue */
+		if (sock >= 0)
+		{
+			FD_ZERO(&read_set);
+			FD_ZERO(&write_set);
+
+			if (poll_status == PGRES_POLLING_READING)
+				FD_SET(sock, &read_set);
+			else
+				FD_SET(sock, &write_set);
+
+			timeout.tv_sec = remaining_ms / 1000;
+			timeout.tv_usec = (remaining_ms % 1000) * 1000;
+
+			if (select(sock + 1, &read_set, &write_set, NULL, remaining_ms >= 0 ? &timeout : NULL) < 0
+				&& errno != EINTR)
+			{
+				log_warning(_("attempt_reconnection(): select() returned with error"));
+				log_detail("%s", strerror(errno));
+			}
+		}
+
+		poll_status = PQconnectPoll(conn);
+
+		/*
+		 * Once the socket connection has been made, libpq has moved on to
+		 * exchanging messages with the server.
+		 */
+		switch (PQstatus(conn))
+		{
+			case CONNECTION_STARTED:
+			case CONNECTION_NEEDED:
+			case CONNECTION_BAD:
+				break;
+			default:
+				server_reached = true;
+		}
+	}
+
+	if (poll_status == PGRES_POLLING_FAILED)
+	{
+		log_error(_("connection to database failed"));
+		log_detail("\n%s", PQerrorMessage(conn));
+
+		if (server_reached == false)
+			*result = RECONNECT_REFUSED;
+
+		return conn;
+	}
+
+	/*
+	 * set "synchronous_commit" to "local" in case synchronous replication is
+	 * in use, as establish_db_connection_by_params() does
+	 */
+	(void) set_config(conn, "synchronous_commit", "local");
+
+	return conn;
+}
+
+
+/*
+ * Return the interval (in milliseconds) to wait after the specified
+ * (zero-based) reconnection attempt.
+ */
+static long
+calculate_reconnect_interval(int attempt)
+{
+	static bool random_seeded = false;
+	long		max_interval_ms = (long) config_file_options.reconnect_interval * 1000;
+	long		interval_ms = RECONNECT_BACKOFF_INITIAL_INTERVAL_MS;
+
+	if (config_file_options.reconnect_backoff == RECONNECT_BACKOFF_FIXED)
+		return max_interval_ms;
+
+	while (attempt-- > 0 && interval_ms < max_interval_ms)
+		interval_ms *= 2;
+
+	if (interval_ms > max_interval_ms)
+		interval_ms = max_interval_ms;
+
+	if (random_seeded == false)
+	{
+		srandom((unsigned int) (getpid() ^ time(NULL)));
+		random_seeded = true;
+	}
+
+	/*
+	 * Wait at least half the interval, so nodes which lost their upstream
+	 * at the same time don't all reconnect in lockstep.
+	 */
+	if (interval_ms > 1)
+		interval_ms = interval_ms / 2 + random() % (interval_ms / 2 + 1);
+
+	return interval_ms;
+}
+
+
 void
 try_reconnect(PGconn **conn, t_node_info *node_info)
 {
@@ -914,6 +1129,11 @@ try_reconnect(PGconn **conn, t_node_info *node_info)
 	int			i;
 
 	int			max_attempts = config_file_options.reconnect_attempts;
+	int			attempts_made = 0;
+	int			refused_count = 0;
+	int			connect_timeout = 0;
+	instr_time	reconnect_start;
+	instr_time	elapsed;
 
 	initialize_conninfo_params(&conninfo_params, false);
 
@@ -924,75 +1144,142 @@ try_reconnect(PGconn **conn, t_node_info *node_info)
 	param_set_ine(&conninfo_params, "connect_timeout", "2");
 	param_set_ine(&conninfo_params, "fallback_application_name", "repmgr");
 
+	if (param_get(&conninfo_params, "connect_timeout") != NULL)
+		connect_timeout = atoi(param_get(&conninfo_params, "connect_timeout"));
+
+	INSTR_TIME_SET_CURRENT(reconnect_start);
+
 	for (i = 0; i < max_attempts; i++)
 	{
+		ReconnectResult result;
+		long		interval_ms;
+
+		attempts_made++;
+
 		log_info(_("checking state of node %i, %i of %i attempts"),
 				 node_info->node_id, i + 1, max_attempts);
-		if (is_server_available_params(&conninfo_params) == true)
+
+		/*
+		 * A single connection attempt serves both to check whether the node
+		 * is available, and to provide the new connection.
+		 *
+		 * Note: we could also handle the case where node is reachable but
+		 * connection denied due to connection exhaustion, by falling back to
+		 * degraded monitoring (make configurable)
+		 */
+		our_conn = attempt_reconnection(&conninfo_params, connect_timeout, &result);
+
+		if (PQstatus(our_conn) == CONNECTION_OK)
 		{
-			log_notice(_("node %i has recovered, reconnecting"), node_info->node_id);
+			free_conninfo_params(&conninfo_params);
+
+			log_notice(_("node %i has recovered, reconnected"), node_info->node_id);
 
-			/*
-			 * Note: we could also handle the case where node is pingable but
-			 * connection denied due to connection exhaustion, by falling back to
-			 * degraded monitoring (make configurable)
-			 */
-			our_conn = establish_db_connection_by_params(&conninfo_params, false);
+			/* the node may have been rewound or recloned while unreachable */
+			reset_timeline_history_cache();
 
-			if (PQstatus(our_conn) == CONNECTION_OK)
+			if (PQstatus(*conn) == CONNECTION_BAD)
 			{
-				free_conninfo_params(&conninfo_params);
+				log_verbose(LOG_INFO, _("original connection handle returned CONNECTION_BAD, using new connection"));
+				close_connection(conn);
+				*conn = our_conn;
+			}
+			else
+			{
+				ExecStatusType ping_result;
 
-				log_info(_("connection to node %i succeeded"), node_info->node_id);
+				ping_result = connection_ping(*conn);
 
-				if (PQstatus(*conn) == CONNECTION_BAD)
+				if (ping_result != PGRES_TUPLES_OK)
 				{
-					log_verbose(LOG_INFO, _("original connection handle returned CONNECTION_BAD, using new connection"));
+					log_info(_("original connection no longer available, using new connection"));
 					close_connection(conn);
 					*conn = our_conn;
 				}
 				else
 				{
-					ExecStatusType ping_result;
+					log_info(_("original connection is still available"));
 
-					ping_result = connection_ping(*conn);
+					PQfinish(our_conn);
+				}
+			}
 
-					if (ping_result != PGRES_TUPLES_OK)
-					{
-						log_info(_("original connection no longer available, using new connection"));
-						close_connection(conn);
-						*conn = our_conn;
-					}
-					else
-					{
-						log_info(_("original connection is still available"));
+			node_info->node_status = NODE_STATUS_UP;
 
-						PQfinish(our_conn);
-					}
-				}
+			return;
+		}
 
-				node_info->node_status = NODE_STATUS_UP;
+		close_connection(&our_conn);
 
-				return;
-			}
+		switch (result)
+		{
+			case RECONNECT_REFUSED:
+				log_notice(_("connection to node \"%s\" (ID: %i) refused"),
+						   node_info->node_name,
+						   node_info->node_id);
+				refused_count++;
+				break;
+			case RECONNECT_TIMEOUT:
+				log_notice(_("connection to node \"%s\" (ID: %i) timed out"),
+						   node_info->node_name,
+						   node_info->node_id);
+				refused_count = 0;
+				break;
+			default:
+				log_notice(_("unable to reconnect to node \"%s\" (ID: %i)"),
+						   node_info->node_name,
+						   node_info->node_id);
+				refused_count = 0;
+				break;
+		}
 
-			close_connection(&our_conn);
-			log_notice(_("unable to reconnect to node \"%s\" (ID: %i)"),
-					   node_info->node_name,
-					   node_info->node_id);
+		if (config_file_options.reconnect_refused_attempts > 0
+			&& refused_count >= config_file_options.reconnect_refused_attempts)
+		{
+			log_notice(_("connection to node %i refused %i consecutive times (\"reconnect_refused_attempts\"), not retrying"),
+					   node_info->node_id,
+					   refused_count);
+			break;
 		}
 
-		if (i + 1 < max_attempts)
+		if (i + 1 >= max_attempts)
+			break;
+
+		interval_ms = calculate_reconnect_interval(i);
+
+		if (config_file_options.reconnect_timeout_ms >= 0)
 		{
-			log_info(_("sleeping %i seconds until next reconnection attempt"),
-					 config_file_options.reconnect_interval);
-			sleep(config_file_options.reconnect_interval);
+			long		remaining_ms;
+
+			INSTR_TIME_SET_CURRENT(elapsed);
+			INSTR_TIME_SUBTRACT(elapsed, reconnect_start);
+
+			remaining_ms = config_file_options.reconnect_timeout_ms - (long) INSTR_TIME_GET_MILLISEC(elapsed);
+
+			if (remaining_ms <= 0)
+			{
+				log_notice(_("no reconnection to node %i within %i ms (\"reconnect_timeout_ms\"), not retrying"),
+						   node_info->node_id,
+						   config_file_options.reconnect_timeout_ms);
+				break;
+			}
+
+			if (interval_ms > remaining_ms)
+				interval_ms = remaining_ms;
 		}
+
+		log_info(_("sleeping %li milliseconds until next reconnection attempt"),
+				 interval_ms);
+		pg_usleep(interval_ms * 1000L);
 	}
 
-	log_warning(_("unable to reconnect to node %i after %i attempts"),
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, reconnect_start);
+
+	log_warning(_("unable to reconnect to node %i after %i attempts (%.0f ms)"),
 				node_info->node_id,
-				max_attempts);
+				attempts_made,
+				INSTR_TIME_GET_MILLISEC(elapsed));
 
 	node_info->node_status = NODE_STATUS_DOWN;
 
@@ -1002,6 +1289,293 @@ try_reconnect(PGconn **conn, t_node_info *node_info)
 }
 
 
+/*
+ * Connection pool
+ *
+ * Connections to other nodes which are no longer needed are handed back via
+ * release_pooled_connection() and kept open for up to
+ * "connection_pool_idle_timeout" seconds, so that the next operation needing
+ * to contact the same node (typically a later step in the same failover)
+ * can reuse the connection rather than establishing a new one. Pooled
+ * connections are keyed by node ID and discarded if the node's conninfo
+ * string has changed since the connection was made.
+ *
+ * A connection is only ever held by the pool or by one caller; callers
+ * which acquire a connection must either release it back to the pool, or
+ * close it themselves.
+ */
+
+
+/*
+ * Return a pooled connection to the specified node, or NULL if none is
+ * available. The connection has been checked for errors reported by the
+ * server and for an open transaction, but has not been pinged; callers which
+ * send a query asynchronously and handle failure themselves can use this
+ * directly, otherwise use get_pooled_connection().
+ */
+PGconn *
+acquire_pooled_connection(t_node_info *node_info)
+{
+	t_pooled_connection *entry = NULL;
+	PGconn	   *conn = NULL;
+
+	expire_pooled_connections();
+
+	entry = find_pooled_connection(node_info->node_id);
+
+	if (entry == NULL)
+		return NULL;
+
+	if (strncmp(entry->conninfo, node_info->conninfo, MAXLEN) != 0)
+	{
+		log_verbose(LOG_DEBUG, "conninfo for node %i has changed, discarding pooled connection",
+					node_info->node_id);
+		remove_pooled_connection(entry, true);
+		return NULL;
+	}
+
+	conn = entry->conn;
+	remove_pooled_connection(entry, false);
+
+	if (PQconsumeInput(conn) == 0
+		|| PQstatus(conn) != CONNECTION_OK
+		|| PQtransactionStatus(conn) != PQTRANS_IDLE)
+	{
+		log_verbose(LOG_DEBUG, "pooled connection to node %i is no longer usable",
+					node_info->node_id);
+		PQfinish(conn);
+		return NULL;
+	}
+
+	log_verbose(LOG_DEBUG, "reusing pooled connection to node %i", node_info->node_id);
+
+	return conn;
+}
+
+
+/*
+ * Return a connection to the specified node, reusing a pooled connection if
+ * one is available and responds to a ping, otherwise making a new one.
+ *
+ * As with establish_db_connection(), the caller must check the status of
+ * the returned connection.
+ */
+PGconn *
+get_pooled_connection(t_node_info *node_info, bool quiet)
+{
+	PGconn	   *conn = acquire_pooled_connection(node_info);
+
+	if (conn != NULL)
+	{
+		if (ping_pooled_connection(conn) == true)
+			return conn;
+
+		log_verbose(LOG_DEBUG, "pooled connection to node %i did not respond",
+					node_info->node_id);
+		PQfinish(conn);
+	}
+
+	if (quiet == true)
+		return establish_db_connection_quiet(node_info->conninfo);
+
+	return establish_db_connection(node_info->conninfo, false);
+}
+
+
+/*
+ * Hand a connection to the specified node back to the pool; "conn" is set
+ * to NULL. Connections which are not usable, or which have a transaction in
+ * progress, are closed instead.
+ */
+void
+release_pooled_connection(t_node_info *node_info, PGconn **conn)
+{
+	t_pooled_connection *entry = NULL;
+
+	if (*conn == NULL)
+		return;
+
+	if (config_file_options.connection_pool_idle_timeout <= 0
+		|| PQstatus(*conn) != CONNECTION_OK
+		|| PQtransactionStatus(*conn) != PQTRANS_IDLE)
+	{
+		close_connection(conn);
+		return;
+	}
+
+	entry = find_pooled_connection(node_info->node_id);
+
+	if (entry != NULL)
+	{
+		/* keep the most recently used connection */
+		if (entry->conn != *conn)
+			PQfinish(entry->conn);
+	}
+	else
+	{
+		if (connection_pool_count == connection_pool_size)
+		{
+			connection_pool_size = connection_pool_size == 0 ? 8 : connection_pool_size * 2;
+			connection_pool = (t_pooled_connection *) pg_realloc(connection_pool,
+																 sizeof(t_pooled_connection) * connection_pool_size);
+		}
+
+		entry = &connection_pool[connection_pool_count++];
+	}
+
+	entry->node_id = node_info->node_id;
+	strncpy(entry->conninfo, node_info->conninfo, MAXLEN);
+	entry->conn = *conn;
+	INSTR_TIME_SET_CURRENT(entry->released_time);
+
+	*conn = NULL;
+}
+
+
+/*
+ * Hand any open connections in the provided node list back to the pool;
+ * call before clear_node_info_list() to keep them for reuse.
+ */
+void
+release_node_list_connections(NodeInfoList *nodes)
+{
+	NodeInfoListCell *cell = NULL;
+
+	for (cell = nodes->head; cell; cell = cell->next)
+	{
+		if (cell->node_info->conn != NULL)
+			release_pooled_connection(cell->node_info, &cell->node_info->conn);
+	}
+}
+
+
+/*
+ * Close pooled connections which have been idle for at least
+ * "connection_pool_idle_timeout" seconds. This is called whenever a
+ * connection is acquired from the pool, and once per monitoring cycle so
+ * idle connections are not held open indefinitely while no failover
+ * activity is taking place.
+ */
+void
+expire_pooled_connections(void)
+{
+	int			i = 0;
+
+	while (i < connection_pool_count)
+	{
+		if (calculate_elapsed(connection_pool[i].released_time) >= config_file_options.connection_pool_idle_timeout)
+		{
+			log_verbose(LOG_DEBUG, "closing idle pooled connection to node %i",
+						connection_pool[i].node_id);
+
+			/* the last entry is moved into this slot, so don't advance */
+			remove_pooled_connection(&connection_pool[i], true);
+			continue;
+		}
+
+		i++;
+	}
+}
+
+
+void
+close_connection_pool(void)
+{
+	int			i;
+
+	for (i = 0; i < connection_pool_count; i++)
+		PQfinish(connection_pool[i].conn);
+
+	connection_pool_count = 0;
+}
+
+
+static t_pooled_connection *
+find_pooled_connection(int node_id)
+{
+	int			i;
+
+	for (i = 0; i < connection_pool_count; i++)
+	{
+		if (connection_pool[i].node_id == node_id)
+			return &connection_pool[i];
+	}
+
+	return NULL;
+}
+
+
+static void
+remove_pooled_connection(t_pooled_connection *entry, bool close)
+{
+	if (close == true)
+		PQfinish(entry->conn);
+
+	connection_pool_count--;
+
+	if (entry != &connection_pool[connection_pool_count])
+		*entry = connection_pool[connection_pool_count];
+}
+
+
+/*
+ * Check a pooled connection is still responsive, waiting at most
+ * CONNECTION_POOL_PING_TIMEOUT_MS; unlike connection_ping(), this will not
+ * block indefinitely if the node has silently gone away.
+ */
+static bool
+ping_pooled_connection(PGconn *conn)
+{
+	PGresult   *res = NULL;
+	bool		success = true;
+	instr_time	start_time;
+
+	if (PQsendQuery(conn, "SELECT 1") == 0)
+		return false;
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	while (PQisBusy(conn) == 1)
+	{
+		fd_set		read_set;
+		struct timeval timeout;
+		instr_time	elapsed;
+		long		remaining_ms;
+		int			sock = PQsocket(conn);
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start_time);
+
+		remaining_ms = CONNECTION_POOL_PING_TIMEOUT_MS - (long) INSTR_TIME_GET_MILLISEC(elapsed);
+
+		if (remaining_ms <= 0 || sock < 0)
+			return false;
+
+		FD_ZERO(&read_set);
+		FD_SET(sock, &read_set);
+
+		timeout.tv_sec = remaining_ms / 1000;
+		timeout.tv_usec = (remaining_ms % 1000) * 1000;
+
+		if (select(sock + 1, &read_set, NULL, NULL, &timeout) < 0 && errno != EINTR)
+			return false;
+
+		if (PQconsumeInput(conn) == 0)
+			return false;
+	}
+
+	while ((res = PQgetResult(conn)) != NULL)
+	{
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+			success = false;
+
+		PQclear(res);
+	}
+
+	return success;
+}
+
+
 
 int
 calculate_elapsed(instr_time start_time)
@@ -1016,6 +1590,43 @@ calculate_elapsed(instr_time start_time)
 }
 
 
+/*
+ * Sleep for up to "timeout" seconds, returning early (with "true") if
+ * SIGUSR1 is received. The caller should reset got_SIGUSR1 before checking
+ * whatever condition it's waiting for; SIGUSR1 is blocked while the flag is
+ * checked so a signal arriving just before the sleep won't be missed.
+ */
+bool
+wait_for_sigusr1(int timeout)
+{
+#ifndef WIN32
+	sigset_t	sigusr1_mask;
+	sigset_t	orig_mask;
+	struct timespec ts;
+
+	sigemptyset(&sigusr1_mask);
+	sigaddset(&sigusr1_mask, SIGUSR1);
+
+	sigprocmask(SIG_BLOCK, &sigusr1_mask, &orig_mask);
+
+	if (got_SIGUSR1 == false)
+	{
+		ts.tv_sec = timeout;
+		ts.tv_nsec = 0;
+
+		(void) pselect(0, NULL, NULL, NULL, &ts, &orig_mask);
+	}
+
+	sigprocmask(SIG_SETMASK, &orig_mask, NULL);
+
+	return got_SIGUSR1 ? true : false;
+#else
+	sleep(timeout);
+	return false;
+#endif
+}
+
+
 const char *
 print_monitoring_state(MonitoringState monitoring_state)
 {
@@ -1039,6 +1650,8 @@ terminate(int retval)
 	if (PQstatus(local_conn)  == CONNECTION_OK)
 		repmgrd_set_pid(local_conn, UNKNOWN_PID, NULL);
 
+	close_connection_pool();
+
 	logger_shutdown();
 
 	if (pid_file[0] != '\0')
@@ -14,6 +14,7 @@
 #define OPT_DAEMONIZE                    1001
 
 extern volatile sig_atomic_t got_SIGHUP;
+extern volatile sig_atomic_t got_SIGUSR1;
 extern MonitoringState monitoring_state;
 extern instr_time degraded_monitoring_start;
 
@@ -26,7 +27,15 @@ extern char pid_file[MAXPGPATH];
 bool		check_upstream_connection(PGconn **conn, const char *conninfo);
 void		try_reconnect(PGconn **conn, t_node_info *node_info);
 
+PGconn	   *acquire_pooled_connection(t_node_info *node_info);
+PGconn	   *get_pooled_connection(t_node_info *node_info, bool quiet);
+void		release_pooled_connection(t_node_info *node_info, PGconn **conn);
+void		release_node_list_connections(NodeInfoList *nodes);
+void		expire_pooled_connections(void);
+void		close_connection_pool(void);
+
 int			calculate_elapsed(instr_time start_time);
+bool		wait_for_sigusr1(int timeout);
 const char *print_monitoring_state(MonitoringState monitoring_state);
 
 void		update_registration(PGconn *conn);
@@ -0,0 +1,528 @@
+#!/usr/bin/env bash
+set -u
+set -e
+
+# Failover/switchover timing benchmark
+# ------------------------------------
+#
+# Builds a local cluster of one primary and N standbys (each on its own
+# port, all listening on 127.0.0.1) using "repmgr primary register",
+# "repmgr standby clone" and "repmgr standby register", starts repmgrd on
+# each node, then:
+#
+#  - optionally runs a number of "repmgr standby switchover" rounds
+#  - kills the primary and waits for repmgrd to promote a standby and for
+#    the remaining standbys to follow it
+#
+# Every node's "event_notification_command" appends the event to a shared
+# file together with a millisecond timestamp, so all timings are taken
+# from the same clock.
+#
+# Results are written as JSON Lines (one object per measurement), e.g.:
+#
+#  {"scenario":"failover","iteration":1,"standbys":3,"new_primary":2,
+#   "followers":2,"detection_ms":1012,"confirmed_ms":3530,
+#   "promoted_ms":4410,"followed_ms":6102}
+#
+# All failover times are measured from the moment the primary was killed:
+#
+#  - detection_ms: first standby reports the primary unreachable
+#  - confirmed_ms: the promoted node gives up reconnecting to the primary
+#    (detection plus the time spent in reconnection attempts)
+#  - promoted_ms:  "repmgr standby promote" has completed
+#  - followed_ms:  the last remaining standby has followed the new primary
+#
+# Requirements:
+#
+#  - PostgreSQL server binaries (initdb, pg_ctl, psql etc.) in the
+#    directory given with -B (default: "pg_config --bindir")
+#  - the repmgr extension installed into that PostgreSQL installation
+#    ("make install")
+#  - the repmgr and repmgrd binaries in the directory given with -R
+#  - for switchovers: passwordless SSH to 127.0.0.1 for the current user;
+#    if this is not available, switchovers are skipped
+#
+# Usage: see "failover-benchmark.sh -h"; "make benchmark" runs this script
+# against the binaries in the build directory, passing any options set in
+# BENCHMARK_OPTS.
+
+usage()
+{
+    cat <<EOF
+Usage: $0 [options]
+
+Options:
+  -n STANDBYS      number of standbys (default: $STANDBYS)
+  -i ITERATIONS    number of times to build a cluster and fail it over (default: $ITERATIONS)
+  -s SWITCHOVERS   number of switchover rounds per iteration (default: $SWITCHOVERS)
+  -p PORT          port of the first node; further nodes use consecutive ports (default: $BASE_PORT)
+  -a ATTEMPTS      "reconnect_attempts" for repmgrd (default: $RECONNECT_ATTEMPTS)
+  -t SECONDS       time to wait for each failover/switchover to complete (default: $TIMEOUT)
+  -d DIRECTORY     working directory (default: a temporary directory)
+  -o FILE          write results to FILE (default: standard output)
+  -B DIRECTORY     PostgreSQL binary directory (default: "pg_config --bindir")
+  -R DIRECTORY     directory containing the repmgr and repmgrd binaries (default: ".")
+  -k               keep the working directory (and leave nothing running)
+  -h               show this help
+EOF
+}
+
+STANDBYS=2
+ITERATIONS=1
+SWITCHOVERS=0
+BASE_PORT=5501
+RECONNECT_ATTEMPTS=3
+TIMEOUT=120
+WORKDIR=
+OUTPUT=
+PG_BINDIR=
+REPMGR_BINDIR=.
+KEEP_WORKDIR=0
+
+while getopts "n:i:s:p:a:t:d:o:B:R:kh" opt; do
+    case $opt in
+        n) STANDBYS=$OPTARG ;;
+        i) ITERATIONS=$OPTARG ;;
+        s) SWITCHOVERS=$OPTARG ;;
+        p) BASE_PORT=$OPTARG ;;
+        a) RECONNECT_ATTEMPTS=$OPTARG ;;
+        t) TIMEOUT=$OPTARG ;;
+        d) WORKDIR=$OPTARG ;;
+        o) OUTPUT=$OPTARG ;;
+        B) PG_BINDIR=$OPTARG ;;
+        R) REPMGR_BINDIR=$OPTARG ;;
+        k) KEEP_WORKDIR=1 ;;
+        h) usage; exit 0 ;;
+        *) usage >&2; exit 1 ;;
+    esac
+done
+
+if [ -z "$PG_BINDIR" ]; then
+    PG_BINDIR=$(pg_config --bindir)
+fi
+
+REPMGR_BINDIR=$(cd "$REPMGR_BINDIR" && pwd)
+
+for binary in "$PG_BINDIR/initdb" "$PG_BINDIR/pg_ctl" "$PG_BINDIR/psql" "$REPMGR_BINDIR/repmgr" "$REPMGR_BINDIR/repmgrd"; do
+    if [ ! -x "$binary" ]; then
+        echo "unable to find executable \"$binary\"" >&2
+        exit 1
+    fi
+done
+
+if [ -z "$WORKDIR" ]; then
+    WORKDIR=$(mktemp -d "${TMPDIR:-/tmp}/repmgr-benchmark.XXXXXX")
+else
+    mkdir -p "$WORKDIR"
+    WORKDIR=$(cd "$WORKDIR" && pwd)
+fi
+
+if [ -n "$OUTPUT" ]; then
+    : > "$OUTPUT"
+fi
+
+NODE_COUNT=$((STANDBYS + 1))
+EVENT_LOG="$WORKDIR/events.log"
+
+log()
+{
+    echo "[$(date '+%Y-%m-%d %H:%M:%S')] $*" >&2
+}
+
+report()
+{
+    if [ -n "$OUTPUT" ]; then
+        echo "$1" >> "$OUTPUT"
+    else
+        echo "$1"
+    fi
+}
+
+now_ms()
+{
+    date +%s%3N
+}
+
+node_port()
+{
+    echo $((BASE_PORT + $1 - 1))
+}
+
+node_conf()
+{
+    echo "$WORKDIR/node$1.conf"
+}
+
+node_datadir()
+{
+    echo "$WORKDIR/node$1"
+}
+
+node_psql()
+{
+    local node_id=$1
+    shift
+
+    "$PG_BINDIR/psql" -X -q -A -t -h 127.0.0.1 -p "$(node_port "$node_id")" -U repmgr -d repmgr "$@"
+}
+
+repmgr_cmd()
+{
+    local node_id=$1
+    shift
+
+    "$REPMGR_BINDIR/repmgr" -f "$(node_conf "$node_id")" "$@" >> "$WORKDIR/repmgr.log" 2>&1
+}
+
+# Number of event log lines recorded so far; used to only look at events
+# after a given point
+event_log_offset()
+{
+    if [ -f "$EVENT_LOG" ]; then
+        wc -l < "$EVENT_LOG"
+    else
+        echo 0
+    fi
+}
+
+# Print events recorded after the given offset, optionally only those
+# matching the given event type, as "timestamp node_id event success"
+events_since()
+{
+    local offset=$1
+    local event=${2:-}
+
+    [ -f "$EVENT_LOG" ] || return 0
+
+    if [ -n "$event" ]; then
+        tail -n +$((offset + 1)) "$EVENT_LOG" | awk -v e="$event" '$3 == e'
+    else
+        tail -n +$((offset + 1)) "$EVENT_LOG"
+    fi
+}
+
+count_events_since()
+{
+    events_since "$1" "$2" | awk '$4 == "1"' | wc -l
+}
+
+# Wait until at least "count" successful events of the given type have been
+# recorded after "offset"; returns non-zero on timeout
+wait_for_events()
+{
+    local offset=$1
+    local event=$2
+    local count=$3
+    local start=$SECONDS
+
+    while [ "$(count_events_since "$offset" "$event")" -lt "$count" ]; do
+        if [ $((SECONDS - start)) -ge "$TIMEOUT" ]; then
+            return 1
+        fi
+        sleep 0.1
+    done
+
+    return 0
+}
+
+write_event_script()
+{
+    cat > "$WORKDIR/record-event.sh" <<EOF
+#!/bin/sh
+echo "\$(date +%s%3N) \$1 \$2 \$3" >> "$EVENT_LOG"
+EOF
+    chmod +x "$WORKDIR/record-event.sh"
+}
+
+write_repmgr_conf()
+{
+    local node_id=$1
+    local conf
+    conf=$(node_conf "$node_id")
+
+    cat > "$conf" <<EOF
+node_id=$node_id
+node_name='node$node_id'
+conninfo='host=127.0.0.1 port=$(node_port "$node_id") user=repmgr dbname=repmgr connect_timeout=2'
+data_directory='$(node_datadir "$node_id")'
+pg_bindir='$PG_BINDIR'
+repmgr_bindir='$REPMGR_BINDIR'
+use_replication_slots=yes
+
+log_level=INFO
+log_file='$WORKDIR/node$node_id-repmgrd.log'
+repmgrd_pid_file='$WORKDIR/node$node_id-repmgrd.pid'
+event_notification_command='$WORKDIR/record-event.sh %n %e %s'
+
+failover=automatic
+monitor_interval_secs=1
+reconnect_attempts=$RECONNECT_ATTEMPTS
+reconnect_interval=1
+promote_command='$REPMGR_BINDIR/repmgr standby promote -f $conf --log-to-file'
+follow_command='$REPMGR_BINDIR/repmgr standby follow -f $conf --log-to-file --upstream-node-id=%n'
+ssh_options='-q -o BatchMode=yes -o ConnectTimeout=10'
+EOF
+}
+
+create_primary()
+{
+    local datadir
+    datadir=$(node_datadir 1)
+
+    "$PG_BINDIR/initdb" -D "$datadir" -U postgres -A trust > "$WORKDIR/initdb.log" 2>&1
+
+    cat >> "$datadir/postgresql.conf" <<EOF
+port = $(node_port 1)
+listen_addresses = '127.0.0.1'
+unix_socket_directories = '$WORKDIR'
+wal_level = 'replica'
+max_wal_senders = $((NODE_COUNT + 4))
+max_replication_slots = $((NODE_COUNT + 4))
+hot_standby = on
+wal_log_hints = on
+shared_preload_libraries = 'repmgr'
+logging_collector = on
+EOF
+
+    cat > "$datadir/pg_hba.conf" <<EOF
+local   all             all                     trust
+local   replication     all                     trust
+host    all             all     127.0.0.1/32    trust
+host    replication     all     127.0.0.1/32    trust
+EOF
+
+    "$PG_BINDIR/pg_ctl" -w -D "$datadir" start > /dev/null
+
+    "$PG_BINDIR/psql" -X -q -h 127.0.0.1 -p "$(node_port 1)" -U postgres -d postgres \
+        -c "CREATE USER repmgr SUPERUSER" \
+        -c "CREATE DATABASE repmgr OWNER repmgr"
+
+    repmgr_cmd 1 primary register
+}
+
+create_standby()
+{
+    local node_id=$1
+    local datadir
+    datadir=$(node_datadir "$node_id")
+
+    repmgr_cmd "$node_id" -h 127.0.0.1 -p "$(node_port 1)" -U repmgr -d repmgr standby clone --fast-checkpoint
+
+    # the cloned configuration contains the primary's port
+    echo "port = $(node_port "$node_id")" >> "$datadir/postgresql.conf"
+
+    "$PG_BINDIR/pg_ctl" -w -D "$datadir" start > /dev/null
+
+    repmgr_cmd "$node_id" standby register --wait-sync=$TIMEOUT
+}
+
+start_repmgrd()
+{
+    local node_id=$1
+
+    "$REPMGR_BINDIR/repmgrd" -f "$(node_conf "$node_id")" >> "$WORKDIR/repmgr.log" 2>&1
+}
+
+stop_cluster()
+{
+    local node_id
+    local pid_file
+
+    for node_id in $(seq 1 "$NODE_COUNT"); do
+        pid_file="$WORKDIR/node$node_id-repmgrd.pid"
+
+        if [ -f "$pid_file" ]; then
+            kill "$(cat "$pid_file")" 2>/dev/null || true
+            rm -f "$pid_file"
+        fi
+    done
+
+    for node_id in $(seq 1 "$NODE_COUNT"); do
+        if [ -d "$(node_datadir "$node_id")" ]; then
+            "$PG_BINDIR/pg_ctl" -D "$(node_datadir "$node_id")" -m immediate stop > /dev/null 2>&1 || true
+        fi
+    done
+}
+
+cleanup()
+{
+    stop_cluster
+
+    if [ "$KEEP_WORKDIR" -eq 0 ]; then
+        rm -rf "$WORKDIR"
+    else
+        log "working directory kept at \"$WORKDIR\""
+    fi
+}
+
+trap cleanup EXIT
+
+build_cluster()
+{
+    local node_id
+    local offset
+
+    stop_cluster
+
+    for node_id in $(seq 1 "$NODE_COUNT"); do
+        rm -rf "$(node_datadir "$node_id")" "$WORKDIR/node$node_id-repmgrd.log"
+        write_repmgr_conf "$node_id"
+    done
+
+    rm -f "$EVENT_LOG"
+    write_event_script
+
+    log "creating primary (port $(node_port 1))"
+    create_primary
+
+    for node_id in $(seq 2 "$NODE_COUNT"); do
+        log "creating standby node$node_id (port $(node_port "$node_id"))"
+        create_standby "$node_id"
+    done
+
+    offset=$(event_log_offset)
+
+    for node_id in $(seq 1 "$NODE_COUNT"); do
+        start_repmgrd "$node_id"
+    done
+
+    if ! wait_for_events "$offset" repmgrd_start "$NODE_COUNT"; then
+        log "repmgrd did not start on all nodes within $TIMEOUT seconds"
+        exit 1
+    fi
+}
+
+# Print the ID of the node which is currently the primary
+current_primary()
+{
+    local node_id
+
+    for node_id in $(seq 1 "$NODE_COUNT"); do
+        if [ "$(node_psql "$node_id" -c "SELECT pg_catalog.pg_is_in_recovery()" 2>/dev/null)" = "f" ]; then
+            echo "$node_id"
+            return 0
+        fi
+    done
+
+    return 1
+}
+
+ssh_available()
+{
+    ssh -q -o BatchMode=yes -o ConnectTimeout=5 127.0.0.1 true > /dev/null 2>&1
+}
+
+run_switchover()
+{
+    local iteration=$1
+    local round=$2
+    local primary_id
+    local candidate_id
+    local offset
+    local start_ms
+    local end_ms
+    local result=ok
+
+    primary_id=$(current_primary)
+    candidate_id=$((primary_id % NODE_COUNT + 1))
+
+    log "switchover $round: node$primary_id -> node$candidate_id"
+
+    offset=$(event_log_offset)
+    start_ms=$(now_ms)
+
+    if ! repmgr_cmd "$candidate_id" standby switchover --siblings-follow; then
+        result=failed
+    elif ! wait_for_events "$offset" standby_switchover 1; then
+        result=timeout
+    fi
+
+    end_ms=$(now_ms)
+
+    # let repmgrd on all nodes settle on the new primary
+    sleep 2
+
+    report "{\"scenario\":\"switchover\",\"iteration\":$iteration,\"round\":$round,\"standbys\":$STANDBYS,\"former_primary\":$primary_id,\"new_primary\":$candidate_id,\"result\":\"$result\",\"duration_ms\":$((end_ms - start_ms))}"
+}
+
+run_failover()
+{
+    local iteration=$1
+    local primary_id
+    local offset
+    local kill_ms
+    local result=ok
+    local new_primary=null
+    local followers=0
+    local detection_ms=null
+    local confirmed_ms=null
+    local promoted_ms=null
+    local followed_ms=null
+    local ts
+    local reconnect_ms
+
+    primary_id=$(current_primary)
+
+    log "failover: stopping primary node$primary_id"
+
+    offset=$(event_log_offset)
+    kill_ms=$(now_ms)
+
+    "$PG_BINDIR/pg_ctl" -D "$(node_datadir "$primary_id")" -m immediate stop > /dev/null
+
+    # repmgrd on the former primary would otherwise try to restart monitoring
+    kill "$(cat "$WORKDIR/node$primary_id-repmgrd.pid")" 2>/dev/null || true
+
+    if ! wait_for_events "$offset" repmgrd_failover_promote 1; then
+        result=timeout
+    elif ! wait_for_events "$offset" repmgrd_failover_follow $((STANDBYS - 1)); then
+        result=timeout
+    fi
+
+    ts=$(events_since "$offset" repmgrd_upstream_disconnect | sort -n | awk 'NR == 1 { print $1 }')
+    [ -n "$ts" ] && detection_ms=$((ts - kill_ms))
+
+    new_primary=$(events_since "$offset" repmgrd_failover_promote | awk '$4 == "1" { print $2; exit }')
+
+    if [ -n "$new_primary" ]; then
+        ts=$(events_since "$offset" standby_promote | awk -v n="$new_primary" '$2 == n && $4 == "1" { print $1; exit }')
+        [ -n "$ts" ] && promoted_ms=$((ts - kill_ms))
+
+        # time the promoted node spent trying to reconnect to the primary
+        reconnect_ms=$(sed -n 's/.*unable to reconnect to node [0-9]* after [0-9]* attempts (\([0-9]*\) ms).*/\1/p' \
+                           "$WORKDIR/node$new_primary-repmgrd.log" | tail -n 1)
+
+        ts=$(events_since "$offset" repmgrd_upstream_disconnect | awk -v n="$new_primary" '$2 == n { print $1; exit }')
+
+        if [ -n "$ts" ] && [ -n "$reconnect_ms" ]; then
+            confirmed_ms=$((ts - kill_ms + reconnect_ms))
+        fi
+    else
+        new_primary=null
+    fi
+
+    followers=$(count_events_since "$offset" repmgrd_failover_follow)
+
+    ts=$(events_since "$offset" repmgrd_failover_follow | awk '$4 == "1"' | sort -n | awk 'END { print $1 }')
+    [ -n "$ts" ] && followed_ms=$((ts - kill_ms))
+
+    report "{\"scenario\":\"failover\",\"iteration\":$iteration,\"standbys\":$STANDBYS,\"former_primary\":$primary_id,\"new_primary\":$new_primary,\"result\":\"$result\",\"followers\":$followers,\"detection_ms\":$detection_ms,\"confirmed_ms\":$confirmed_ms,\"promoted_ms\":$promoted_ms,\"followed_ms\":$followed_ms}"
+}
+
+
+if [ "$SWITCHOVERS" -gt 0 ] && ! ssh_available; then
+    log "passwordless SSH to 127.0.0.1 not available, skipping switchovers"
+    report "{\"scenario\":\"switchover\",\"result\":\"skipped\"}"
+    SWITCHOVERS=0
+fi
+
+for iteration in $(seq 1 "$ITERATIONS"); do
+    log "iteration $iteration of $ITERATIONS: building cluster with $STANDBYS standbys in \"$WORKDIR\""
+    build_cluster
+
+    for round in $(seq 1 "$SWITCHOVERS"); do
+        run_switchover "$iteration" "$round"
+    done
+
+    run_failover "$iteration"
+done
@@ -10,6 +10,10 @@ CREATE EXTENSION repmgr;
 SELECT * FROM repmgr.nodes;
 SELECT * FROM repmgr.events;
 SELECT * FROM repmgr.monitoring_history;
+SELECT * FROM repmgr.monitoring_latest;
+SELECT * FROM repmgr.monitoring_history_minute;
+SELECT * FROM repmgr.monitoring_history_hour;
+SELECT * FROM repmgr.primary_heartbeat;
 
 -- views
 
@@ -20,11 +24,73 @@ SELECT * FROM repmgr.show_nodes;
 SELECT repmgr.am_bdr_failover_handler(-1);
 SELECT repmgr.am_bdr_failover_handler(NULL);
 SELECT repmgr.get_new_primary();
+SELECT repmgr.get_upstream_last_seen_ms();
 SELECT repmgr.notify_follow_primary(-1);
 SELECT repmgr.notify_follow_primary(NULL);
 SELECT repmgr.reset_voting_status();
 SELECT repmgr.set_local_node_id(-1);
 SELECT repmgr.set_local_node_id(NULL);
+SELECT repmgr.set_repmgrd_wakeup_signal(TRUE);
 SELECT repmgr.standby_get_last_updated();
 SELECT repmgr.standby_set_last_updated();
 SELECT repmgr.unset_bdr_failover_handler();
+
+-- monitoring records and rollups
+SET timezone = 'UTC';
+SET datestyle = 'ISO, MDY';
+
+INSERT INTO repmgr.nodes (node_id, upstream_node_id, node_name, type, conninfo, repluser, config_file)
+     VALUES (1, NULL, 'node1', 'primary', 'host=node1', 'repmgr', '/etc/repmgr.conf'),
+            (2, 1, 'node2', 'standby', 'host=node2', 'repmgr', '/etc/repmgr.conf'),
+            (3, 1, 'node3', 'standby', 'host=node3', 'repmgr', '/etc/repmgr.conf');
+
+-- LSNs are passed as untyped literals, as by repmgrd
+SELECT repmgr.add_monitoring_record(1, 2, '2019-01-01 10:00:10+00', '2019-01-01 10:00:10+00', '0/30000A0', '0/3000000', 160, 0);
+SELECT repmgr.add_monitoring_record(1, 3, '2019-01-01 10:00:20+00', '2019-01-01 10:00:20+00', '0/30003E8', '0/3000000', 1000, 500);
+SELECT repmgr.add_monitoring_record(1, 2, '2019-01-01 10:00:40+00', '2019-01-01 10:00:40+00', '0/3000140', '0/3000000', 320, 96);
+SELECT repmgr.add_monitoring_record(1, 2, '2019-01-01 10:01:10+00', '2019-01-01 10:01:10+00', '0/3000140', '0/3000140', 0, 0);
+SELECT repmgr.add_monitoring_record(1, 2, '2019-01-01 11:00:05+00', '2019-01-01 11:00:05+00', '0/3000180', '0/3000140', 64, 32);
+
+SELECT standby_node_id, count(*) FROM repmgr.monitoring_history GROUP BY 1 ORDER BY 1;
+SELECT * FROM repmgr.monitoring_latest ORDER BY standby_node_id;
+SELECT primary_node_id, standby_node_id, standby_name, node_type, active,
+       last_monitor_time, last_wal_primary_location, last_wal_standby_location,
+       replication_lag, apply_lag
+  FROM repmgr.replication_status
+ ORDER BY standby_node_id;
+
+-- percentiles are not selected, as they are not calculated before PostgreSQL 9.4
+SELECT repmgr.update_monitoring_rollups();
+
+SELECT standby_node_id, bucket_start, sample_count,
+       replication_lag_min, replication_lag_avg, replication_lag_max,
+       apply_lag_min, apply_lag_avg, apply_lag_max
+  FROM repmgr.monitoring_history_minute
+ ORDER BY standby_node_id, bucket_start;
+SELECT standby_node_id, bucket_start, sample_count,
+       replication_lag_min, replication_lag_avg, replication_lag_max,
+       apply_lag_min, apply_lag_avg, apply_lag_max
+  FROM repmgr.monitoring_history_hour
+ ORDER BY standby_node_id, bucket_start;
+
+-- rerunning the rollups only adds buckets which have not yet been summarised
+SELECT repmgr.add_monitoring_record(1, 2, '2019-01-01 11:05:00+00', '2019-01-01 11:05:00+00', '0/3000180', '0/3000180', 0, 0);
+SELECT repmgr.update_monitoring_rollups();
+
+SELECT standby_node_id, bucket_start, sample_count
+  FROM repmgr.monitoring_history_minute
+ ORDER BY standby_node_id, bucket_start;
+SELECT standby_node_id, bucket_start, sample_count
+  FROM repmgr.monitoring_history_hour
+ ORDER BY standby_node_id, bucket_start;
+
+-- records are only deleted once their hour has been summarised
+SELECT repmgr.add_monitoring_record(1, 3, '2019-01-01 12:30:00+00', '2019-01-01 12:30:00+00', '0/3000400', '0/3000400', 0, 0);
+
+SELECT repmgr.get_monitoring_records_to_delete(36500, NULL);
+SELECT repmgr.get_monitoring_records_to_delete(1, NULL);
+SELECT repmgr.get_monitoring_records_to_delete(1, 3);
+SELECT repmgr.delete_monitoring_records(1, 3);
+SELECT repmgr.delete_monitoring_records(1, NULL);
+
+SELECT standby_node_id, last_monitor_time FROM repmgr.monitoring_history ORDER BY 1, 2;
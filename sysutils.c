@@ -19,9 +19,23 @@
 
 #include <signal.h>
 
+#include "portability/instr_time.h"
+
 #include "repmgr.h"
 
+/* bounds for the interval between WAL receiver state checks */
+#define WALRECEIVER_CHECK_MIN_INTERVAL_MS 10
+#define WALRECEIVER_CHECK_MAX_INTERVAL_MS 250
+
+/*
+ * time to check for a new WAL receiver after one has been killed, if
+ * "wal_retrieve_retry_interval" had already been raised
+ */
+#define WALRECEIVER_RESTART_SETTLE_MS 500
+
 static bool _local_command(const char *command, PQExpBufferData *outputbuf, bool simple, int *return_value);
+static long calculate_elapsed_ms(instr_time start_time);
+static void wait_interval_ms(long *interval_ms);
 
 
 /*
@@ -106,6 +120,30 @@ _local_command(const char *command, PQExpBufferData *outputbuf, bool simple, int
 }
 
 
+/*
+ * Build the shell command which executes "command" via ssh on the remote
+ * host, for callers which need to run it themselves rather than via
+ * remote_command().
+ */
+void
+make_remote_command(const char *host, const char *user, const char *command, const char *ssh_options, PQExpBufferData *ssh_command)
+{
+	appendPQExpBuffer(ssh_command,
+					  "ssh -o Batchmode=yes %s ",
+					  ssh_options);
+
+	if (*user != '\0')
+	{
+		appendPQExpBuffer(ssh_command, "%s@", user);
+	}
+
+	appendPQExpBuffer(ssh_command,
+					  "%s %s",
+					  host,
+					  command);
+}
+
+
 /*
  * Execute a command via ssh on the remote host.
  *
@@ -115,38 +153,27 @@ bool
 remote_command(const char *host, const char *user, const char *command, const char *ssh_options, PQExpBufferData *outputbuf)
 {
 	FILE	   *fp;
-	char		ssh_command[MAXLEN] = "";
-	PQExpBufferData ssh_host;
+	PQExpBufferData ssh_command;
 
 	char		output[MAXLEN] = "";
 
-	initPQExpBuffer(&ssh_host);
-
-	if (*user != '\0')
-	{
-		appendPQExpBuffer(&ssh_host, "%s@", user);
-	}
+	initPQExpBuffer(&ssh_command);
 
-	appendPQExpBufferStr(&ssh_host, host);
+	make_remote_command(host, user, command, ssh_options, &ssh_command);
 
-	maxlen_snprintf(ssh_command,
-					"ssh -o Batchmode=yes %s %s %s",
-					ssh_options,
-					ssh_host.data,
-					command);
+	log_debug("remote_command():\n  %s", ssh_command.data);
 
-	termPQExpBuffer(&ssh_host);
-
-	log_debug("remote_command():\n  %s", ssh_command);
-
-	fp = popen(ssh_command, "r");
+	fp = popen(ssh_command.data, "r");
 
 	if (fp == NULL)
 	{
-		log_error(_("unable to execute remote command:\n  %s"), ssh_command);
+		log_error(_("unable to execute remote command:\n  %s"), ssh_command.data);
+		termPQExpBuffer(&ssh_command);
 		return false;
 	}
 
+	termPQExpBuffer(&ssh_command);
+
 	if (outputbuf != NULL)
 	{
 		/* TODO: better error handling */
@@ -180,15 +207,32 @@ remote_command(const char *host, const char *user, const char *command, const ch
 }
 
 
+/*
+ * Disable the local WAL receiver by setting "wal_retrieve_retry_interval"
+ * to a very high value, then terminating the WAL receiver.
+ *
+ * Rather than sleeping for fixed intervals, each step is checked at
+ * short intervals (increased after each unsuccessful check) until it has
+ * completed or "timeout" seconds have elapsed in total.
+ *
+ * Until the startup process has read the new "wal_retrieve_retry_interval"
+ * value (which can't be observed directly), it will start a new WAL receiver
+ * once the previous interval has elapsed; so after killing the WAL receiver,
+ * keep checking for (and killing) new ones until none has been running for
+ * longer than the previous interval, or "timeout" has been reached.
+ *
+ * Returns the PID of any WAL receiver still running (0 if none).
+ */
 pid_t
-disable_wal_receiver(PGconn *conn)
+disable_wal_receiver(PGconn *conn, int timeout)
 {
 	char buf[MAXLEN];
 	int wal_retrieve_retry_interval, new_wal_retrieve_retry_interval;
 	pid_t wal_receiver_pid = UNKNOWN_PID;
-	int kill_ret;
-	int i, j;
-	int max_retries = 2;
+	instr_time start_time;
+	instr_time last_running_time;
+	long interval_ms;
+	long restart_settle_ms = WALRECEIVER_RESTART_SETTLE_MS;
 
 	if (is_superuser_connection(conn, NULL) == false)
 	{
@@ -203,6 +247,8 @@ disable_wal_receiver(PGconn *conn)
 		return UNKNOWN_PID;
 	}
 
+	INSTR_TIME_SET_CURRENT(start_time);
+
 	wal_receiver_pid = (pid_t)get_wal_receiver_pid(conn);
 
 	if (wal_receiver_pid == UNKNOWN_PID)
@@ -224,6 +270,8 @@ disable_wal_receiver(PGconn *conn)
 				   new_wal_retrieve_retry_interval);
 		alter_system_int(conn, "wal_retrieve_retry_interval", new_wal_retrieve_retry_interval);
 		pg_reload_conf(conn);
+
+		restart_settle_ms = wal_retrieve_retry_interval + WALRECEIVER_CHECK_MAX_INTERVAL_MS;
 	}
 
 	/*
@@ -236,54 +284,83 @@ disable_wal_receiver(PGconn *conn)
 		return UNKNOWN_PID;
 	}
 
+	/*
+	 * Kill the WAL receiver, then keep checking for a new one as described
+	 * above. Additionally, for reasons as yet unclear, after a server
+	 * start/restart, immediately after the first time a WAL receiver is
+	 * killed, a new one is started straight away, so we'll need to kill that
+	 * too.
+	 */
+	INSTR_TIME_SET_CURRENT(last_running_time);
+	interval_ms = WALRECEIVER_CHECK_MIN_INTERVAL_MS;
 
-	/* why 5? */
-	log_info(_("sleeping 5 seconds"));
-	sleep(5);
-
-	/* see comment below as to why we need a loop here */
-	for (i = 0; i < max_retries; i++)
+	while (calculate_elapsed_ms(start_time) < timeout * 1000L)
 	{
-		log_notice(_("killing WAL receiver with PID %i"), (int)wal_receiver_pid);
+		if (wal_receiver_pid > 0)
+		{
+			log_notice(_("killing WAL receiver with PID %i"), (int)wal_receiver_pid);
 
-		kill((int)wal_receiver_pid, SIGTERM);
+			kill((int)wal_receiver_pid, SIGTERM);
 
-		for (j = 0; j < 30; j++)
-		{
-			kill_ret = kill(wal_receiver_pid, 0);
+			interval_ms = WALRECEIVER_CHECK_MIN_INTERVAL_MS;
 
-			if (kill_ret != 0)
+			while (calculate_elapsed_ms(start_time) < timeout * 1000L)
 			{
-				log_info(_("WAL receiver with pid %i killed"), (int)wal_receiver_pid);
-				break;
+				if (kill(wal_receiver_pid, 0) != 0)
+				{
+					log_info(_("WAL receiver with pid %i killed"), (int)wal_receiver_pid);
+					break;
+				}
+
+				wait_interval_ms(&interval_ms);
 			}
-			sleep(1);
+
+			INSTR_TIME_SET_CURRENT(last_running_time);
+			interval_ms = WALRECEIVER_CHECK_MIN_INTERVAL_MS;
+		}
+		else if (calculate_elapsed_ms(last_running_time) >= restart_settle_ms)
+		{
+			break;
+		}
+		else
+		{
+			wait_interval_ms(&interval_ms);
 		}
 
-		/*
-		 * Wait briefly to check that the WAL receiver has indeed gone away -
-		 * for reasons as yet unclear, after a server start/restart, immediately
-		 * after the first time a WAL receiver is killed, a new one is started
-		 * straight away, so we'll need to kill that too.
-		 */
-		sleep(1);
 		wal_receiver_pid = (pid_t)get_wal_receiver_pid(conn);
-		if (wal_receiver_pid == UNKNOWN_PID || wal_receiver_pid == 0)
+
+		if (wal_receiver_pid == UNKNOWN_PID)
 			break;
 	}
 
+	if (wal_receiver_pid > 0)
+	{
+		log_warning(_("WAL receiver with PID %i still running after %i seconds"),
+					(int)wal_receiver_pid, timeout);
+	}
+	else
+	{
+		log_info(_("WAL receiver disabled after %.2f seconds"),
+				 (double) calculate_elapsed_ms(start_time) / 1000);
+	}
+
 	return wal_receiver_pid;
 }
 
+
+/*
+ * Re-enable the local WAL receiver by resetting "wal_retrieve_retry_interval";
+ * if "wait_startup" is true, wait up to "timeout" seconds for the WAL
+ * receiver to start.
+ */
 pid_t
-enable_wal_receiver(PGconn *conn, bool wait_startup)
+enable_wal_receiver(PGconn *conn, bool wait_startup, int timeout)
 {
 	char buf[MAXLEN];
 	int wal_retrieve_retry_interval;
 	pid_t wal_receiver_pid = UNKNOWN_PID;
-
-	/* make timeout configurable */
-	int i, timeout = 30;
+	instr_time start_time;
+	long interval_ms = WALRECEIVER_CHECK_MIN_INTERVAL_MS;
 
 	if (is_superuser_connection(conn, NULL) == false)
 	{
@@ -337,16 +414,22 @@ enable_wal_receiver(PGconn *conn, bool wait_startup)
 	if (wait_startup == false)
 		return UNKNOWN_PID;
 
-	for (i = 0; i < timeout; i++)
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	log_info(_("waiting up to %i seconds for WAL receiver to start up"),
+			 timeout);
+
+	for (;;)
 	{
 		wal_receiver_pid = (pid_t)get_wal_receiver_pid(conn);
 
-		if (wal_receiver_pid > 0)
+		if (wal_receiver_pid != 0)
+			break;
+
+		if (calculate_elapsed_ms(start_time) >= timeout * 1000L)
 			break;
 
-		log_info(_("sleeping %i of maximum %i seconds waiting for WAL receiver to start up"),
-				 i + 1, timeout)
-		sleep(1);
+		wait_interval_ms(&interval_ms);
 	}
 
 	if (wal_receiver_pid == UNKNOWN_PID)
@@ -360,7 +443,40 @@ enable_wal_receiver(PGconn *conn, bool wait_startup)
 		return UNKNOWN_PID;
 	}
 
-	log_info(_("WAL receiver started up with PID %i"), (int)wal_receiver_pid);
+	log_info(_("WAL receiver started up with PID %i after %.2f seconds"),
+			 (int)wal_receiver_pid,
+			 (double) calculate_elapsed_ms(start_time) / 1000);
 
 	return wal_receiver_pid;
 }
+
+
+/*
+ * Return the number of milliseconds elapsed since "start_time".
+ */
+static long
+calculate_elapsed_ms(instr_time start_time)
+{
+	instr_time	current_time;
+
+	INSTR_TIME_SET_CURRENT(current_time);
+	INSTR_TIME_SUBTRACT(current_time, start_time);
+
+	return (long) INSTR_TIME_GET_MILLISEC(current_time);
+}
+
+
+/*
+ * Sleep for "interval_ms" milliseconds, then double the interval for the
+ * next call, up to WALRECEIVER_CHECK_MAX_INTERVAL_MS.
+ */
+static void
+wait_interval_ms(long *interval_ms)
+{
+	pg_usleep(*interval_ms * 1000L);
+
+	*interval_ms *= 2;
+
+	if (*interval_ms > WALRECEIVER_CHECK_MAX_INTERVAL_MS)
+		*interval_ms = WALRECEIVER_CHECK_MAX_INTERVAL_MS;
+}
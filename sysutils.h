@@ -23,10 +23,11 @@ extern bool local_command(const char *command, PQExpBufferData *outputbuf);
 extern bool local_command_return_value(const char *command, PQExpBufferData *outputbuf, int *return_value);
 extern bool local_command_simple(const char *command, PQExpBufferData *outputbuf);
 
+extern void make_remote_command(const char *host, const char *user, const char *command, const char *ssh_options, PQExpBufferData *ssh_command);
 extern bool remote_command(const char *host, const char *user, const char *command, const char *ssh_options, PQExpBufferData *outputbuf);
 
-extern pid_t disable_wal_receiver(PGconn *conn);
-extern pid_t enable_wal_receiver(PGconn *conn, bool wait_startup);
+extern pid_t disable_wal_receiver(PGconn *conn, int timeout);
+extern pid_t enable_wal_receiver(PGconn *conn, bool wait_startup, int timeout);
 
 
 #endif							/* _SYSUTILS_H_ */